@@ -0,0 +1,91 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file alloc_count.cpp Counting of the memory allocations of the benchmark program. */
+
+#include "../stdafx.h"
+#include "bench.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64> _allocation_count(0); ///< Number of memory allocations with \c new.
+static std::atomic<uint64> _allocated_bytes(0);  ///< Number of bytes allocated with \c new.
+
+/**
+ * Allocate memory, and count the allocation.
+ * @param size Number of bytes to allocate.
+ * @return The allocated memory, or \c nullptr if it could not be allocated.
+ */
+static void *CountedAllocate(size_t size)
+{
+	_allocation_count++;
+	_allocated_bytes += size;
+	return malloc(size == 0 ? 1 : size);
+}
+
+/**
+ * Get the number of memory allocations with \c new since the start of the program.
+ * @return Number of allocations. Memory allocated with \c malloc by libraries is not counted.
+ */
+uint64 GetAllocationCount()
+{
+	return _allocation_count;
+}
+
+/**
+ * Get the number of bytes allocated with \c new since the start of the program.
+ * @return Number of allocated bytes, freed memory is not subtracted.
+ */
+uint64 GetAllocatedBytes()
+{
+	return _allocated_bytes;
+}
+
+void *operator new(size_t size)
+{
+	void *p = CountedAllocate(size);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size)
+{
+	void *p = CountedAllocate(size);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+	return CountedAllocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+	return CountedAllocate(size);
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+	free(p);
+}
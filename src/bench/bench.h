@@ -0,0 +1,33 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file bench.h Benchmarks of the benchmark program. */
+
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+
+#include "../path.h"
+
+uint64 GetAllocationCount();
+uint64 GetAllocatedBytes();
+
+PathType GetBenchPathType();
+void BuildBenchPark(int size, int guest_count);
+void ClearBenchPark();
+
+bool RunLoadBenchmark();
+bool RunBlitBenchmark(int iterations);
+bool RunSaveBenchmark(int size, int guest_count, int iterations);
+bool RunPathBenchmark(int size, int queries);
+bool RunThreadBenchmark(int size, int guest_count, int iterations, int worker_count);
+bool RunGuestBenchmark(int size, int guest_count, int iterations);
+bool RunCollectBenchmark(int size, int guest_count, int iterations);
+bool RunCoasterBenchmark(int size, int iterations);
+bool RunTerraformBenchmark(int size, int iterations);
+bool RunVoxelBenchmark(int size, int guest_count, int iterations);
+
+#endif
@@ -0,0 +1,197 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file bench_main.cpp Main program of the benchmark program. */
+
+#include "../stdafx.h"
+#include "../palette.h"
+#include "../rcdfile.h"
+#include "../sprite_data.h"
+#include "../sprite_store.h"
+#include "../language.h"
+#include "../getoptdata.h"
+#include "../fileio.h"
+#include "../jobs.h"
+#include "../math_func.h"
+#include "../map.h"
+#include "../gamecontrol.h"
+#include "bench.h"
+
+/** Command-line options of the benchmark program. */
+static const OptionData _options[] = {
+	GETOPT_NOVAL('h', "--help"),
+	GETOPT_NOVAL('l', "--load"),
+	GETOPT_NOVAL('b', "--blit"),
+	GETOPT_NOVAL('s', "--save"),
+	GETOPT_NOVAL('p', "--path"),
+	GETOPT_NOVAL('t', "--threads"),
+	GETOPT_NOVAL('u', "--guests"),
+	GETOPT_NOVAL('c', "--collect"),
+	GETOPT_NOVAL('r', "--trains"),
+	GETOPT_NOVAL('f', "--terraform"),
+	GETOPT_NOVAL('v', "--voxels"),
+	GETOPT_VALUE('i', "--iterations"),
+	GETOPT_VALUE('w', "--world-size"),
+	GETOPT_VALUE('g', "--guest-count"),
+	GETOPT_VALUE('k', "--workers"),
+	GETOPT_END()
+};
+
+/** Output command-line help. */
+static void PrintUsage()
+{
+	printf("Usage: freerct-bench [options]\n");
+	printf("Options:\n");
+	printf("  -h, --help         Display this help text and exit\n");
+	printf("  -l, --load         Measure loading the RCD files at startup, with '--workers' worker threads\n");
+	printf("  -b, --blit         Measure drawing all sprites of the RCD files with the available blitters\n");
+	printf("  -s, --save         Measure saving and loading a generated park at several compression levels\n");
+	printf("  -p, --path         Measure searching paths between random points of a generated maze (1000 searches per iteration)\n");
+	printf("  -t, --threads      Check that updating guests at worker threads gives the same game as without workers (100 ticks per iteration)\n");
+	printf("  -u, --guests       Measure updating the guests of a generated park each frame, against the %u ms of a frame (100 frames per iteration)\n", FRAME_DELAY);
+	printf("  -c, --collect      Measure collecting and sorting the sprites of a full screen view of a generated park\n");
+	printf("  -r, --trains       Measure moving the trains of roller coasters with long tracks around a generated world (100 frames per iteration)\n");
+	printf("  -f, --terraform    Measure raising and lowering a 64 x 64 area of a generated world 20 steps each way (one cycle per iteration)\n");
+	printf("  -v, --voxels       Measure the memory of the voxels of a generated park, getting voxels, searching paths (1000 searches per iteration), and collecting a view with and without guests\n");
+	printf("  -i, --iterations   Number of times to repeat each measurement (default 20)\n");
+	printf("  -w, --world-size   Length of the sides of the park of '--save', '--threads', '--guests', '--collect' and '--voxels', the maze of '--path', the coaster tracks of '--trains', and the world of '--terraform' (default 128)\n");
+	printf("  -g, --guest-count  Number of guests in the park of '--save', '--threads', '--guests', '--collect' and '--voxels' (default 5000)\n");
+	printf("  -k, --workers      Number of worker threads of '--threads' and '--load', 0 runs all jobs at the main thread (default one less than the number of processors, at least 1)\n");
+}
+
+/**
+ * Main entry point of the benchmark program.
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @return The exit code of the program.
+ */
+int main(int argc, char **argv)
+{
+	GetOptData opt_data(argc - 1, argv + 1, _options);
+
+	bool load = false;
+	bool blit = false;
+	bool save = false;
+	bool path = false;
+	bool threads = false;
+	bool guests = false;
+	bool collect = false;
+	bool trains = false;
+	bool terraform = false;
+	bool voxels = false;
+	int iterations = 20;
+	int world_size = 128;
+	int guest_count = 5000;
+	int worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	int opt_id;
+	do {
+		opt_id = opt_data.GetOpt();
+		switch (opt_id) {
+			case 'h':
+				PrintUsage();
+				return 0;
+
+			case 'l':
+				load = true;
+				break;
+
+			case 'b':
+				blit = true;
+				break;
+
+			case 's':
+				save = true;
+				break;
+
+			case 'p':
+				path = true;
+				break;
+
+			case 't':
+				threads = true;
+				break;
+
+			case 'u':
+				guests = true;
+				break;
+
+			case 'c':
+				collect = true;
+				break;
+
+			case 'r':
+				trains = true;
+				break;
+
+			case 'f':
+				terraform = true;
+				break;
+
+			case 'v':
+				voxels = true;
+				break;
+
+			case 'i':
+				iterations = std::max(1, atoi(opt_data.opt));
+				break;
+
+			case 'w':
+				world_size = Clamp(atoi(opt_data.opt), 16, WORLD_X_SIZE);
+				break;
+
+			case 'g':
+				guest_count = std::max(0, atoi(opt_data.opt));
+				break;
+
+			case 'k':
+				worker_count = std::max(0, atoi(opt_data.opt));
+				break;
+
+			case -1:
+				break;
+
+			default:
+				/* -2 or some other weird thing happened. */
+				fprintf(stderr, "ERROR while processing the command-line\n");
+				return 1;
+		}
+	} while (opt_id != -1);
+
+	if (!load && !blit && !save && !path && !threads && !guests && !collect && !trains && !terraform && !voxels) {
+		PrintUsage();
+		return 1;
+	}
+
+	ChangeWorkingDirectoryToExecutable(argv[0]);
+	_job_pool.Initialize(load ? worker_count : -1);
+
+	/* Load RCD files, the same way as the game does. */
+	bool success = true;
+	InitImageStorage();
+	if (load) {
+		success &= RunLoadBenchmark();
+	} else {
+		_rcd_collection.ScanDirectories();
+		_sprite_manager.LoadRcdFiles();
+	}
+	InitLanguage();
+
+	if (blit) success &= RunBlitBenchmark(iterations);
+	if (save) success &= RunSaveBenchmark(world_size, guest_count, iterations);
+	if (path) success &= RunPathBenchmark(world_size, iterations * 1000);
+	if (threads) success &= RunThreadBenchmark(world_size, guest_count, iterations, worker_count);
+	if (guests) success &= RunGuestBenchmark(world_size, guest_count, iterations);
+	if (collect) success &= RunCollectBenchmark(world_size, guest_count, iterations);
+	if (trains) success &= RunCoasterBenchmark(world_size, iterations);
+	if (terraform) success &= RunTerraformBenchmark(world_size, iterations);
+	if (voxels) success &= RunVoxelBenchmark(world_size, guest_count, iterations);
+
+	_job_pool.Shutdown();
+	UninitLanguage();
+	DestroyImageStorage();
+	return success ? 0 : 1;
+}
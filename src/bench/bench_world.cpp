@@ -0,0 +1,74 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file bench_world.cpp Worlds built by the benchmarks. */
+
+#include "../stdafx.h"
+#include "../map.h"
+#include "../path.h"
+#include "../path_build.h"
+#include "../sprite_store.h"
+#include "../person.h"
+#include "../people.h"
+#include "../gamecontrol.h"
+#include "../gamelevel.h"
+#include "../dates.h"
+#include "../weather.h"
+#include "../finances.h"
+#include "bench.h"
+
+/**
+ * Get the path type to build paths with. Only paths with graphics connect to their neighbours, and can be loaded in the game.
+ * @return The first path type with graphics.
+ */
+PathType GetBenchPathType()
+{
+	for (int pt = PAT_WOOD; pt < PAT_COUNT; pt++) {
+		if (_sprite_manager.GetPathStatus((PathType)pt) == PAS_NORMAL_PATH) return (PathType)pt;
+	}
+	return PAT_WOOD;
+}
+
+/**
+ * Build a flat park with a grid of paths, and fill it with walking guests.
+ * @param size Length of the sides of the world.
+ * @param guest_count Number of guests to add.
+ */
+void BuildBenchPark(int size, int guest_count)
+{
+	_world.SetWorldSize(size, size);
+	_world.MakeFlatWorld(8);
+	_world.SetTileOwnerGlobally(OWN_PARK);
+
+	PathType path_type = GetBenchPathType();
+
+	/* Paths along every fourth row and column inside the world, with a single entrance at the edge. */
+	for (int x = 1; x < size - 1; x++) {
+		for (int y = 1; y < size - 1; y++) {
+			if (x % 4 == 1 || y % 4 == 1) BuildFlatPath(XYZPoint16(x, y, 8), path_type, false);
+		}
+	}
+	BuildFlatPath(XYZPoint16(0, 1, 8), path_type, false);
+
+	_finances_manager.SetScenario(_scenario);
+	_date.Initialize();
+	_weather.Initialize();
+	_game_mode_mgr.SetGameMode(GM_PLAY);
+
+	for (int i = 0; i < guest_count; i++) {
+		if (!_guests.SpawnGuest()) break;
+	}
+	/* Let the guests walk into the park. Many guests leave the park again in their first day. */
+	for (int frame = 0; frame < 50; frame++) OnNewFrame(FRAME_DELAY);
+}
+
+/** Remove the park built by #BuildBenchPark. */
+void ClearBenchPark()
+{
+	_guests.Uninitialize();
+	_game_mode_mgr.SetGameMode(GM_NONE);
+}
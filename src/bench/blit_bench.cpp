@@ -0,0 +1,147 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file blit_bench.cpp Benchmark of drawing sprites. */
+
+#include "../stdafx.h"
+#include "../palette.h"
+#include "../sprite_data.h"
+#include "../video.h"
+#include "bench.h"
+#include <chrono>
+
+/** Setting of the video system to measure. */
+struct BlitterSetting {
+	const char *name;   ///< Name of the setting.
+	bool simd_blitting; ///< Value of VideoSystem::simd_blitting.
+	bool cache_sprites; ///< Value of VideoSystem::cache_sprites.
+};
+
+/** Settings of the video system to measure, they must all produce the same image. */
+static const BlitterSetting _blitter_settings[] = {
+	{"scalar",         false, false},
+	{"simd",           true,  false},
+	{"scalar, cached", false, true},
+	{"simd, cached",   true,  true},
+};
+
+/** Gradient shifts to draw the sprites with. */
+static const GradientShift _bench_shifts[] = {GS_NORMAL, GS_DARK, GS_LIGHT, GS_SEMI_TRANSPARENT};
+
+/**
+ * Fill the buffer with an opaque pattern, the video system always draws at an opaque background.
+ * @param buffer Pixels to fill.
+ */
+static void FillBackground(std::vector<uint32> *buffer)
+{
+	for (size_t i = 0; i < buffer->size(); i++) (*buffer)[i] = MakeRGBA(i & 0xFF, (i >> 8) & 0xFF, 0x80, OPAQUE);
+}
+
+/**
+ * Draw all sprites, each at a position inside the buffer and at a position partly outside the buffer.
+ * Every sprite is drawn a number of times before moving to the next sprite, like a frame draws the same sprites many times.
+ * @param width Width of the buffer.
+ * @param height Height of the buffer.
+ * @param recolour Recolouring of the sprites.
+ * @param iterations Number of times to draw each sprite at each position.
+ * @param[out] blits Number of drawn sprites.
+ * @return Number of drawn pixels.
+ */
+static uint64 DrawAllSprites(int width, int height, const Recolouring &recolour, int iterations, uint64 *blits)
+{
+	uint64 pixels = 0;
+	*blits = 0;
+	for (uint i = 0; i < GetImageCount(); i++) {
+		const ImageData *spr = GetImage(i);
+		if (spr->width == 0 || spr->height == 0) continue;
+
+		for (GradientShift shift : _bench_shifts) {
+			for (int it = 0; it < iterations; it++) {
+				/* Completely inside the buffer. */
+				_video.BlitImage({(width - spr->width) / 2 - spr->xoffset, (height - spr->height) / 2 - spr->yoffset}, spr, recolour, shift);
+				/* Clipped at the top-left corner of the buffer. */
+				_video.BlitImage({-spr->width / 2 - spr->xoffset, -spr->height / 2 - spr->yoffset}, spr, recolour, shift);
+			}
+			pixels += (uint64)iterations * (spr->width * spr->height + (spr->width - spr->width / 2) * (spr->height - spr->height / 2));
+			*blits += 2 * iterations;
+		}
+	}
+	return pixels;
+}
+
+/**
+ * Compute a checksum of the pixels.
+ * @param buffer Pixels to summarize.
+ * @return Checksum of the pixels.
+ */
+static uint64 Checksum(const std::vector<uint32> &buffer)
+{
+	uint64 sum = 0;
+	for (uint32 pixel : buffer) sum = sum * 31 + pixel;
+	return sum;
+}
+
+/**
+ * Measure drawing all loaded sprites with the available blitter settings.
+ * @param iterations Number of times to draw each sprite at each position for each setting.
+ * @return Whether the settings that should produce the same image did so.
+ */
+bool RunBlitBenchmark(int iterations)
+{
+	int width = 64;
+	int height = 64;
+	for (uint i = 0; i < GetImageCount(); i++) {
+		width = std::max<int>(width, GetImage(i)->width + 2);
+		height = std::max<int>(height, GetImage(i)->height + 2);
+	}
+	width = std::min(width, 4096);
+	height = std::min(height, 4096);
+
+	Recolouring recolour;
+	recolour.Set(0, RecolourEntry(COL_RANGE_GREY, COL_RANGE_RED));
+
+	printf("Drawing %u sprites in a %d x %d buffer, %d iterations.\n", GetImageCount(), width, height, iterations);
+	printf("%-16s %12s %12s %10s\n", "Setting", "ns/sprite", "Mpixel/s", "Checksum");
+
+	bool old_simd_blitting = _video.simd_blitting;
+	bool old_cache_sprites = _video.cache_sprites;
+	std::vector<uint32> buffer(width * height);
+	bool success = true;
+	uint64 first_checksum = 0;
+	for (uint s = 0; s < lengthof(_blitter_settings); s++) {
+		const BlitterSetting &setting = _blitter_settings[s];
+		_video.simd_blitting = setting.simd_blitting;
+		_video.cache_sprites = setting.cache_sprites;
+		_video.ClearSpriteCache();
+		_video.SetClippedRectangle(ClippedRectangle(buffer.data(), width, height));
+
+		FillBackground(&buffer);
+		uint64 blits;
+		auto start = std::chrono::steady_clock::now();
+		uint64 pixels = DrawAllSprites(width, height, recolour, iterations, &blits);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		uint64 checksum = Checksum(buffer);
+
+		printf("%-16s %12.1f %12.1f %10llx\n", setting.name, seconds * 1e9 / blits, pixels / seconds / 1e6, (unsigned long long)(checksum & 0xFFFFFFFFFFull));
+
+		if (s == 0) {
+			first_checksum = checksum;
+		} else if (checksum != first_checksum) {
+			fprintf(stderr, "ERROR: Setting \"%s\" draws a different image than setting \"%s\"\n", setting.name, _blitter_settings[0].name);
+			success = false;
+		}
+	}
+
+	const SpriteCache &cache = _video.GetSpriteCache();
+	printf("Sprite cache of the cached settings: %llu hits, %llu misses, %llu evictions.\n",
+			(unsigned long long)cache.hits, (unsigned long long)cache.misses, (unsigned long long)cache.evictions);
+
+	_video.ClearSpriteCache();
+	_video.simd_blitting = old_simd_blitting;
+	_video.cache_sprites = old_cache_sprites;
+	return success;
+}
@@ -0,0 +1,181 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file coaster_bench.cpp Benchmark of moving the trains of roller coasters. */
+
+#include "../stdafx.h"
+#include "../map.h"
+#include "../ride_type.h"
+#include "../coaster.h"
+#include "../track_piece.h"
+#include "../gamecontrol.h"
+#include "bench.h"
+#include <chrono>
+
+static const int COASTER_COUNT = 8;      ///< Number of roller coasters to build.
+static const int COASTER_SPACING = 6;    ///< Difference in height between the tracks of two roller coasters.
+static const int TRACK_HEIGHT = 8;       ///< Height of the track of the lowest roller coaster, and of the ground.
+static const int CAR_COUNT = 12;         ///< Number of cars of each train.
+static const int FRAMES_PER_ITERATION = 100; ///< Number of frames to run for each iteration.
+
+/* Connection codes of the track pieces in the RCD files, for each direction of the track. */
+static const uint8 CONNECT_FLAT = 0; ///< First connection code of flat track.
+static const uint8 CONNECT_UP   = 4; ///< First connection code of track going up.
+static const uint8 CONNECT_DOWN = 8; ///< First connection code of track going down.
+
+/**
+ * Find a track piece of a roller coaster type.
+ * @param ct Coaster type to search.
+ * @param entry Entry connection code of the piece.
+ * @param exit Exit connection code of the piece.
+ * @param powered Whether the piece should have power.
+ * @param start Whether the piece should be a starting piece.
+ * @return The first matching track piece, or \c nullptr if there is none.
+ */
+static ConstTrackPiecePtr FindTrackPiece(const CoasterType *ct, uint8 entry, uint8 exit, bool powered = false, bool start = false)
+{
+	for (const ConstTrackPiecePtr &piece : ct->pieces) {
+		if (piece->entry_connect != entry || piece->exit_connect != exit) continue;
+		if (piece->HasPower() != powered || piece->IsStartingPiece() != start) continue;
+		if (!start && piece->HasPlatform()) continue;
+		return piece;
+	}
+	return nullptr;
+}
+
+/**
+ * Build a roller coaster with a square loop of track. Every side of the square has hills, and the loop turns right at the corners.
+ * @param ct Type of the roller coaster.
+ * @param hill_count Number of hills at each side of the square.
+ * @param height Height of the flat parts of the track.
+ * @return The roller coaster, or \c nullptr if it could not be built.
+ */
+static CoasterInstance *BuildLoopedCoaster(const CoasterType *ct, int hill_count, int height)
+{
+	uint16 number = _rides_manager.GetFreeInstance(ct);
+	if (number == INVALID_RIDE_INSTANCE) return nullptr;
+	CoasterInstance *ci = static_cast<CoasterInstance *>(_rides_manager.CreateInstance(ct, number));
+	_rides_manager.NewInstanceAdded(number);
+
+	/* The first side goes in the direction of connection code 0 (negative X), towards the first column of the world. */
+	XYZPoint16 pos(8 * hill_count + 2, 1, height);
+	for (uint8 side = 0; side < 4; side++) {
+		std::vector<ConstTrackPiecePtr> pieces;
+		pieces.push_back(FindTrackPiece(ct, CONNECT_FLAT + side, CONNECT_FLAT + side, false, side == 0));
+		for (int hill = 0; hill < hill_count; hill++) {
+			pieces.push_back(FindTrackPiece(ct, CONNECT_FLAT + side, CONNECT_UP + side, true));
+			pieces.push_back(FindTrackPiece(ct, CONNECT_UP + side, CONNECT_UP + side, true));
+			pieces.push_back(FindTrackPiece(ct, CONNECT_UP + side, CONNECT_FLAT + side, true));
+			pieces.push_back(FindTrackPiece(ct, CONNECT_FLAT + side, CONNECT_FLAT + side));
+			pieces.push_back(FindTrackPiece(ct, CONNECT_FLAT + side, CONNECT_DOWN + side));
+			pieces.push_back(FindTrackPiece(ct, CONNECT_DOWN + side, CONNECT_DOWN + side));
+			pieces.push_back(FindTrackPiece(ct, CONNECT_DOWN + side, CONNECT_FLAT + side));
+			pieces.push_back(FindTrackPiece(ct, CONNECT_FLAT + side, CONNECT_FLAT + side));
+		}
+		pieces.push_back(FindTrackPiece(ct, CONNECT_FLAT + side, CONNECT_FLAT + (side + 1) % 4)); // Turn right.
+
+		for (const ConstTrackPiecePtr &piece : pieces) {
+			if (piece == nullptr) return ci;
+			PositionedTrackPiece ptp(pos, piece);
+			if (!ptp.CanBePlaced() || ci->AddPositionedPiece(ptp) < 0) return ci;
+			ci->PlaceTrackPieceInWorld(ptp);
+			pos = ptp.GetEndXYZ();
+		}
+	}
+	return ci;
+}
+
+/**
+ * Put trains with cars at a roller coaster, spread evenly over the track, and give them some speed.
+ * The number of trains and cars is not limited by the coaster type, to get many cars with the coaster types that exist.
+ * @param ci Roller coaster with a looping track.
+ */
+static void AddTrains(CoasterInstance *ci)
+{
+	for (uint i = 0; i < lengthof(ci->trains); i++) {
+		CoasterTrain &train = ci->trains[i];
+		train.SetLength(CAR_COUNT);
+		train.back_position = ci->coaster_length / lengthof(ci->trains) * i;
+		train.speed = 65536 / 1000; // Minimal speed at powered track pieces.
+		train.cur_piece = ci->FindPieceAt(train.back_position);
+	}
+}
+
+/**
+ * Measure moving trains with many cars along long roller coaster tracks with hills.
+ * @param size Length of the sides of the world, the track of each roller coaster goes around the world.
+ * @param iterations Number of times #FRAMES_PER_ITERATION frames to run.
+ * @return Whether the roller coasters could be built.
+ */
+bool RunCoasterBenchmark(int size, int iterations)
+{
+	_world.SetWorldSize(size, size);
+	_world.MakeFlatWorld(TRACK_HEIGHT);
+	_world.SetTileOwnerGlobally(OWN_PARK);
+
+	const CoasterType *ct = nullptr;
+	for (uint i = 0; i < lengthof(_rides_manager.ride_types) && ct == nullptr; i++) {
+		const RideType *rt = _rides_manager.GetRideType(i);
+		if (rt != nullptr && rt->kind == RTK_COASTER && rt->CanMakeInstance()) ct = static_cast<const CoasterType *>(rt);
+	}
+	if (ct == nullptr) {
+		fprintf(stderr, "ERROR: No roller coaster type is available\n");
+		return false;
+	}
+
+	/* Each hill, with the flat track after it, is 8 tiles long. */
+	int hill_count = std::max(0, (size - 4) / 8);
+	std::vector<CoasterInstance *> coasters;
+	bool success = true;
+	for (int c = 0; c < COASTER_COUNT && success; c++) {
+		CoasterInstance *ci = BuildLoopedCoaster(ct, hill_count, TRACK_HEIGHT + c * COASTER_SPACING);
+		if (ci == nullptr) {
+			fprintf(stderr, "ERROR: Failed to add a roller coaster\n");
+			success = false;
+			break;
+		}
+		coasters.push_back(ci);
+		if (ci->DecideRideState() != RIS_TESTING) {
+			fprintf(stderr, "ERROR: Failed to build a looping track for roller coaster %d\n", c + 1);
+			success = false;
+			break;
+		}
+		AddTrains(ci);
+	}
+
+	if (success) {
+		int frame_count = iterations * FRAMES_PER_ITERATION;
+		int piece_count = 0;
+		while (piece_count < coasters[0]->capacity && coasters[0]->pieces[piece_count].piece != nullptr) piece_count++;
+		int car_count = COASTER_COUNT * lengthof(coasters[0]->trains) * CAR_COUNT;
+		printf("Moving %d cars in %d trains at %d roller coasters with %d track pieces, for %d frames.\n",
+				car_count, COASTER_COUNT * (int)lengthof(coasters[0]->trains), COASTER_COUNT, piece_count, frame_count);
+
+		auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frame_count; frame++) _rides_manager.OnAnimate(FRAME_DELAY);
+		double time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+		/* Hash the positions of the cars, to compare their movement between changes. */
+		uint32 hash = 2166136261u; // FNV-1a.
+		for (CoasterInstance *ci : coasters) {
+			for (CoasterTrain &train : ci->trains) {
+				for (CoasterCar &car : train.cars) {
+					XYZPoint32 front = car.front.MergeCoordinates();
+					XYZPoint32 back = car.back.MergeCoordinates();
+					const uint32 values[] = {(uint32)front.x, (uint32)front.y, (uint32)front.z, (uint32)back.x, (uint32)back.y, (uint32)back.z};
+					for (uint32 value : values) hash = (hash ^ value) * 16777619u;
+				}
+			}
+		}
+
+		printf("%-14s %14s %10s\n", "Frame (us)", "Car (us)", "Hash");
+		printf("%-14.1f %14.3f %10.8x\n", time / frame_count, time / ((double)frame_count * car_count), hash);
+	}
+
+	for (CoasterInstance *ci : coasters) _rides_manager.DeleteInstance(ci->GetIndex());
+	return success;
+}
@@ -0,0 +1,78 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file collect_bench.cpp Benchmark of collecting and sorting the sprites of a view of the world. */
+
+#include "../stdafx.h"
+#include "../map.h"
+#include "../viewport.h"
+#include "../person.h"
+#include "../people.h"
+#include "../gamecontrol.h"
+#include "bench.h"
+#include <chrono>
+
+static const uint16 VIEW_WIDTH  = 1920; ///< Width of the collected view.
+static const uint16 VIEW_HEIGHT = 1080; ///< Height of the collected view.
+static const int VIEW_TILE = 32;        ///< Coordinates of the tile at the centre of the view, the view is completely inside bigger parks.
+static const int WALK_FRAMES = 6000;    ///< Number of frames to let the guests walk into the viewed part of the park before collecting.
+
+/** Names of the view orientations. */
+static const char * const _orientation_names[VOR_NUM_ORIENT] = {"north", "east", "south", "west"};
+
+/**
+ * Measure collecting and sorting all sprites of a full screen view of a park with guests, near the park entrance.
+ * @param size Length of the sides of the world.
+ * @param guest_count Number of guests in the park.
+ * @param iterations Number of times to collect and sort the sprites of each view.
+ * @return Whether every collection of a view gave the same sprites in the same order.
+ */
+bool RunCollectBenchmark(int size, int guest_count, int iterations)
+{
+	BuildBenchPark(size, guest_count);
+	/* Let the guests walk from the entrance to the viewed part of the park. */
+	for (int frame = 0; frame < WALK_FRAMES; frame++) OnNewFrame(FRAME_DELAY);
+
+	int view_tile = std::min(size / 2, VIEW_TILE);
+	XYZPoint32 view_pos(view_tile * 256, view_tile * 256, 8 * 256);
+	printf("Collecting a %u x %u view of a %d x %d park with %u guests, %d iterations.\n",
+			VIEW_WIDTH, VIEW_HEIGHT, size, size, _guests.CountActiveGuests(), iterations);
+	printf("%-11s %8s %8s %12s %12s %10s\n", "Orientation", "Sprites", "Objects", "Collect (us)", "Sort (us)", "Hash");
+
+	bool success = true;
+	ViewSprites sprites;
+	for (int orient = VOR_NORTH; orient < VOR_NUM_ORIENT; orient++) {
+		sprites.Collect(view_pos, (ViewOrientation)orient, VIEW_WIDTH, VIEW_HEIGHT, SPS_OBJECTS);
+		uint object_count = sprites.Size();
+
+		double collect_time = 0.0;
+		double sort_time = 0.0;
+		uint32 hash = 0;
+		for (int it = 0; it < iterations; it++) {
+			auto start = std::chrono::steady_clock::now();
+			sprites.Collect(view_pos, (ViewOrientation)orient, VIEW_WIDTH, VIEW_HEIGHT, SPS_ALL);
+			auto collected = std::chrono::steady_clock::now();
+			sprites.Sort();
+			auto sorted = std::chrono::steady_clock::now();
+			collect_time += std::chrono::duration<double, std::micro>(collected - start).count();
+			sort_time += std::chrono::duration<double, std::micro>(sorted - collected).count();
+
+			uint32 it_hash = sprites.GetOrderHash();
+			if (it == 0) {
+				hash = it_hash;
+			} else if (it_hash != hash) {
+				fprintf(stderr, "ERROR: Collecting the %s view gave a different drawing order in iteration %d\n", _orientation_names[orient], it);
+				success = false;
+			}
+		}
+		printf("%-11s %8u %8u %12.1f %12.1f %10.8x\n", _orientation_names[orient], sprites.Size(), object_count,
+				collect_time / iterations, sort_time / iterations, hash);
+	}
+
+	ClearBenchPark();
+	return success;
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file guest_bench.cpp Benchmark of updating the guests of a big park every frame. */
+
+#include "../stdafx.h"
+#include "../person.h"
+#include "../people.h"
+#include "../gamecontrol.h"
+#include "../dates.h"
+#include "../ride_type.h"
+#include "../jobs.h"
+#include "bench.h"
+#include <algorithm>
+#include <chrono>
+
+static const int FRAMES_PER_ITERATION = 100; ///< Number of frames to run for each iteration.
+
+/**
+ * Measure updating the guests of a big park, and compare it with the time available for a frame.
+ * @param size Length of the sides of the world.
+ * @param guest_count Number of guests in the park.
+ * @param iterations Number of times #FRAMES_PER_ITERATION frames to run.
+ * @return Whether the guests of every frame were updated within the time of a frame.
+ */
+bool RunGuestBenchmark(int size, int guest_count, int iterations)
+{
+	BuildBenchPark(size, guest_count);
+	int frame_count = iterations * FRAMES_PER_ITERATION;
+	printf("Updating %u guests in a %d x %d park for %d frames with %u worker threads.\n",
+			_guests.CountActiveGuests(), size, size, frame_count, _job_pool.GetWorkerCount());
+
+	std::vector<double> tick_times;
+	std::vector<double> animate_times;
+	std::vector<double> frame_times;
+	for (int frame = 0; frame < frame_count; frame++) {
+		/* Same order as OnNewFrame. */
+		auto start = std::chrono::steady_clock::now();
+		_guests.DoTick();
+		auto ticked = std::chrono::steady_clock::now();
+		DateOnTick();
+
+		auto animate_start = std::chrono::steady_clock::now();
+		_guests.OnAnimate(FRAME_DELAY);
+		auto animated = std::chrono::steady_clock::now();
+		_rides_manager.OnAnimate(FRAME_DELAY);
+
+		tick_times.push_back(std::chrono::duration<double, std::milli>(ticked - start).count());
+		animate_times.push_back(std::chrono::duration<double, std::milli>(animated - animate_start).count());
+		frame_times.push_back(tick_times.back() + animate_times.back());
+	}
+	uint active_guests = _guests.CountActiveGuests();
+	ClearBenchPark();
+
+	double tick_total = 0.0;
+	double animate_total = 0.0;
+	for (int frame = 0; frame < frame_count; frame++) {
+		tick_total += tick_times[frame];
+		animate_total += animate_times[frame];
+	}
+	int over_budget = std::count_if(frame_times.begin(), frame_times.end(), [](double t) { return t > FRAME_DELAY; });
+	std::sort(frame_times.begin(), frame_times.end());
+
+	printf("%-14s %10s %10s %10s %10s %10s\n", "Guests", "Tick (ms)", "Anim (ms)", "Avg (ms)", "99% (ms)", "Max (ms)");
+	printf("%-14u %10.3f %10.3f %10.3f %10.3f %10.3f\n", active_guests, tick_total / frame_count, animate_total / frame_count,
+			(tick_total + animate_total) / frame_count, frame_times[frame_count * 99 / 100], frame_times.back());
+	if (over_budget > 0) {
+		fprintf(stderr, "ERROR: Updating the guests took more than %u ms in %d of the %d frames\n", FRAME_DELAY, over_budget, frame_count);
+		return false;
+	}
+	return true;
+}
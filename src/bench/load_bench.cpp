@@ -0,0 +1,67 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file load_bench.cpp Benchmark of loading the RCD files at startup. */
+
+#include "../stdafx.h"
+#include "../palette.h"
+#include "../rcdfile.h"
+#include "../sprite_data.h"
+#include "../sprite_store.h"
+#include "../jobs.h"
+#include "bench.h"
+#include <chrono>
+
+/**
+ * Compute a hash of the loaded images, to compare loading them in different ways.
+ * @return Hash of the sizes, offsets, and jump tables of all images.
+ */
+static uint32 GetImagesHash()
+{
+	uint32 hash = 2166136261u; // FNV-1a.
+	for (uint i = 0; i < GetImageCount(); i++) {
+		const ImageData *imd = GetImage(i);
+		const uint32 values[] = {imd->flags, imd->width, imd->height, (uint16)imd->xoffset, (uint16)imd->yoffset};
+		for (uint32 value : values) hash = (hash ^ value) * 16777619u;
+		if (imd->table == nullptr) continue;
+		for (uint16 y = 0; y < imd->height; y++) hash = (hash ^ imd->table[y]) * 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * Load all RCD files the same way as the game does at startup, and measure it.
+ * The files can be loaded only once by a program, run the benchmark with several numbers of worker threads to compare them.
+ * @return Whether images were loaded.
+ */
+bool RunLoadBenchmark()
+{
+	uint64 allocations = GetAllocationCount();
+	uint64 allocated = GetAllocatedBytes();
+
+	auto start = std::chrono::steady_clock::now();
+	_rcd_collection.ScanDirectories();
+	auto scanned = std::chrono::steady_clock::now();
+	_sprite_manager.LoadRcdFiles();
+	auto loaded = std::chrono::steady_clock::now();
+
+	allocations = GetAllocationCount() - allocations;
+	allocated = GetAllocatedBytes() - allocated;
+
+	printf("Loading %u RCD files with %u worker threads.\n", (uint)_rcd_collection.rcdfiles.size(), _job_pool.GetWorkerCount());
+	printf("%-8s %10s %10s %12s %14s %10s\n", "Images", "Scan (ms)", "Load (ms)", "Allocations", "Allocated (kB)", "Hash");
+	printf("%-8u %10.2f %10.2f %12llu %14.1f %10.8x\n", GetImageCount(),
+			std::chrono::duration<double, std::milli>(scanned - start).count(),
+			std::chrono::duration<double, std::milli>(loaded - scanned).count(),
+			(unsigned long long)allocations, allocated / 1024.0, GetImagesHash());
+
+	if (GetImageCount() == 0) {
+		fprintf(stderr, "ERROR: No images were loaded\n");
+		return false;
+	}
+	return true;
+}
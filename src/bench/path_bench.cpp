@@ -0,0 +1,108 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file path_bench.cpp Benchmark of searching paths. */
+
+#include "../stdafx.h"
+#include "../map.h"
+#include "../path.h"
+#include "../path_build.h"
+#include "../path_finding.h"
+#include "bench.h"
+#include <chrono>
+#include <random>
+
+static const int MAZE_HEIGHT = 8; ///< Height of the ground of the maze.
+
+/**
+ * Build a maze of paths at a flat world. Maze cells are at odd coordinates, the walls between them are at even coordinates.
+ * Every cell can be reached from every other cell by exactly one walk.
+ * @param size Length of the sides of the world.
+ * @param rng Random generator of the maze.
+ * @param cells [out] Positions of the path voxels of the cells.
+ */
+static void BuildMaze(int size, std::mt19937 &rng, std::vector<XYZPoint16> *cells)
+{
+	_world.SetWorldSize(size, size);
+	_world.MakeFlatWorld(MAZE_HEIGHT);
+	_world.SetTileOwnerGlobally(OWN_PARK);
+
+	const PathType path_type = GetBenchPathType();
+	const int cell_count = (size - 1) / 2; // Number of cells in each direction.
+	std::vector<bool> visited(cell_count * cell_count, false);
+	std::vector<Point16> stack;
+
+	/* Carve the maze with a depth-first walk from the first cell. */
+	cells->clear();
+	stack.push_back(Point16(0, 0));
+	visited[0] = true;
+	BuildFlatPath(XYZPoint16(1, 1, MAZE_HEIGHT), path_type, false);
+	cells->push_back(XYZPoint16(1, 1, MAZE_HEIGHT));
+	while (!stack.empty()) {
+		Point16 cell = stack.back();
+		TileEdge unvisited[EDGE_COUNT];
+		int count = 0;
+		for (TileEdge edge = EDGE_BEGIN; edge < EDGE_COUNT; edge++) {
+			int nx = cell.x + _tile_dxy[edge].x;
+			int ny = cell.y + _tile_dxy[edge].y;
+			if (nx < 0 || nx >= cell_count || ny < 0 || ny >= cell_count) continue;
+			if (!visited[nx * cell_count + ny]) unvisited[count++] = edge;
+		}
+		if (count == 0) {
+			stack.pop_back();
+			continue;
+		}
+
+		TileEdge edge = unvisited[rng() % count];
+		Point16 next(cell.x + _tile_dxy[edge].x, cell.y + _tile_dxy[edge].y);
+		visited[next.x * cell_count + next.y] = true;
+		stack.push_back(next);
+
+		/* Path in the wall between both cells, and in the new cell. */
+		BuildFlatPath(XYZPoint16(2 * cell.x + 1 + _tile_dxy[edge].x, 2 * cell.y + 1 + _tile_dxy[edge].y, MAZE_HEIGHT), path_type, false);
+		BuildFlatPath(XYZPoint16(2 * next.x + 1, 2 * next.y + 1, MAZE_HEIGHT), path_type, false);
+		cells->push_back(XYZPoint16(2 * next.x + 1, 2 * next.y + 1, MAZE_HEIGHT));
+	}
+}
+
+/**
+ * Measure searching paths between random cells of a maze.
+ * @param size Length of the sides of the world with the maze.
+ * @param queries Number of paths to search.
+ * @return Whether all paths were found.
+ */
+bool RunPathBenchmark(int size, int queries)
+{
+	std::mt19937 rng(1);
+	std::vector<XYZPoint16> cells;
+	BuildMaze(size, rng, &cells);
+	printf("Searching %d paths in a %d x %d maze with %u cells.\n", queries, size, size, (uint)cells.size());
+
+	uint32 found = 0;
+	uint64 total_length = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < queries; i++) {
+		const XYZPoint16 &from = cells[rng() % cells.size()];
+		const XYZPoint16 &to = cells[rng() % cells.size()];
+
+		PathSearcher searcher(to);
+		searcher.AddStart(from);
+		if (searcher.Search()) {
+			found++;
+			total_length += searcher.dest_pos->traveled;
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%-14s %12s %12s\n", "Queries/s", "Found", "Avg length");
+	printf("%-14.0f %12u %12.1f\n", queries / seconds, found, found > 0 ? (double)total_length / found : 0.0);
+	if (found != (uint32)queries) {
+		fprintf(stderr, "ERROR: Found only %u of the %d paths in the maze\n", found, queries);
+		return false;
+	}
+	return true;
+}
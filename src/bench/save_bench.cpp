@@ -0,0 +1,86 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file save_bench.cpp Benchmark of saving and loading games. */
+
+#include "../stdafx.h"
+#include "../person.h"
+#include "../people.h"
+#include "../gamelevel.h"
+#include "../loadsave.h"
+#include "bench.h"
+#include <chrono>
+
+static const char *BENCH_SAVE_FILE = "freerct-bench.fct"; ///< File written by the benchmark, relative to the program directory.
+
+/** Compression levels of saved games to measure. */
+static const int _bench_compressions[] = {0, 1, 6, 9};
+
+/**
+ * Get the size of a file.
+ * @param fname Name of the file.
+ * @return Size of the file in bytes, or \c -1 if it cannot be opened.
+ */
+static long GetFileSize(const char *fname)
+{
+	FILE *fp = fopen(fname, "rb");
+	if (fp == nullptr) return -1;
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fclose(fp);
+	return size;
+}
+
+/**
+ * Measure saving a big park to file, and loading it again.
+ * @param size Length of the sides of the world.
+ * @param guest_count Number of guests in the park.
+ * @param iterations Number of times to save and load the game at each compression level.
+ * @return Whether all saved games were loaded back to the same game state.
+ */
+bool RunSaveBenchmark(int size, int guest_count, int iterations)
+{
+	BuildBenchPark(size, guest_count);
+	uint32 checksum = GetGameChecksum();
+	printf("Saving a %d x %d park with %u guests, %d iterations.\n", size, size, _guests.CountActiveGuests(), iterations);
+	printf("%-11s %10s %10s %10s\n", "Compression", "Size (kB)", "Save (ms)", "Load (ms)");
+
+	int old_compression = _save_compression;
+	bool success = true;
+	for (int compression : _bench_compressions) {
+		_save_compression = compression;
+
+		double save_time = 0.0;
+		double load_time = 0.0;
+		for (int it = 0; it < iterations && success; it++) {
+			auto start = std::chrono::steady_clock::now();
+			bool saved = SaveGameFile(BENCH_SAVE_FILE);
+			save_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			_guests.Uninitialize(); // Like GameControl::ShutdownLevel before loading a game.
+			start = std::chrono::steady_clock::now();
+			bool loaded = saved && LoadGameFile(BENCH_SAVE_FILE);
+			load_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			if (!saved || !loaded) {
+				fprintf(stderr, "ERROR: Failed to %s \"%s\"\n", saved ? "load" : "save", BENCH_SAVE_FILE);
+				success = false;
+			} else if (GetGameChecksum() != checksum) {
+				fprintf(stderr, "ERROR: The loaded game differs from the saved game at compression level %d\n", compression);
+				success = false;
+			}
+		}
+		if (!success) break;
+
+		printf("%-11d %10.1f %10.2f %10.2f\n", compression, GetFileSize(BENCH_SAVE_FILE) / 1024.0, save_time / iterations, load_time / iterations);
+	}
+	remove(BENCH_SAVE_FILE);
+
+	_save_compression = old_compression;
+	ClearBenchPark();
+	return success;
+}
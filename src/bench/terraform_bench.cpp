@@ -0,0 +1,94 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file terraform_bench.cpp Benchmark of raising and lowering the terrain. */
+
+#include "../stdafx.h"
+#include "../map.h"
+#include "../viewport.h"
+#include "../terraform.h"
+#include "../loadsave.h"
+#include "bench.h"
+#include <chrono>
+
+static const int GROUND_HEIGHT = 8; ///< Height of the ground of the world.
+static const int AREA_SIZE = 64;    ///< Length of the sides of the changed area.
+static const int STEP_COUNT = 20;   ///< Number of steps to raise the area, and to lower it again, in each cycle.
+
+/**
+ * Raise or lower an area of the world one step, like the terraform tool in area mode does (without updating a view).
+ * @param base Base coordinate of the area.
+ * @param xsize Horizontal size of the area.
+ * @param ysize Vertical size of the area.
+ * @param direction Direction of change, \c 1 to raise, \c -1 to lower.
+ * @return Whether the change could be made.
+ */
+static bool ChangeArea(const Point16 &base, uint16 xsize, uint16 ysize, int direction)
+{
+	uint8 height = (direction > 0) ? WORLD_Z_SIZE : 0;
+	TerrainChanges changes(base, xsize, ysize);
+	for (uint16 x = 0; x < xsize; x++) {
+		for (uint16 y = 0; y < ysize; y++) {
+			if (!changes.ChangeVoxel(Point16(base.x + x, base.y + y), height, direction)) return false;
+		}
+	}
+	changes.ModifyWorld(direction);
+	return true;
+}
+
+/**
+ * Measure raising and lowering an area in the middle of the world, and the memory allocations it makes.
+ * Each iteration is one cycle of raising the area #STEP_COUNT steps and lowering it again.
+ * @param size Length of the sides of the world.
+ * @param iterations Number of cycles to run.
+ * @return Whether all changes could be made, and every cycle gave the same world.
+ */
+bool RunTerraformBenchmark(int size, int iterations)
+{
+	_world.SetWorldSize(size, size);
+	_world.MakeFlatWorld(GROUND_HEIGHT);
+	_world.SetTileOwnerGlobally(OWN_PARK);
+
+	uint16 area_size = std::min(AREA_SIZE, size);
+	Point16 base((size - area_size) / 2, (size - area_size) / 2);
+	printf("Raising and lowering a %d x %d area %d steps each way at a %d x %d world, for %d cycles.\n",
+			area_size, area_size, STEP_COUNT, size, size, iterations);
+
+	uint32 first_hash = 0;
+	double time = 0.0;
+	uint64 allocations = 0;
+	uint64 allocated = 0;
+	for (int cycle = 0; cycle < iterations; cycle++) {
+		uint64 count_before = GetAllocationCount();
+		uint64 bytes_before = GetAllocatedBytes();
+		auto start = std::chrono::steady_clock::now();
+		for (int step = 0; step < 2 * STEP_COUNT; step++) {
+			if (!ChangeArea(base, area_size, area_size, (step < STEP_COUNT) ? 1 : -1)) {
+				fprintf(stderr, "ERROR: Failed to %s the area in step %d of cycle %d\n", (step < STEP_COUNT) ? "raise" : "lower", step + 1, cycle + 1);
+				return false;
+			}
+		}
+		time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		allocations += GetAllocationCount() - count_before;
+		allocated += GetAllocatedBytes() - bytes_before;
+
+		/* Every cycle ends with the same world. */
+		uint32 hash = GetGameChecksum();
+		if (cycle == 0) {
+			first_hash = hash;
+		} else if (hash != first_hash) {
+			fprintf(stderr, "ERROR: World hash %08x after cycle %d differs from %08x after the first cycle\n", hash, cycle + 1, first_hash);
+			return false;
+		}
+	}
+
+	int step_count = iterations * 2 * STEP_COUNT;
+	printf("%-14s %12s %12s %14s %14s %10s\n", "Time (ms)", "Step (ms)", "Allocations", "Alloc/step", "Allocated (kB)", "Hash");
+	printf("%-14.1f %12.3f %12llu %14.1f %14.1f %10.8x\n", time, time / step_count, (unsigned long long)allocations,
+			(double)allocations / step_count, allocated / 1024.0, first_hash);
+	return true;
+}
@@ -0,0 +1,89 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_bench.cpp Benchmark of updating guests at worker threads, and check that it gives the same game as updating them serially. */
+
+#include "../stdafx.h"
+#include "../person.h"
+#include "../people.h"
+#include "../gamecontrol.h"
+#include "../loadsave.h"
+#include "../jobs.h"
+#include "bench.h"
+#include <chrono>
+
+static const char *BENCH_THREAD_FILE = "freerct-bench-threads.fct"; ///< Starting point of the runs, relative to the program directory.
+static const int TICKS_PER_ITERATION = 100; ///< Number of ticks to run for each iteration.
+
+/**
+ * Run the game from the saved starting point with a number of worker threads.
+ * @param worker_count Number of worker threads of the job pool.
+ * @param ticks Number of ticks to run.
+ * @param checksum [out] Checksum of the game after the last tick.
+ * @return Time of running the ticks in milliseconds, or a negative value if the starting point could not be loaded.
+ */
+static double RunTicks(int worker_count, int ticks, uint32 *checksum)
+{
+	_job_pool.Shutdown();
+	_job_pool.Initialize(worker_count);
+
+	_guests.Uninitialize(); // Like GameControl::ShutdownLevel before loading a game.
+	if (!LoadGameFile(BENCH_THREAD_FILE)) return -1.0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int tick = 0; tick < ticks; tick++) OnNewFrame(FRAME_DELAY);
+	double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	*checksum = GetGameChecksum();
+	return time;
+}
+
+/**
+ * Run the same ticks of a big park without worker threads and with worker threads, and compare the games afterwards.
+ * @param size Length of the sides of the world.
+ * @param guest_count Number of guests in the park.
+ * @param iterations Number of times #TICKS_PER_ITERATION ticks to run.
+ * @param worker_count Number of worker threads of the parallel run.
+ * @return Whether both runs ended with the same game.
+ */
+bool RunThreadBenchmark(int size, int guest_count, int iterations, int worker_count)
+{
+	uint old_worker_count = _job_pool.GetWorkerCount();
+	int ticks = iterations * TICKS_PER_ITERATION;
+
+	_job_pool.Shutdown(); // Build the park the same way for every number of workers.
+	BuildBenchPark(size, guest_count);
+	printf("Running %d ticks of a %d x %d park with %u guests.\n", ticks, size, size, _guests.CountActiveGuests());
+
+	bool success = SaveGameFile(BENCH_THREAD_FILE);
+	if (!success) fprintf(stderr, "ERROR: Failed to save \"%s\"\n", BENCH_THREAD_FILE);
+
+	uint32 serial_checksum = 0;
+	uint32 parallel_checksum = 0;
+	double serial_time = success ? RunTicks(0, ticks, &serial_checksum) : -1.0;
+	double parallel_time = success ? RunTicks(worker_count, ticks, &parallel_checksum) : -1.0;
+	if (success && (serial_time < 0.0 || parallel_time < 0.0)) {
+		fprintf(stderr, "ERROR: Failed to load \"%s\"\n", BENCH_THREAD_FILE);
+		success = false;
+	}
+	remove(BENCH_THREAD_FILE);
+
+	if (success) {
+		printf("%-8s %12s %12s\n", "Workers", "Tick (ms)", "Checksum");
+		printf("%-8d %12.3f %12.8x\n", 0, serial_time / ticks, serial_checksum);
+		printf("%-8d %12.3f %12.8x\n", worker_count, parallel_time / ticks, parallel_checksum);
+		if (serial_checksum != parallel_checksum) {
+			fprintf(stderr, "ERROR: The game with %d worker threads differs from the game without worker threads\n", worker_count);
+			success = false;
+		}
+	}
+
+	ClearBenchPark();
+	_job_pool.Shutdown();
+	_job_pool.Initialize(old_worker_count);
+	return success;
+}
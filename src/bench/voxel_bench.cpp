@@ -0,0 +1,173 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file voxel_bench.cpp Benchmark of the memory and the access of the voxels of a park. */
+
+#include "../stdafx.h"
+#include "../map.h"
+#include "../viewport.h"
+#include "../path_finding.h"
+#include "../person.h"
+#include "../people.h"
+#include "../gamecontrol.h"
+#include "bench.h"
+#include <chrono>
+#include <random>
+
+static const uint16 VIEW_WIDTH  = 1920; ///< Width of the collected view.
+static const uint16 VIEW_HEIGHT = 1080; ///< Height of the collected view.
+static const int VIEW_TILE = 32;        ///< Coordinates of the tile at the centre of the view, the view is completely inside bigger parks.
+static const int WALK_FRAMES = 6000;    ///< Number of frames to let the guests walk into the viewed part of the park before collecting.
+static const int PATH_QUERIES = 1000;   ///< Number of paths to search in each iteration.
+
+/** Print the memory used by the voxels of the world. */
+static void PrintVoxelMemory()
+{
+	uint64 voxel_count = 0;
+	uint chunk_count = 0;
+	uint64 table_bytes = 0;
+	const VoxelArena *arena = nullptr;
+	for (uint16 x = 0; x < _world.GetXSize(); x++) {
+		for (uint16 y = 0; y < _world.GetYSize(); y++) {
+			voxel_count += _world.GetStack(x, y)->height;
+
+			const VoxelChunk *chunk = _world.GetChunk(x, y);
+			if (chunk == nullptr || (x & WORLD_CHUNK_MASK) != 0 || (y & WORLD_CHUNK_MASK) != 0) continue;
+			chunk_count++;
+			table_bytes += chunk->GetObjectTableMemorySize();
+			arena = chunk->arena;
+		}
+	}
+	uint64 arena_bytes = (arena != nullptr) ? (uint64)arena->GetSlabCount() * VOXEL_ARENA_SLAB_SIZE * sizeof(Voxel) : 0;
+
+	printf("%-10s %12s %12s %8s %12s %12s\n", "Voxels", "Voxels (kB)", "Arena (kB)", "Chunks", "Chunks (kB)", "Tables (kB)");
+	printf("%-10llu %12.1f %12.1f %8u %12.1f %12.1f\n", (unsigned long long)voxel_count, voxel_count * sizeof(Voxel) / 1024.0,
+			arena_bytes / 1024.0, chunk_count, chunk_count * sizeof(VoxelChunk) / 1024.0, table_bytes / 1024.0);
+}
+
+/**
+ * Measure getting every voxel of the world.
+ * @param iterations Number of times to get every voxel.
+ * @return Average time of getting a voxel, in nanoseconds.
+ */
+static double MeasureGetVoxel(int iterations)
+{
+	uint64 count = 0;
+	uint64 ground_count = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int it = 0; it < iterations; it++) {
+		for (uint16 x = 0; x < _world.GetXSize(); x++) {
+			for (uint16 y = 0; y < _world.GetYSize(); y++) {
+				const VoxelStack *vs = _world.GetStack(x, y);
+				for (int16 z = vs->base; z < vs->base + vs->height; z++) {
+					const Voxel *v = _world.GetVoxel(XYZPoint16(x, y, z));
+					if (v != nullptr && v->GetGroundType() != GTP_INVALID) ground_count++;
+					count++;
+				}
+			}
+		}
+	}
+	double time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	/* Using the ground count keeps the compiler from dropping the loop. */
+	return (count > 0 && ground_count <= count) ? time / count : 0.0;
+}
+
+/**
+ * Measure searching paths between random path voxels of the park.
+ * @param size Length of the sides of the world.
+ * @param queries Number of paths to search.
+ * @param found [out] Number of paths found.
+ * @return Number of searched paths per second.
+ */
+static double MeasurePathSearch(int size, int queries, int *found)
+{
+	std::vector<XYZPoint16> paths;
+	for (int x = 1; x < size - 1; x++) {
+		for (int y = 1; y < size - 1; y++) {
+			if (x % 4 == 1 || y % 4 == 1) paths.push_back(XYZPoint16(x, y, 8));
+		}
+	}
+
+	std::mt19937 rng(1);
+	*found = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < queries; i++) {
+		PathSearcher searcher(paths[rng() % paths.size()]);
+		searcher.AddStart(paths[rng() % paths.size()]);
+		if (searcher.Search()) (*found)++;
+	}
+	return queries / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Measure collecting the sprites of a full screen view, with and without the voxel objects.
+ * Both collections are alternated, to give them the same state of the caches.
+ * @param sprites Storage of the collected sprites.
+ * @param view_pos Position of the centre of the view.
+ * @param iterations Number of times to collect the sprites.
+ * @param static_time [out] Average time of collecting the sprites without voxel objects, in microseconds.
+ * @param all_time [out] Average time of collecting all sprites, in microseconds.
+ */
+static void MeasureCollect(ViewSprites *sprites, const XYZPoint32 &view_pos, int iterations, double *static_time, double *all_time)
+{
+	/* The first collection grows the storage of the sprites. */
+	sprites->Collect(view_pos, VOR_NORTH, VIEW_WIDTH, VIEW_HEIGHT, SPS_ALL);
+
+	*static_time = 0.0;
+	*all_time = 0.0;
+	for (int it = 0; it < iterations; it++) {
+		auto start = std::chrono::steady_clock::now();
+		sprites->Collect(view_pos, VOR_NORTH, VIEW_WIDTH, VIEW_HEIGHT, SPS_STATIC);
+		auto collected_static = std::chrono::steady_clock::now();
+		sprites->Collect(view_pos, VOR_NORTH, VIEW_WIDTH, VIEW_HEIGHT, SPS_ALL);
+		auto collected_all = std::chrono::steady_clock::now();
+		*static_time += std::chrono::duration<double, std::micro>(collected_static - start).count();
+		*all_time += std::chrono::duration<double, std::micro>(collected_all - collected_static).count();
+	}
+	*static_time /= iterations;
+	*all_time /= iterations;
+}
+
+/**
+ * Measure the memory of the voxels of a park with guests, and the speed of getting voxels, searching paths, and collecting the sprites of a view.
+ * Collecting the sprites is measured with and without the voxel objects, their difference is the cost of finding the voxel objects.
+ * @param size Length of the sides of the world.
+ * @param guest_count Number of guests in the park.
+ * @param iterations Number of times to repeat each measurement.
+ * @return Whether all paths were found.
+ */
+bool RunVoxelBenchmark(int size, int guest_count, int iterations)
+{
+	BuildBenchPark(size, guest_count);
+	/* Let the guests walk from the entrance to the viewed part of the park. */
+	for (int frame = 0; frame < WALK_FRAMES; frame++) OnNewFrame(FRAME_DELAY);
+
+	printf("Voxels of a %d x %d park with %u guests, %d iterations.\n", size, size, _guests.CountActiveGuests(), iterations);
+	PrintVoxelMemory();
+
+	int view_tile = std::min(size / 2, VIEW_TILE);
+	XYZPoint32 view_pos(view_tile * 256, view_tile * 256, 8 * 256);
+	ViewSprites sprites;
+	sprites.Collect(view_pos, VOR_NORTH, VIEW_WIDTH, VIEW_HEIGHT, SPS_OBJECTS);
+	uint object_count = sprites.Size();
+
+	double get_voxel = MeasureGetVoxel(iterations);
+	int found;
+	double queries = MeasurePathSearch(size, iterations * PATH_QUERIES, &found);
+	double static_time, all_time;
+	MeasureCollect(&sprites, view_pos, iterations, &static_time, &all_time);
+
+	printf("%-14s %12s %8s %14s %14s %14s\n", "GetVoxel (ns)", "Queries/s", "Objects", "Static (us)", "All (us)", "Objects (us)");
+	printf("%-14.2f %12.0f %8u %14.1f %14.1f %14.1f\n", get_voxel, queries, object_count, static_time, all_time, all_time - static_time);
+
+	ClearBenchPark();
+	if (found != iterations * PATH_QUERIES) {
+		fprintf(stderr, "ERROR: Found only %d of the %d paths in the park\n", found, iterations * PATH_QUERIES);
+		return false;
+	}
+	return true;
+}
@@ -241,8 +241,7 @@ void DisplayCoasterCar::Set(const XYZPoint16 &vox_pos, const XYZPoint16 &pix_pos
 	if (this->yaw != 0xff && change_voxel) {
 		/* Valid data, and changing voxel -> remove self from the old voxel. */
 		this->MarkDirty();
-		Voxel *v = _world.GetCreateVoxel(this->vox_pos, false);
-		this->RemoveSelf(v);
+		this->RemoveSelf();
 	}
 
 	/* Update voxel and orientation. */
@@ -255,10 +254,7 @@ void DisplayCoasterCar::Set(const XYZPoint16 &vox_pos, const XYZPoint16 &pix_pos
 	if (this->yaw != 0xff) {
 		this->MarkDirty(); // Voxel or orientation has changed, repaint the possibly new voxel.
 
-		if (change_voxel) { // With a really new voxel, also add self to the new voxel.
-			Voxel *v = _world.GetCreateVoxel(this->vox_pos, false);
-			this->AddSelf(v);
-		}
+		if (change_voxel) this->AddSelf(); // With a really new voxel, also add self to the new voxel.
 	}
 }
 
@@ -322,6 +318,22 @@ static void inline Unroll(uint roll, int32 *dy, int32 *dz)
 	*dz = new_dz;
 }
 
+static const int TAN_PRECISION = 16; ///< Number of fraction bits of the tangents below.
+static const int64 TAN11_25 = 13036; ///< tan(11.25 degrees), with #TAN_PRECISION fraction bits.
+static const int64 TAN33_75 = 43790; ///< tan(3*11.25 degrees), with #TAN_PRECISION fraction bits.
+
+/**
+ * Compare the lengths of two perpendicular parts of a vector, to decide whether the angle of the vector is below a given angle.
+ * @param sqr_length Squared length of the part opposite to the angle.
+ * @param sqr_base Squared length of the part adjacent to the angle.
+ * @param tangent Tangent of the angle to compare with, with #TAN_PRECISION fraction bits.
+ * @return Whether \c sqrt(sqr_length) is less than \c sqrt(sqr_base) * \a tangent.
+ */
+static inline bool IsBelowTangent(int64 sqr_length, int64 sqr_base, int64 tangent)
+{
+	return (sqr_length << (2 * TAN_PRECISION)) < sqr_base * tangent * tangent;
+}
+
 /**
  * Time has passed, update the position of the train.
  * @param delay Amount of time passed, in milliseconds.
@@ -339,10 +351,7 @@ void CoasterTrain::OnAnimate(int delay)
 		uint32 change = -this->speed * delay;
 		if (change > this->back_position) {
 			this->back_position = this->back_position + this->coaster->coaster_length - change;
-			/* Update the track piece as well. There is no simple way to get
-			 * the last piece, so moving from the front will have to do. */
-			this->cur_piece = this->coaster->pieces;
-			while (this->cur_piece->distance_base + this->cur_piece->piece->piece_length < this->back_position) this->cur_piece++;
+			this->cur_piece = this->coaster->FindPieceAt(this->back_position);
 		} else {
 			this->back_position -= change;
 			while (this->cur_piece->distance_base > this->back_position) this->cur_piece--;
@@ -360,9 +369,10 @@ void CoasterTrain::OnAnimate(int delay)
 		while (ptp->distance_base + ptp->piece->piece_length < position) ptp++;
 
 		/* Get position of the back of the car. */
-		int32 xpos_back = ptp->piece->car_xpos->GetValue(position - ptp->distance_base) + (ptp->base_voxel.x << 8);
-		int32 ypos_back = ptp->piece->car_ypos->GetValue(position - ptp->distance_base) + (ptp->base_voxel.y << 8);
-		int32 zpos_back = ptp->piece->car_zpos->GetValue(position - ptp->distance_base) * 2 + (ptp->base_voxel.z << 8);
+		TrackSample sample = ptp->piece->GetSample(position - ptp->distance_base);
+		int32 xpos_back = (sample.xpos >> TRACK_SAMPLE_PRECISION) + (ptp->base_voxel.x << 8);
+		int32 ypos_back = (sample.ypos >> TRACK_SAMPLE_PRECISION) + (ptp->base_voxel.y << 8);
+		int32 zpos_back = ((sample.zpos * 2) >> TRACK_SAMPLE_PRECISION) + (ptp->base_voxel.z << 8);
 
 		/* Get roll from the center of the car. */
 		position += car_length / 2;
@@ -371,7 +381,8 @@ void CoasterTrain::OnAnimate(int delay)
 			ptp = this->coaster->pieces;
 		}
 		while (ptp->distance_base + ptp->piece->piece_length < position) ptp++;
-		uint roll = static_cast<uint>(ptp->piece->car_roll->GetValue(position - ptp->distance_base) + 0.5) & 0xf;
+		sample = ptp->piece->GetSample(position - ptp->distance_base);
+		uint roll = static_cast<uint>((sample.roll + (1 << (TRACK_SAMPLE_PRECISION - 1))) >> TRACK_SAMPLE_PRECISION) & 0xf;
 
 		/* Get position of the front of the car. */
 		position += car_length / 2;
@@ -380,9 +391,10 @@ void CoasterTrain::OnAnimate(int delay)
 			ptp = this->coaster->pieces;
 		}
 		while (ptp->distance_base + ptp->piece->piece_length < position) ptp++;
-		int32 xpos_front = ptp->piece->car_xpos->GetValue(position - ptp->distance_base) + (ptp->base_voxel.x << 8);
-		int32 ypos_front = ptp->piece->car_ypos->GetValue(position - ptp->distance_base) + (ptp->base_voxel.y << 8);
-		int32 zpos_front = ptp->piece->car_zpos->GetValue(position - ptp->distance_base) * 2 + (ptp->base_voxel.z << 8);
+		sample = ptp->piece->GetSample(position - ptp->distance_base);
+		int32 xpos_front = (sample.xpos >> TRACK_SAMPLE_PRECISION) + (ptp->base_voxel.x << 8);
+		int32 ypos_front = (sample.ypos >> TRACK_SAMPLE_PRECISION) + (ptp->base_voxel.y << 8);
+		int32 zpos_front = ((sample.zpos * 2) >> TRACK_SAMPLE_PRECISION) + (ptp->base_voxel.z << 8);
 
 		int32 xder = xpos_front - xpos_back;
 		int32 yder = ypos_front - ypos_back;
@@ -404,10 +416,7 @@ void CoasterTrain::OnAnimate(int delay)
 
 		/* Unroll the orientation vector. */
 		Unroll(roll, &yder, &zder);
-		float horizontal_speed = std::hypot(xder, yder);
-
-		static const double TAN11_25 = 0.198912367379658;  // tan(11.25 degrees).
-		static const double TAN33_75 = 0.6681786379192989; // tan(3*11.25 degrees).
+		int64 horizontal_sqr = (int64)xder * xder + (int64)yder * yder;
 
 		/* Compute pitch. */
 		bool swap_dz = false;
@@ -415,20 +424,21 @@ void CoasterTrain::OnAnimate(int delay)
 			swap_dz = true;
 			zder = -zder;
 		}
+		int64 vertical_sqr = (int64)zder * zder;
 
 		uint pitch;
-		if (horizontal_speed < zder) {
-			if (horizontal_speed < zder * TAN11_25) {
+		if (horizontal_sqr < vertical_sqr) {
+			if (IsBelowTangent(horizontal_sqr, vertical_sqr, TAN11_25)) {
 				pitch = 4;
-			} else if (horizontal_speed < zder * TAN33_75) {
+			} else if (IsBelowTangent(horizontal_sqr, vertical_sqr, TAN33_75)) {
 				pitch = 3;
 			} else {
 				pitch = 2;
 			}
 		} else {
-			if (zder < horizontal_speed * TAN11_25) {
+			if (IsBelowTangent(vertical_sqr, horizontal_sqr, TAN11_25)) {
 				pitch = 0;
-			} else if (zder < horizontal_speed * TAN33_75) {
+			} else if (IsBelowTangent(vertical_sqr, horizontal_sqr, TAN33_75)) {
 				pitch = 1;
 			} else {
 				pitch = 2;
@@ -455,9 +465,9 @@ void CoasterTrain::OnAnimate(int delay)
 			/* In the first 45 degrees. It is split in 4 parts (4*11.25 degrees)
 			 * where the 1st part is for direction 0. The 2nd and 3rd part are for direction 1,
 			 * and the 4th part is for direction 2. */
-			if (xder * TAN11_25 < yder) {
+			if (xder * TAN11_25 < (int64)yder << TAN_PRECISION) {
 				yaw = 0;
-			} else if (xder * TAN33_75 < yder) {
+			} else if (xder * TAN33_75 < (int64)yder << TAN_PRECISION) {
 				yaw = 1;
 			} else {
 				yaw = 2;
@@ -469,9 +479,9 @@ void CoasterTrain::OnAnimate(int delay)
 			 *
 			 * Rather than re-inventing a solution, re-use the same checks as
 			 * above with swapped xder and yder. */
-			if (yder * TAN11_25 < xder) {
+			if (yder * TAN11_25 < (int64)xder << TAN_PRECISION) {
 				yaw = 4;
-			} else if (yder * TAN33_75 < xder) {
+			} else if (yder * TAN33_75 < (int64)xder << TAN_PRECISION) {
 				yaw = 3;
 			} else {
 				yaw = 2;
@@ -633,6 +643,19 @@ int CoasterInstance::GetFirstPlacedTrackPiece() const
 	return -1;
 }
 
+/**
+ * Find the track piece at a distance in the roller coaster track by bisection.
+ * @param distance Distance in the track, in 1/256 pixel.
+ * @return The track piece containing the given distance.
+ * @pre The positioned track pieces form a loop, see #MakePositionedPiecesLooping.
+ */
+const PositionedTrackPiece *CoasterInstance::FindPieceAt(uint32 distance) const
+{
+	const PositionedTrackPiece *end = std::partition_point(this->pieces + 1, this->pieces + this->capacity,
+			[distance](const PositionedTrackPiece &ptp){ return ptp.piece != nullptr && ptp.distance_base <= distance; });
+	return end - 1;
+}
+
 /**
  * Find the first placed track piece at a given position with a given entry connection.
  * @param vox Required voxel position.
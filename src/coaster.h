@@ -198,6 +198,7 @@ public:
 
 	bool MakePositionedPiecesLooping(bool *modified);
 	int GetFirstPlacedTrackPiece() const;
+	const PositionedTrackPiece *FindPieceAt(uint32 distance) const;
 	int AddPositionedPiece(const PositionedTrackPiece &placed);
 	void RemovePositionedPiece(PositionedTrackPiece &piece);
 
@@ -11,6 +11,7 @@
 #include "window.h"
 #include "palette.h"
 #include "bitmath.h"
+#include "viewport.h"
 
 /**
  * Defines a Dropdown menu item.
@@ -248,6 +249,7 @@ void RecolourDropdownWindow::OnClick(WidgetNumber widget, const Point16 &pos)
 
 		if (this->entry->dest != widget - RD_BUTTON_00) {
 			this->entry->dest = static_cast<ColourRange>(widget - RD_BUTTON_00);
+			MarkWorldDirty(); // The colour may be used by a ride in the world.
 			_video.MarkDisplayDirty();
 		}
 
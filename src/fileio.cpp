@@ -111,33 +111,74 @@ DirectoryReader *MakeDirectoryReader()
 }
 
 /**
- * RCD file reader constructor, loading data from a file.
- * @param fname Name of the file to load.
+ * Decode a 16 bits little endian number.
+ * @param p First byte of the number.
+ * @return Decoded number.
  */
-RcdFileReader::RcdFileReader(const char *fname)
+static inline uint16 DecodeUInt16(const uint8 *p)
 {
-	this->file_pos = 0;
-	this->file_size = 0;
-	this->name[4] = '\0';
+	return p[0] | (p[1] << 8);
+}
 
-	this->fp = fopen(fname, "rb");
-	if (this->fp == nullptr) return;
+/**
+ * Decode a 32 bits little endian number.
+ * @param p First byte of the number.
+ * @return Decoded number.
+ */
+static inline uint32 DecodeUInt32(const uint8 *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32>(p[3]) << 24);
+}
 
-	if (fseek(this->fp, 0L, SEEK_END) != 0) {
-		fclose(this->fp);
-		return;
+/**
+ * Get the contents of a file into memory.
+ * @param fname Name of the file to load.
+ */
+FileContents::FileContents(const char *fname)
+{
+	this->data = MapFile(fname, &this->size);
+	this->mapped = this->data != nullptr;
+	if (this->mapped) return;
+
+	/* Mapping failed, read the file instead. */
+	this->size = 0;
+	FILE *fp = fopen(fname, "rb");
+	if (fp == nullptr) return;
+
+	if (fseek(fp, 0L, SEEK_END) == 0) {
+		long length = ftell(fp);
+		if (length > 0 && fseek(fp, 0L, SEEK_SET) == 0) {
+			uint8 *buffer = new uint8[length];
+			if (fread(buffer, length, 1, fp) == 1) {
+				this->data = buffer;
+				this->size = length;
+			} else {
+				delete[] buffer;
+			}
+		}
 	}
-	this->file_size = ftell(this->fp);
-	if (fseek(this->fp, 0L, SEEK_SET) != 0) {
-		fclose(this->fp);
-		return;
+	fclose(fp);
+}
+
+FileContents::~FileContents()
+{
+	if (this->mapped) {
+		UnmapFile(this->data, this->size);
+	} else {
+		delete[] this->data;
 	}
 }
 
-/** Destructor. */
-RcdFileReader::~RcdFileReader()
+/**
+ * RCD file reader constructor, loading data from a file.
+ * @param fname Name of the file to load.
+ */
+RcdFileReader::RcdFileReader(const char *fname) : contents(new FileContents(fname))
 {
-	if (this->fp != nullptr) fclose(fp);
+	this->file_data = this->contents->data;
+	this->file_pos = 0;
+	this->file_size = (this->file_data != nullptr) ? this->contents->size : 0;
+	this->name[4] = '\0';
 }
 
 /**
@@ -156,8 +197,9 @@ size_t RcdFileReader::GetRemaining()
  */
 uint8 RcdFileReader::GetUInt8()
 {
+	uint8 val = (this->file_pos < this->file_size) ? this->file_data[this->file_pos] : 0;
 	this->file_pos++;
-	return fgetc(this->fp);
+	return val;
 }
 
 /**
@@ -177,8 +219,13 @@ int8 RcdFileReader::GetInt8()
  */
 uint16 RcdFileReader::GetUInt16()
 {
-	uint16 val = this->GetUInt8();
-	return val | (this->GetUInt8() << 8);
+	if (this->GetRemaining() < 2) {
+		uint16 val = this->GetUInt8();
+		return val | (this->GetUInt8() << 8);
+	}
+	uint16 val = DecodeUInt16(this->file_data + this->file_pos);
+	this->file_pos += 2;
+	return val;
 }
 
 /**
@@ -188,8 +235,7 @@ uint16 RcdFileReader::GetUInt16()
  */
 int16 RcdFileReader::GetInt16()
 {
-	uint16 val = this->GetUInt8();
-	return val | (this->GetUInt8() << 8);
+	return this->GetUInt16();
 }
 
 /**
@@ -199,8 +245,13 @@ int16 RcdFileReader::GetInt16()
  */
 uint32 RcdFileReader::GetUInt32()
 {
-	uint32 val = this->GetUInt16();
-	return val | (this->GetUInt16() << 16);
+	if (this->GetRemaining() < 4) {
+		uint32 val = this->GetUInt16();
+		return val | (this->GetUInt16() << 16);
+	}
+	uint32 val = DecodeUInt32(this->file_data + this->file_pos);
+	this->file_pos += 4;
+	return val;
 }
 
 /**
@@ -210,8 +261,7 @@ uint32 RcdFileReader::GetUInt32()
  */
 int32 RcdFileReader::GetInt32()
 {
-	uint32 val = this->GetUInt16();
-	return val | (this->GetUInt16() << 16);
+	return this->GetUInt32();
 }
 
 /**
@@ -222,15 +272,13 @@ int32 RcdFileReader::GetInt32()
  */
 bool RcdFileReader::CheckFileHeader(const char *hdr_name, uint32 version)
 {
-	if (this->fp == nullptr) return false;
+	if (this->file_data == nullptr) return false;
 	if (this->GetRemaining() < 8) return false;
 
-	char name[5];
-	this->GetBlob(name, 4);
-	name[4] = '\0';
-	if (strcmp(name, hdr_name) != 0) return false;
-	uint32 val = this->GetUInt32();
-	return val == version;
+	const uint8 *header = this->file_data + this->file_pos;
+	this->file_pos += 8;
+	if (memcmp(header, hdr_name, 4) != 0) return false;
+	return DecodeUInt32(header + 4) == version;
 }
 
 /**
@@ -240,9 +288,12 @@ bool RcdFileReader::CheckFileHeader(const char *hdr_name, uint32 version)
 bool RcdFileReader::ReadBlockHeader()
 {
 	if (this->GetRemaining() < 12) return false;
-	this->GetBlob(this->name, 4);
-	this->version = this->GetUInt32();
-	this->size = this->GetUInt32();
+
+	const uint8 *header = this->file_data + this->file_pos;
+	this->file_pos += 12;
+	memcpy(this->name, header, 4);
+	this->version = DecodeUInt32(header + 4);
+	this->size = DecodeUInt32(header + 8);
 	return this->file_pos + (size_t)this->size <= this->file_size;
 }
 
@@ -255,7 +306,7 @@ bool RcdFileReader::SkipBytes(uint32 count)
 {
 	this->file_pos += count;
 	if (this->file_pos > this->file_size) this->file_pos = this->file_size;
-	return fseek(this->fp, this->file_pos, SEEK_SET) == 0;
+	return this->file_data != nullptr;
 }
 
 /**
@@ -266,8 +317,29 @@ bool RcdFileReader::SkipBytes(uint32 count)
  */
 bool RcdFileReader::GetBlob(void *address, size_t length)
 {
+	if (this->GetRemaining() < length) {
+		this->file_pos += length;
+		return false;
+	}
+	memcpy(address, this->file_data + this->file_pos, length);
+	this->file_pos += length;
+	return true;
+}
+
+/**
+ * Get a blob of data from the file without copying it.
+ * @param length Length of the data.
+ * @return Address of the data in the file contents, or \c nullptr if the file is too short. The data stays valid while #contents exists.
+ */
+const uint8 *RcdFileReader::GetData(size_t length)
+{
+	if (this->GetRemaining() < length) {
+		this->file_pos += length;
+		return nullptr;
+	}
+	const uint8 *data = this->file_data + this->file_pos;
 	this->file_pos += length;
-	return fread(address, length, 1, this->fp) == 1;
+	return data;
 }
 
 /**
@@ -10,6 +10,8 @@
 #ifndef FILEIO_H
 #define FILEIO_H
 
+#include <memory>
+
 /**
  * Base class for reading the contents of a directory.
  * Intended use:
@@ -39,19 +41,34 @@ public:
 };
 
 /**
- * Class for reading an RCD file.
+ * Contents of a file in memory. The file is mapped into memory if the platform supports it, else it is read into allocated memory.
+ * @ingroup fileio_group
+ */
+class FileContents {
+public:
+	FileContents(const char *fname);
+	~FileContents();
+
+	const uint8 *data; ///< Contents of the file, \c nullptr if the file could not be read.
+	size_t size;       ///< Size of the file in bytes.
+	bool mapped;       ///< Whether #data is mapped into memory, else it is allocated.
+};
+
+/**
+ * Class for reading an RCD file. The file is read from its contents in memory, so blocks can refer to
+ * their data in the file without copying it.
  * @ingroup fileio_group
  */
 class RcdFileReader {
 public:
 	RcdFileReader(const char *fname);
-	~RcdFileReader();
 
 	bool CheckFileHeader(const char *hdr_name, uint32 version);
 	bool ReadBlockHeader();
 	bool SkipBytes(uint32 count);
 
 	bool GetBlob(void *address, size_t length);
+	const uint8 *GetData(size_t length);
 
 	uint8  GetUInt8();
 	uint16 GetUInt16();
@@ -66,15 +83,20 @@ public:
 	uint32 version; ///< Version number of the last found block (with #ReadBlockHeader).
 	uint32 size;    ///< Data size of the last found block (with #ReadBlockHeader).
 
+	std::shared_ptr<const FileContents> contents; ///< Contents of the opened file, keep a copy while using data of #GetData.
+
 private:
-	FILE *fp;         ///< File handle of the opened file.
-	size_t file_pos;  ///< Position in the opened file.
-	size_t file_size; ///< Size of the opened file.
+	const uint8 *file_data; ///< Contents of the opened file.
+	size_t file_pos;        ///< Position in the opened file.
+	size_t file_size;       ///< Size of the opened file.
 };
 
 bool PathIsFile(const char *path);
 bool PathIsDirectory(const char *path);
 
+const uint8 *MapFile(const char *fname, size_t *size);
+void UnmapFile(const uint8 *data, size_t size);
+
 DirectoryReader *MakeDirectoryReader();
 
 bool ChangeWorkingDirectoryToExecutable(const char *exe);
@@ -20,6 +20,9 @@
 #include "getoptdata.h"
 #include "fileio.h"
 #include "gamecontrol.h"
+#include "jobs.h"
+#include "loadsave.h"
+#include "profiler.h"
 
 GameControl _game_control; ///< Game controller.
 
@@ -42,6 +45,10 @@ void error(const char *str, ...)
 /** Command-line options of the program. */
 static const OptionData _options[] = {
 	GETOPT_NOVAL('h', "--help"),
+	GETOPT_GENERAL('H', '\0', "--headless", ODF_NO_VALUE),
+	GETOPT_VALUE('l', "--load"),
+	GETOPT_VALUE('d', "--days"),
+	GETOPT_VALUE('p', "--profile"),
 	GETOPT_END()
 };
 
@@ -51,6 +58,10 @@ static void PrintUsage()
 	printf("Usage: freerct [options]\n");
 	printf("Options:\n");
 	printf("  -h, --help     Display this help text and exit\n");
+	printf("  -l, --load     Start with the given saved game (relative to the program directory)\n");
+	printf("      --headless Simulate the saved game of '--load' without display, and print its speed and final state\n");
+	printf("  -d, --days     Number of days to simulate with '--headless' (default 30)\n");
+	printf("  -p, --profile  Write the time spent in the phases of every frame to the given CSV file (relative to the program directory)\n");
 }
 
 /** Show that there are missing sprites. */
@@ -71,6 +82,10 @@ int freerct_main(int argc, char **argv)
 {
 	GetOptData opt_data(argc - 1, argv + 1, _options);
 
+	bool headless = false;
+	std::string load_fname;
+	int days = 30;
+	std::string profile_fname;
 	int opt_id;
 	do {
 		opt_id = opt_data.GetOpt();
@@ -79,6 +94,22 @@ int freerct_main(int argc, char **argv)
 				PrintUsage();
 				return 0;
 
+			case 'H':
+				headless = true;
+				break;
+
+			case 'l':
+				load_fname = opt_data.opt;
+				break;
+
+			case 'd':
+				days = atoi(opt_data.opt);
+				break;
+
+			case 'p':
+				profile_fname = opt_data.opt;
+				break;
+
 			case -1:
 				break;
 
@@ -89,9 +120,28 @@ int freerct_main(int argc, char **argv)
 		}
 	} while (opt_id != -1);
 
+	if (headless && load_fname.empty()) {
+		fprintf(stderr, "ERROR: '--headless' needs a saved game to simulate, use '--load'\n");
+		return 1;
+	}
+
 	ConfigFile cfg_file;
 
 	ChangeWorkingDirectoryToExecutable(argv[0]);
+	cfg_file.Load("freerct.cfg");
+
+	if (!profile_fname.empty() && !_frame_profiler.OpenCsvFile(profile_fname.c_str())) {
+		fprintf(stderr, "ERROR: Could not open profile file \"%s\"\n", profile_fname.c_str());
+		return 1;
+	}
+
+	/* Start the worker threads, by default one thread less than the number of processors. */
+	int worker_count = cfg_file.GetNum("game", "worker-threads");
+	_job_pool.Initialize(worker_count);
+
+	/* Compression level of saved games, 0 saves without compression. */
+	int save_compression = cfg_file.GetNum("game", "save-compression");
+	if (save_compression >= 0) _save_compression = std::min(save_compression, 9);
 
 	/* Load RCD files. */
 	InitImageStorage();
@@ -105,7 +155,16 @@ int freerct_main(int argc, char **argv)
 		return 1;
 	}
 
-	cfg_file.Load("freerct.cfg");
+	if (headless) {
+		bool success = _game_control.RunHeadless(load_fname, days);
+		_job_pool.Shutdown();
+		_frame_profiler.CloseCsvFile();
+
+		UninitLanguage();
+		DestroyImageStorage();
+		return success ? 0 : 1;
+	}
+
 	const char *font_path = cfg_file.GetValue("font", "medium-path");
 	int font_size = cfg_file.GetNum("font", "medium-size");
 	if (font_path == nullptr || *font_path == '\0' || font_size == -1) {
@@ -124,13 +183,20 @@ int freerct_main(int argc, char **argv)
 		return 1;
 	}
 
-	/// \todo Allow for loading directly from a saved game.
-	_game_control.Initialize();
+	/* Drawing sprites from the cache of decoded sprites, by default the sprites are decoded while drawing. */
+	_video.cache_sprites = cfg_file.GetNum("video", "sprite-cache") > 0;
+
+	/* Autosave interval in days, by default autosaving is disabled. */
+	int autosave_interval = std::max(0, cfg_file.GetNum("game", "autosave-interval"));
+
+	_game_control.Initialize(autosave_interval, load_fname);
 
 	/* Loops until told not to. */
 	_video.MainLoop();
 
 	_game_control.Uninitialize();
+	_job_pool.Shutdown();
+	_frame_profiler.CloseCsvFile();
 
 	UninitLanguage();
 	DestroyImageStorage();
@@ -18,6 +18,11 @@
 #include "viewport.h"
 #include "weather.h"
 #include "freerct.h"
+#include "loadsave.h"
+#include "profiler.h"
+#include <chrono>
+
+static const char *AUTOSAVE_FILE = "autosave.fct"; ///< Name of the file to write autosaves to.
 
 GameModeManager _game_mode_mgr; ///< Game mode manager object.
 
@@ -40,6 +45,7 @@ void OnNewDay()
 	_rides_manager.OnNewDay();
 	_guests.OnNewDay();
 	_weather.OnNewDay();
+	_game_control.OnNewDay();
 	NotifyChange(WC_BOTTOM_TOOLBAR, ALL_WINDOWS_OF_TYPE, CHG_DISPLAY_OLD, 0);
 }
 
@@ -49,11 +55,28 @@ void OnNewDay()
 */
 void OnNewFrame(uint32 frame_delay)
 {
-	_window_manager.Tick();
-	_guests.DoTick();
-	DateOnTick();
-	_guests.OnAnimate(frame_delay);
-	_rides_manager.OnAnimate(frame_delay);
+	_frame_profiler.StartFrame();
+	{
+		ProfileTimer timer(PFP_WINDOWS);
+		_window_manager.Tick();
+	}
+	{
+		ProfileTimer timer(PFP_GUEST_TICK);
+		_guests.DoTick();
+	}
+	{
+		ProfileTimer timer(PFP_DATE);
+		DateOnTick();
+	}
+	{
+		ProfileTimer timer(PFP_GUEST_ANIMATE);
+		_guests.OnAnimate(frame_delay);
+	}
+	{
+		ProfileTimer timer(PFP_RIDE_ANIMATE);
+		_rides_manager.OnAnimate(frame_delay);
+	}
+	_frame_profiler.EndFrame();
 }
 
 GameControl::GameControl()
@@ -61,24 +84,65 @@ GameControl::GameControl()
 	this->running = false;
 	this->next_action = GCA_NONE;
 	this->fname = "";
+	this->autosave_interval = 0;
+	this->autosave_days = 0;
+	this->autosave_pending = false;
 }
 
 GameControl::~GameControl()
 {
 }
 
-/** Initialize the game controller. */
-void GameControl::Initialize()
+/**
+ * Initialize the game controller.
+ * @param autosave_interval Number of days between two autosaves, \c 0 disables autosaving.
+ * @param fname Name of the saved game to start with, an empty name starts a new game.
+ */
+void GameControl::Initialize(int autosave_interval, const std::string &fname)
 {
+	this->autosave_interval = autosave_interval;
 	this->running = true;
-	this->NewGame();
+	if (fname.empty()) {
+		this->NewGame();
+	} else {
+		this->LoadGame(fname);
+	}
 	this->RunAction();
 }
 
+/**
+ * Simulate a saved game as fast as possible, without displaying it. Afterwards, print the speed of the simulation and the final state of the game.
+ * @param fname Name of the saved game to simulate.
+ * @param days Number of days to simulate.
+ * @return Whether the saved game could be loaded.
+ */
+bool GameControl::RunHeadless(const std::string &fname, int days)
+{
+	if (!LoadGameFile(fname.c_str())) {
+		fprintf(stderr, "Failed to load saved game \"%s\".\n", fname.c_str());
+		return false;
+	}
+	_game_mode_mgr.SetGameMode(GM_PLAY);
+	this->running = true;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < days * TICK_COUNT_PER_DAY; frame++) OnNewFrame(FRAME_DELAY);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("Simulated %d days in %.2f seconds (%.1f days per second).\n", days, seconds, days / std::max(seconds, 0.001));
+	printf("Active guests: %u\n", _guests.CountActiveGuests());
+	printf("Checksum: %08x\n", GetGameChecksum());
+
+	this->running = false;
+	this->ShutdownLevel();
+	return true;
+}
+
 /** Uninitialize the game controller. */
 void GameControl::Uninitialize()
 {
 	this->ShutdownLevel();
+	_background_saver.Wait();
 }
 
 /**
@@ -95,14 +159,17 @@ void GameControl::RunAction()
 			if (this->next_action == GCA_NEW_GAME) {
 				this->NewLevel();
 			} else {
+				_background_saver.Wait(); // The file may still be being written.
 				LoadGameFile(this->fname.c_str());
 			}
+			this->autosave_days = 0;
+			this->autosave_pending = false;
 
 			this->StartLevel();
 			break;
 
 		case GCA_SAVE_GAME:
-			SaveGameFile(this->fname.c_str());
+			_background_saver.Save(this->fname.c_str());
 			break;
 		
 		case GCA_QUIT:
@@ -116,6 +183,25 @@ void GameControl::RunAction()
 	this->next_action = GCA_NONE;
 }
 
+/** A day has passed in the game, autosave the game after the current frame when it is time for it. */
+void GameControl::OnNewDay()
+{
+	if (this->autosave_interval <= 0) return;
+
+	this->autosave_days++;
+	if (this->autosave_days < this->autosave_interval) return;
+	this->autosave_days = 0;
+	this->autosave_pending = true;
+}
+
+/** Save the game to the autosave file. The main thread only copies the game, the file is written in the background. */
+void GameControl::AutoSave()
+{
+	this->autosave_pending = false;
+	_background_saver.Save(AUTOSAVE_FILE);
+	printf("Autosaving to \"%s\", the game was stalled for %.1f ms.\n", AUTOSAVE_FILE, _background_saver.stall_time);
+}
+
 /** Prepare for a #GCA_NEW_GAME action. */
 void GameControl::NewGame()
 {
@@ -10,6 +10,8 @@
 #ifndef GAMECONTROL_H
 #define GAMECONTROL_H
 
+static const uint32 FRAME_DELAY = 30; ///< Number of milliseconds between two frames.
+
 void OnNewDay();
 void OnNewMonth();
 void OnNewYear();
@@ -38,10 +40,13 @@ public:
 	inline void DoNextAction()
 	{
 		if (this->next_action != GCA_NONE) this->RunAction();
+		if (this->autosave_pending) this->AutoSave();
 	}
 
-	void Initialize();
+	void Initialize(int autosave_interval, const std::string &fname);
 	void Uninitialize();
+	bool RunHeadless(const std::string &fname, int days);
+	void OnNewDay();
 
 	void NewGame();
 	void LoadGame(const std::string &fname);
@@ -55,9 +60,14 @@ private:
 	void NewLevel();
 	void StartLevel();
 	void ShutdownLevel();
+	void AutoSave();
 
 	GameControlAction next_action; ///< Action game control wants to run, or #GCA_NONE for 'no action'.
 	std::string fname;             ///< Filename of game level to load from or save to.
+
+	int autosave_interval; ///< Number of days between two autosaves, \c 0 means autosaving is disabled.
+	int autosave_days;     ///< Number of days since the last autosave.
+	bool autosave_pending; ///< Whether the game should be autosaved after the current frame.
 };
 
 extern GameControl _game_control;
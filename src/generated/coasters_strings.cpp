@@ -0,0 +1,10 @@
+// GUI string table for FreeRCT
+// Automagically generated, do not edit
+
+/** Coasters string table array. */
+const char *_coasters_strings_table[] = {
+	"NAME_INSTANCE",
+	"NAME_TYPE",
+	"DESCRIPTION_TYPE",
+	nullptr,
+};
@@ -0,0 +1,16 @@
+// GUI string table for FreeRCT
+// Automagically generated, do not edit
+
+#ifndef COASTERS_STRING_TABLE_H
+#define COASTERS_STRING_TABLE_H
+
+/** Coasters strings table. */
+enum CoastersStrings {
+	COASTERS_NAME_INSTANCE = STR_GENERIC_COASTER_START,
+	COASTERS_NAME_TYPE,
+	COASTERS_DESCRIPTION_TYPE,
+
+	COASTERS_STRING_TABLE_END,
+};
+
+#endif
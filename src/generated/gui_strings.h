@@ -0,0 +1,179 @@
+// GUI string table for FreeRCT
+// Automagically generated, do not edit
+
+#ifndef GUI_STRING_TABLE_H
+#define GUI_STRING_TABLE_H
+
+/** Gui strings table. */
+enum GuiStrings {
+	GUI_TITLEBAR_TIP = STR_GUI_START,
+	GUI_LANGUAGE_NAME,
+	GUI_MONTH_JANUARY,
+	GUI_MONTH_FEBRUARY,
+	GUI_MONTH_MARCH,
+	GUI_MONTH_APRIL,
+	GUI_MONTH_MAY,
+	GUI_MONTH_JUNE,
+	GUI_MONTH_JULY,
+	GUI_MONTH_AUGUST,
+	GUI_MONTH_SEPTEMBER,
+	GUI_MONTH_OCTOBER,
+	GUI_MONTH_NOVEMBER,
+	GUI_MONTH_DECEMBER,
+	GUI_NUMBERED_INSTANCE_NAME,
+	GUI_RESOLUTION,
+	GUI_TOOLBAR_GUI_QUIT,
+	GUI_TOOLBAR_GUI_TOOLTIP_QUIT_PROGRAM,
+	GUI_TOOLBAR_GUI_SETTINGS,
+	GUI_TOOLBAR_GUI_GAME_MODE_EDITOR,
+	GUI_TOOLBAR_GUI_GAME_MODE_PLAY,
+	GUI_TOOLBAR_GUI_TOOLTIP_GAME_MODE,
+	GUI_TOOLBAR_GUI_TOOLTIP_SETTINGS,
+	GUI_TOOLBAR_GUI_PATHS,
+	GUI_TOOLBAR_GUI_TOOLTIP_BUILD_PATHS,
+	GUI_TOOLBAR_GUI_SAVE,
+	GUI_TOOLBAR_GUI_TOOLTIP_SAVE_GAME,
+	GUI_TOOLBAR_GUI_LOAD,
+	GUI_TOOLBAR_GUI_TOOLTIP_LOAD_GAME,
+	GUI_TOOLBAR_GUI_RIDE_SELECT,
+	GUI_TOOLBAR_GUI_TOOLTIP_RIDE_SELECT,
+	GUI_TOOLBAR_GUI_FENCE,
+	GUI_TOOLBAR_GUI_TOOLTIP_FENCE,
+	GUI_TOOLBAR_GUI_TERRAFORM,
+	GUI_TOOLBAR_GUI_TOOLTIP_TERRAFORM,
+	GUI_TOOLBAR_GUI_FINANCES,
+	GUI_TOOLBAR_GUI_TOOLTIP_FINANCES,
+	GUI_BOTTOMBAR_GUESTCOUNT,
+	GUI_QUIT_CAPTION,
+	GUI_QUIT_MESSAGE,
+	GUI_QUIT_NO,
+	GUI_QUIT_YES,
+	GUI_ERROR_MESSAGE_CAPTION,
+	GUI_ERROR_MESSAGE_SPRITE,
+	GUI_GUEST_INFO_MONEY,
+	GUI_GUEST_INFO_MONEY_SPENT,
+	GUI_GUEST_INFO_HAPPINESS,
+	GUI_GUEST_INFO_HUNGER,
+	GUI_GUEST_INFO_THIRST,
+	GUI_GUEST_INFO_WASTE,
+	GUI_GUEST_INFO_ITEMS,
+	GUI_ITEM_NONE,
+	GUI_ITEM_MAP,
+	GUI_ITEM_UMBRELLA,
+	GUI_ITEM_WRAPPER,
+	GUI_PATH_GUI_TITLE,
+	GUI_PATH_GUI_LONG,
+	GUI_PATH_GUI_BUY,
+	GUI_PATH_GUI_REMOVE,
+	GUI_PATH_GUI_LONG_TIP,
+	GUI_PATH_GUI_BUY_TIP,
+	GUI_PATH_GUI_BULLDOZER_TIP,
+	GUI_PATH_GUI_SLOPE_DOWN_TIP,
+	GUI_PATH_GUI_SLOPE_FLAT_TIP,
+	GUI_PATH_GUI_SLOPE_UP_TIP,
+	GUI_PATH_GUI_FORWARD,
+	GUI_PATH_GUI_BACKWARD,
+	GUI_PATH_GUI_FORWARD_TIP,
+	GUI_PATH_GUI_BACKWARD_TIP,
+	GUI_PATH_GUI_NW_DIRECTION_TIP,
+	GUI_PATH_GUI_NE_DIRECTION_TIP,
+	GUI_PATH_GUI_SW_DIRECTION_TIP,
+	GUI_PATH_GUI_SE_DIRECTION_TIP,
+	GUI_PATH_GUI_NORMAL_PATH,
+	GUI_PATH_GUI_QUEUE_PATH,
+	GUI_PATH_GUI_SINGLE,
+	GUI_PATH_GUI_DIRECTIONAL,
+	GUI_PATH_GUI_SINGLE_TIP,
+	GUI_PATH_GUI_DIRECTIONAL_TIP,
+	GUI_RIDE_SELECT_TITLE,
+	GUI_RIDE_SELECT_SHOPS,
+	GUI_RIDE_SELECT_SHOPS_TOOLTIP,
+	GUI_RIDE_SELECT_GENTLE,
+	GUI_RIDE_SELECT_GENTLE_TOOLTIP,
+	GUI_RIDE_SELECT_WET,
+	GUI_RIDE_SELECT_WET_TOOLTIP,
+	GUI_RIDE_SELECT_COASTER,
+	GUI_RIDE_SELECT_COASTER_TOOLTIP,
+	GUI_RIDE_SELECT_RIDE,
+	GUI_RIDE_SELECT_RIDE_TOOLTIP,
+	GUI_RIDE_SELECT_ROT_POS_TOOLTIP,
+	GUI_RIDE_SELECT_ROT_NEG_TOOLTIP,
+	GUI_SHOP_MANAGER_TITLE,
+	GUI_SHOP_MANAGER_COST_PRICE_TEXT,
+	GUI_SHOP_MANAGER_SELLING_PRICE_TEXT,
+	GUI_SHOP_MANAGER_ITEMS_SOLD_TEXT,
+	GUI_SHOP_MANAGER_ITEM_PROFIT_TEXT,
+	GUI_SHOP_MANAGER_SELL_PROFIT_TEXT,
+	GUI_SHOP_MANAGER_SHOP_COST_TEXT,
+	GUI_SHOP_MANAGER_TOTAL_PROFIT_TEXT,
+	GUI_SHOP_MANAGER_OPENED_TEXT,
+	GUI_SHOP_MANAGER_CLOSED_TEXT,
+	GUI_FENCE_TITLE,
+	GUI_TERRAFORM_TITLE,
+	GUI_TERRAFORM_ADD_TEXT,
+	GUI_TERRAFORM_ADD_TOOLTIP,
+	GUI_TERRAFORM_SUB_TEXT,
+	GUI_TERRAFORM_SUB_TOOLTIP,
+	GUI_TERRAFORM_LEVEL_TEXT,
+	GUI_TERRAFORM_MOVE_TEXT,
+	GUI_FINANCES_TITLE,
+	GUI_FINANCES_RIDE_CONSTRUCTION_TEXT,
+	GUI_FINANCES_RIDE_RUNNING_TEXT,
+	GUI_FINANCES_LAND_PURCHASE_TEXT,
+	GUI_FINANCES_LANDSCAPING_TEXT,
+	GUI_FINANCES_PARK_TICKETS_TEXT,
+	GUI_FINANCES_RIDE_TICKETS_TEXT,
+	GUI_FINANCES_SHOP_SALES_TEXT,
+	GUI_FINANCES_SHOP_STOCK_TEXT,
+	GUI_FINANCES_FOOD_SALES_TEXT,
+	GUI_FINANCES_FOOD_STOCK_TEXT,
+	GUI_FINANCES_STAFF_WAGES_TEXT,
+	GUI_FINANCES_MARKETING_TEXT,
+	GUI_FINANCES_RESEARCH_TEXT,
+	GUI_FINANCES_LOAN_INTEREST_TEXT,
+	GUI_FINANCES_TOTAL_TEXT,
+	GUI_COASTER_BUILD_LEFT_BEND_TOOLTIP,
+	GUI_COASTER_BUILD_NO_BEND_TOOLTIP,
+	GUI_COASTER_BUILD_RIGHT_BEND_TOOLTIP,
+	GUI_COASTER_BUILD_BANK_LEFT_TOOLTIP,
+	GUI_COASTER_BUILD_BANK_NONE_TOOLTIP,
+	GUI_COASTER_BUILD_BANK_RIGHT_TOOLTIP,
+	GUI_COASTER_BUILD_BUY_TOOLTIP,
+	GUI_RIDE_BUILD_TITLEBAR_SHOP,
+	GUI_RIDE_BUILD_ROTATE_TOOLTIP,
+	GUI_RIDE_BUILD_DISPLAY_TOOLTIP,
+	GUI_RIDE_BUILD_NAME_TEXT,
+	GUI_RIDE_BUILD_COST_TEXT,
+	GUI_MONEY_CURRENCY_SYMBOL,
+	GUI_MONEY_THOUSANDS_SEPARATOR,
+	GUI_MONEY_DECIMAL_SEPARATOR,
+	GUI_SETTING_TITLE,
+	GUI_SETTING_LANGUAGE,
+	GUI_SETTING_LANGUAGE_TOOLTIP,
+	GUI_SETTING_RESOLUTION,
+	GUI_SETTING_RESOLUTION_TOOLTIP,
+	GUI_PROFILER_TITLE,
+	GUI_PROFILER_PHASE_TEXT,
+	GUI_PROFILER_LAST_TEXT,
+	GUI_PROFILER_AVERAGE_TEXT,
+	GUI_PROFILER_MAXIMUM_TEXT,
+	GUI_PROFILER_WINDOWS_TEXT,
+	GUI_PROFILER_COLLECT_TEXT,
+	GUI_PROFILER_SORT_TEXT,
+	GUI_PROFILER_BLIT_TEXT,
+	GUI_PROFILER_FINISH_REPAINT_TEXT,
+	GUI_PROFILER_GUEST_TICK_TEXT,
+	GUI_PROFILER_DATE_TEXT,
+	GUI_PROFILER_GUEST_ANIMATE_TEXT,
+	GUI_PROFILER_RIDE_ANIMATE_TEXT,
+	GUI_PROFILER_TOTAL_TEXT,
+	GUI_PROFILER_SPRITE_CACHE_HITS_TEXT,
+	GUI_PROFILER_SPRITE_CACHE_MISSES_TEXT,
+	GUI_PROFILER_SPRITE_CACHE_EVICTIONS_TEXT,
+	GUI_PROFILER_TEXT_CACHE_HITS_TEXT,
+	GUI_PROFILER_TEXT_CACHE_MISSES_TEXT,
+
+	GUI_STRING_TABLE_END,
+};
+
+#endif
@@ -0,0 +1,16 @@
+// GUI string table for FreeRCT
+// Automagically generated, do not edit
+
+/** Shops string table array. */
+const char *_shops_strings_table[] = {
+	"NAME_INSTANCE1",
+	"NAME_INSTANCE2",
+	"NAME_TYPE",
+	"NAME_ITEM1",
+	"NAME_ITEM2",
+	"DESCRIPTION_TYPE",
+	"DESCRIPTION_RECOLOUR1",
+	"DESCRIPTION_RECOLOUR2",
+	"DESCRIPTION_RECOLOUR3",
+	nullptr,
+};
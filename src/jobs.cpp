@@ -0,0 +1,109 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file jobs.cpp Pool of worker threads for running independent jobs in parallel. */
+
+#include "stdafx.h"
+#include "jobs.h"
+
+JobPool _job_pool; ///< Worker threads of the game.
+
+JobPool::JobPool() : stopping(false), batch(0), busy_workers(0), job_count(0), job(nullptr), next_job(0)
+{
+}
+
+JobPool::~JobPool()
+{
+	this->Shutdown();
+}
+
+/**
+ * Start the worker threads.
+ * @param worker_count Number of worker threads to start, a negative number starts one thread less than the number of processors.
+ */
+void JobPool::Initialize(int worker_count)
+{
+	assert(this->workers.empty());
+	if (worker_count < 0) worker_count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+	this->stopping = false;
+	for (int i = 0; i < worker_count; i++) this->workers.emplace_back(&JobPool::WorkerMain, this);
+}
+
+/** Stop the worker threads. Jobs handed to the pool after this run at the calling thread. */
+void JobPool::Shutdown()
+{
+	if (this->workers.empty()) return;
+
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->stopping = true;
+	}
+	this->wake_up.notify_all();
+	for (std::thread &worker : this->workers) worker.join();
+	this->workers.clear();
+}
+
+/**
+ * Run a batch of jobs, and wait until all jobs are done. The calling thread also runs jobs.
+ * @param job_count Number of jobs in the batch.
+ * @param job Job to run, called with every job number from \c 0 to \a job_count.
+ */
+void JobPool::Run(uint job_count, const std::function<void(uint)> &job)
+{
+	if (this->workers.empty() || job_count <= 1) {
+		for (uint i = 0; i < job_count; i++) job(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->job_count = job_count;
+		this->job = &job;
+		this->next_job = 0;
+		this->busy_workers = this->workers.size();
+		this->batch++;
+	}
+	this->wake_up.notify_all();
+
+	this->RunJobs();
+
+	/* Every worker must have seen the batch before the next batch can start. */
+	std::unique_lock<std::mutex> guard(this->lock);
+	this->done.wait(guard, [this]{ return this->busy_workers == 0; });
+	this->job = nullptr;
+}
+
+/** Run jobs of the current batch until all jobs have been taken. */
+void JobPool::RunJobs()
+{
+	for (;;) {
+		uint number = this->next_job++;
+		if (number >= this->job_count) return;
+		(*this->job)(number);
+	}
+}
+
+/** Main function of a worker thread, runs jobs of every batch until the pool stops. */
+void JobPool::WorkerMain()
+{
+	uint seen_batch = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> guard(this->lock);
+			this->wake_up.wait(guard, [this, seen_batch]{ return this->stopping || this->batch != seen_batch; });
+			if (this->stopping) return;
+			seen_batch = this->batch;
+		}
+
+		this->RunJobs();
+
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->busy_workers--;
+		if (this->busy_workers == 0) this->done.notify_one();
+	}
+}
@@ -0,0 +1,61 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file jobs.h Pool of worker threads for running independent jobs in parallel. */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Pool of worker threads. A batch of jobs is handed to the pool with #Run, which returns when all jobs are done.
+ * Jobs of a batch may run in any order and at the same time, they should not change data shared with other jobs.
+ */
+class JobPool {
+public:
+	JobPool();
+	~JobPool();
+
+	void Initialize(int worker_count);
+	void Shutdown();
+	void Run(uint job_count, const std::function<void(uint)> &job);
+
+	/**
+	 * Get the number of worker threads of the pool.
+	 * @return Number of threads running jobs next to the thread calling #Run.
+	 */
+	inline uint GetWorkerCount() const
+	{
+		return this->workers.size();
+	}
+
+private:
+	std::vector<std::thread> workers; ///< Worker threads.
+	std::mutex lock;                  ///< Lock protecting the batch data below.
+	std::condition_variable wake_up;  ///< Signal to the workers that a new batch is available or the pool stops.
+	std::condition_variable done;     ///< Signal to #Run that all workers finished their part of the batch.
+
+	bool stopping;                        ///< Whether the workers should stop.
+	uint batch;                           ///< Number of the current batch.
+	uint busy_workers;                    ///< Number of workers that did not finish the current batch yet.
+	uint job_count;                       ///< Number of jobs in the current batch.
+	const std::function<void(uint)> *job; ///< Job to run for every job number of the current batch.
+	std::atomic<uint> next_job;           ///< Number of the next job to run.
+
+	void RunJobs();
+	void WorkerMain();
+};
+
+extern JobPool _job_pool;
+
+#endif
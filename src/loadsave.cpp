@@ -15,17 +15,27 @@
 #include "string_func.h"
 #include "person.h"
 #include "people.h"
+#include <chrono>
+
+static const uint LOAD_BUFFER_SIZE = 64 * 1024; ///< Size of the buffer for reading a saved game.
+static const uint SAVE_BUFFER_SIZE = 64 * 1024; ///< Size of the buffer for writing a saved game.
+
+int _save_compression = 6; ///< Zlib compression level of saved games, \c 0 saves without compression.
+BackgroundSaver _background_saver; ///< Saving of games at a background thread.
 
 /**
  * Constructor of the loader class.
  * @param fp Input file stream. Use \c nullptr for initialization to default.
  */
-Loader::Loader(FILE *fp)
+Loader::Loader(gzFile fp)
 {
 	this->fail_msg = nullptr;
 	this->blk_name = nullptr;
 	this->fp = fp;
 	this->cache_count = 0;
+	this->buffer_pos = 0;
+	this->buffer_end = 0;
+	if (fp != nullptr) this->buffer.resize(LOAD_BUFFER_SIZE);
 }
 
 /**
@@ -92,12 +102,24 @@ uint8 Loader::GetByte()
 		this->cache_count--;
 		return this->cache[this->cache_count];
 	}
-	int k = getc(this->fp);
-	if (k == EOF) {
-		this->SetFailMessage("EOF encountered");
-		return 0;
+	if (this->buffer_pos == this->buffer_end && !this->FillBuffer()) return 0;
+	return this->buffer[this->buffer_pos++];
+}
+
+/**
+ * Read the next chunk of the stream into the buffer.
+ * @return Whether data was read.
+ */
+bool Loader::FillBuffer()
+{
+	int count = gzread(this->fp, this->buffer.data(), this->buffer.size());
+	if (count <= 0) {
+		this->SetFailMessage((count == 0) ? "EOF encountered" : "Error while reading the file");
+		return false;
 	}
-	return k;
+	this->buffer_pos = 0;
+	this->buffer_end = count;
+	return true;
 }
 
 /**
@@ -118,6 +140,12 @@ void Loader::PutByte(uint8 val)
  */
 uint16 Loader::GetWord()
 {
+	if (this->cache_count == 0 && this->buffer_end - this->buffer_pos >= 2 && !this->IsFail()) {
+		const uint8 *p = &this->buffer[this->buffer_pos];
+		this->buffer_pos += 2;
+		return p[0] | (p[1] << 8);
+	}
+
 	uint16 v = this->GetByte();
 	uint16 w = this->GetByte();
 	return v | (w << 8);
@@ -129,6 +157,12 @@ uint16 Loader::GetWord()
  */
 uint32 Loader::GetLong()
 {
+	if (this->cache_count == 0 && this->buffer_end - this->buffer_pos >= 4 && !this->IsFail()) {
+		const uint8 *p = &this->buffer[this->buffer_pos];
+		this->buffer_pos += 4;
+		return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32)p[3] << 24);
+	}
+
 	uint32 v = this->GetWord();
 	uint32 w = this->GetWord();
 	return v | (w << 16);
@@ -203,12 +237,14 @@ bool Loader::IsFail() const
 
 /**
  * Constructor for the saver.
- * @param fp Output file stream to write to.
+ * @param fp Output file stream to write to. Use \c nullptr to keep the data in memory.
  */
-Saver::Saver(FILE *fp)
+Saver::Saver(gzFile fp) : buffer(SAVE_BUFFER_SIZE)
 {
 	this->fp = fp;
 	this->blk_name = nullptr;
+	this->buffer_pos = 0;
+	this->failed = false;
 }
 
 /**
@@ -240,7 +276,8 @@ void Saver::EndBlock()
  */
 void Saver::PutByte(uint8 val)
 {
-	putc(val, this->fp);
+	if (this->buffer_pos == this->buffer.size()) this->MakeRoom();
+	this->buffer[this->buffer_pos++] = val;
 }
 
 /**
@@ -249,6 +286,14 @@ void Saver::PutByte(uint8 val)
  */
 void Saver::PutWord(uint16 val)
 {
+	if (this->buffer.size() - this->buffer_pos >= 2) {
+		uint8 *p = &this->buffer[this->buffer_pos];
+		p[0] = val;
+		p[1] = val >> 8;
+		this->buffer_pos += 2;
+		return;
+	}
+
 	this->PutByte(val);
 	this->PutByte(val >> 8);
 }
@@ -259,6 +304,16 @@ void Saver::PutWord(uint16 val)
  */
 void Saver::PutLong(uint32 val)
 {
+	if (this->buffer.size() - this->buffer_pos >= 4) {
+		uint8 *p = &this->buffer[this->buffer_pos];
+		p[0] = val;
+		p[1] = val >> 8;
+		p[2] = val >> 16;
+		p[3] = val >> 24;
+		this->buffer_pos += 4;
+		return;
+	}
+
 	this->PutWord(val);
 	this->PutWord(val >> 16);
 }
@@ -309,6 +364,44 @@ void Saver::PutText(const uint8 *str, int length)
 	assert(count == 0);
 }
 
+/** Make room in the full buffer, by writing it to the output stream, or by growing it when the data is kept in memory. */
+void Saver::MakeRoom()
+{
+	if (this->fp == nullptr) {
+		this->buffer.resize(this->buffer.size() * 2);
+	} else {
+		this->Flush();
+	}
+}
+
+/**
+ * Write the buffered data to the output stream.
+ * @return Whether all data so far was written successfully.
+ */
+bool Saver::Flush()
+{
+	if (this->fp == nullptr) return true;
+
+	if (this->buffer_pos > 0 && gzwrite(this->fp, this->buffer.data(), this->buffer_pos) != (int)this->buffer_pos) this->failed = true;
+	this->buffer_pos = 0;
+	return !this->failed;
+}
+
+/**
+ * Take the data saved in memory.
+ * @param data [out] Saved data.
+ * @pre The saver has no output stream.
+ */
+void Saver::TakeData(std::vector<uint8> *data)
+{
+	assert(this->fp == nullptr);
+	this->buffer.resize(this->buffer_pos);
+	data->swap(this->buffer);
+	this->buffer.clear();
+	this->buffer.resize(SAVE_BUFFER_SIZE);
+	this->buffer_pos = 0;
+}
+
 /**
  * Load the game elements from the input stream.
  * @param ldr Input stream to load from.
@@ -357,17 +450,17 @@ static void SaveElements(Saver &svr)
  */
 bool LoadGameFile(const char *fname)
 {
-	FILE *fp;
+	gzFile fp;
 
 	if (fname == nullptr) {
 		fp = nullptr;
 	} else {
-		fp = fopen(fname, "rb");
+		fp = gzopen(fname, "rb");
 		if (fp == nullptr) return false;
 	}
 	Loader ldr(fp);
 	LoadElements(ldr);
-	if (fp != nullptr) fclose(fp);
+	if (fp != nullptr) gzclose(fp);
 	if (!ldr.IsFail()) return true;
 
 	Loader reset(nullptr);
@@ -375,6 +468,24 @@ bool LoadGameFile(const char *fname)
 	return false;
 }
 
+/**
+ * Open a file for writing a saved game.
+ * @param fname Name of the file to write.
+ * @param compression Zlib compression level, \c 0 writes without compression.
+ * @return The opened output stream, or \c nullptr if the file could not be opened.
+ */
+static gzFile OpenSaveFile(const char *fname, int compression)
+{
+	/* Mode "wbT" writes the file without compression. */
+	char mode[8];
+	if (compression > 0) {
+		snprintf(mode, lengthof(mode), "wb%d", std::min(compression, 9));
+	} else {
+		strcpy(mode, "wbT");
+	}
+	return gzopen(fname, mode);
+}
+
 /**
  * Save the current game state to file.
  * @param fname Name of the file to write.
@@ -382,11 +493,82 @@ bool LoadGameFile(const char *fname)
  */
 bool SaveGameFile(const char *fname)
 {
-	FILE *fp = fopen(fname, "wb");
+	gzFile fp = OpenSaveFile(fname, _save_compression);
 	if (fp == nullptr) return false;
 	Saver svr(fp);
 	SaveElements(svr);
-	fclose(fp);
-	return true;
+	bool success = svr.Flush();
+	if (gzclose(fp) != Z_OK) success = false;
+	return success;
+}
+
+/**
+ * Compute a checksum of the current game state, for comparing the state of games.
+ * @return CRC-32 checksum of the game as it would be saved.
+ */
+uint32 GetGameChecksum()
+{
+	Saver svr(nullptr);
+	SaveElements(svr);
+	std::vector<uint8> data;
+	svr.TakeData(&data);
+	return crc32(0L, data.data(), data.size());
+}
+
+BackgroundSaver::BackgroundSaver()
+{
+	this->stall_time = 0.0;
+	this->compression = 0;
+	this->success = true;
+}
+
+BackgroundSaver::~BackgroundSaver()
+{
+	this->Wait();
+}
+
+/**
+ * Save the current game state to file. The game is copied into memory, the file is written at a background thread.
+ * A previous save that is still being written is finished first.
+ * @param fname Name of the file to write.
+ */
+void BackgroundSaver::Save(const char *fname)
+{
+	auto start = std::chrono::steady_clock::now();
+	this->Wait();
+
+	Saver svr(nullptr);
+	SaveElements(svr);
+	svr.TakeData(&this->data);
+
+	this->fname = fname;
+	this->compression = _save_compression;
+	this->thread = std::thread(&BackgroundSaver::WriteData, this);
+
+	this->stall_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
+/**
+ * Wait until the background thread finished writing the last saved game.
+ * @return Whether writing the last saved game succeeded.
+ */
+bool BackgroundSaver::Wait()
+{
+	if (this->thread.joinable()) {
+		this->thread.join();
+		if (!this->success) fprintf(stderr, "Failed to write saved game \"%s\".\n", this->fname.c_str());
+	}
+	return this->success;
+}
+
+/** Compress and write the saved game, runs at the background thread. */
+void BackgroundSaver::WriteData()
+{
+	this->success = false;
+	gzFile fp = OpenSaveFile(this->fname.c_str(), this->compression);
+	if (fp != nullptr) {
+		this->success = gzwrite(fp, this->data.data(), this->data.size()) == (int)this->data.size();
+		if (gzclose(fp) != Z_OK) this->success = false;
+	}
+	std::vector<uint8>().swap(this->data); // Release the memory.
+}
@@ -10,10 +10,18 @@
 #ifndef LOADSAVE_H
 #define LOADSAVE_H
 
-/** Class for loading a save game. */
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+/**
+ * Class for loading a save game. The file is read in large chunks through zlib, which reads both
+ * compressed and uncompressed files (detected from the gzip header at the start of the file).
+ */
 class Loader {
 public:
-	Loader(FILE *fp);
+	Loader(gzFile fp);
 
 	uint32 OpenBlock(const char *name, bool may_fail = false);
 	void CloseBlock();
@@ -30,19 +38,27 @@ public:
 
 private:
 	void PutByte(uint8 val);
+	bool FillBuffer();
 
 	const char *fail_msg; ///< If not \c nullptr, message of failure.
 	const char *blk_name; ///< Name of the current block.
 
-	FILE *fp;             ///< Data stream being loaded.
+	gzFile fp;            ///< Data stream being loaded.
 	int cache_count;      ///< Number of values in #cache.
 	uint8 cache[8];       ///< Stack with temporary values to return on next read.
+
+	std::vector<uint8> buffer; ///< Data read from the stream.
+	uint buffer_pos;           ///< Position of the next byte to return in #buffer.
+	uint buffer_end;           ///< End of the valid data in #buffer.
 };
 
-/** Class for saving a savegame. */
+/**
+ * Class for saving a savegame. Data is collected in a large buffer, and written through zlib.
+ * Without output stream, all data is kept in memory (see #TakeData).
+ */
 class Saver {
 public:
-	Saver(FILE *fp);
+	Saver(gzFile fp);
 
 	void StartBlock(const char *name, uint32 version);
 	void EndBlock();
@@ -53,12 +69,49 @@ public:
 	void PutLongLong(uint64 val);
 	void PutText(const uint8 *str, int length = -1);
 
+	bool Flush();
+	void TakeData(std::vector<uint8> *data);
+
 private:
-	FILE *fp; ///< Output file stream.
+	void MakeRoom();
+
+	gzFile fp; ///< Output file stream, \c nullptr means the data is kept in memory.
 	const char *blk_name; ///< Name of the current block.
+
+	std::vector<uint8> buffer; ///< Data waiting to be written.
+	uint buffer_pos;           ///< Number of bytes in #buffer.
+	bool failed;               ///< Whether writing to the stream failed.
 };
 
+/**
+ * Saving of games at a background thread. The game is serialized into memory at the main thread,
+ * compressing and writing the data to the file happens at the background thread.
+ */
+class BackgroundSaver {
+public:
+	BackgroundSaver();
+	~BackgroundSaver();
+
+	void Save(const char *fname);
+	bool Wait();
+
+	double stall_time; ///< Number of milliseconds the main thread was stalled by the last #Save.
+
+private:
+	void WriteData();
+
+	std::thread thread;       ///< Thread writing the data, if it is running.
+	std::string fname;        ///< Name of the file being written.
+	int compression;          ///< Compression level of the file being written.
+	std::vector<uint8> data;  ///< Serialized game being written.
+	bool success;             ///< Whether writing the file succeeded.
+};
+
+extern int _save_compression;
+extern BackgroundSaver _background_saver;
+
 bool LoadGameFile(const char *fname);
 bool SaveGameFile(const char *fname);
+uint32 GetGameChecksum();
 
 #endif
@@ -17,6 +17,9 @@
 #include "viewport.h"
 #include "math_func.h"
 #include "sprite_store.h"
+#include "path_graph.h"
+#include <vector>
+#include <algorithm>
 
 /**
  * The game world.
@@ -24,47 +27,15 @@
  */
 VoxelWorld _world;
 
-/**
- * Move the list animated voxel objects to the destination.
- * @param dest Destination of the voxel object list.
- * @param src Source voxel objects.
- */
-static inline void CopyVoxelObjectList(Voxel *dest, Voxel *src)
-{
-	dest->voxel_objects = src->voxel_objects;
-	src->voxel_objects = nullptr;
-}
-
-/**
- * Copy a voxel.
- * @param dest Destination address.
- * @param src Source address.
- * @param copy_voxel_objects Copy/move the voxel objects too.
- */
-static inline void CopyVoxel(Voxel *dest, Voxel *src, bool copy_voxel_objects)
-{
-	dest->instance = src->instance;
-	dest->instance_data = src->instance_data;
-	dest->ground = src->ground;
-	dest->fences = src->fences;
-	if (copy_voxel_objects) CopyVoxelObjectList(dest, src);
-}
-
 /**
  * Copy a stack of voxels.
  * @param dest Destination address.
  * @param src Source address.
  * @param count Number of voxels to copy.
- * @param copy_voxel_objects Copy the voxel object list too.
  */
-static void CopyStackData(Voxel *dest, Voxel *src, int count, bool copy_voxel_objects)
+static void CopyStackData(Voxel *dest, const Voxel *src, int count)
 {
-	while (count > 0) {
-		CopyVoxel(dest, src, copy_voxel_objects);
-		dest++;
-		src++;
-		count--;
-	}
+	std::copy(src, src + count, dest);
 }
 
 /** Make the voxel empty. */
@@ -87,10 +58,11 @@ void Voxel::Load(Loader &ldr, uint32 version)
 	this->ClearVoxel();
 	if (version >= 1 && version <= 3) {
 		this->ground = ldr.GetLong(); /// \todo Check sanity of the data.
-		this->instance = ldr.GetByte();
-		if (this->instance == SRI_FREE) {
+		uint8 instance = ldr.GetByte();
+		this->SetInstance((SmallRideInstance)instance);
+		if (instance == SRI_FREE) {
 			this->instance_data = 0; // Full rides load after the world, overwriting map data.
-		} else if (this->instance >= SRI_RIDES_START && this->instance < SRI_FULL_RIDES) {
+		} else if (instance >= SRI_RIDES_START && instance < SRI_FULL_RIDES) {
 			this->instance_data = ldr.GetWord();
 		} else {
 			this->instance_data = 0; // Full rides load after the world, overwriting map data.
@@ -104,40 +76,115 @@ void Voxel::Load(Loader &ldr, uint32 version)
 }
 
 /**
- * Write a voxel to the save game.
- * @param svr Output stream to write.
+ * Initialize voxels to 'empty'.
+ * @param voxels First voxel to initialize.
+ * @param count Number of voxels to initialize.
  */
-void Voxel::Save(Saver &svr) const
+static void ClearNewVoxels(Voxel *voxels, int count)
 {
-	svr.PutLong(this->ground);
-	if (this->instance >= SRI_RIDES_START && this->instance < SRI_FULL_RIDES) {
-		svr.PutByte(this->instance);
-		svr.PutWord(this->instance_data);
-	} else {
-		svr.PutByte(SRI_FREE); // Full rides save their own data from the world.
+	for (int i = 0; i < count; i++) {
+		voxels[i] = Voxel();
+		voxels[i].ClearVoxel();
 	}
-	svr.PutWord(this->fences);
+}
+
+VoxelArena::VoxelArena()
+{
+	this->used_slabs = 0;
+	this->free_start = nullptr;
+	this->free_count = 0;
+}
+
+/**
+ * Get the capacity of the voxel array for a stack.
+ * @param height Number of voxels in the stack.
+ * @return Smallest capacity of an array that fits the voxels.
+ */
+uint16 VoxelArena::GetCapacity(uint16 height)
+{
+	assert(height > 0 && height <= WORLD_Z_SIZE);
+	uint16 capacity = VOXEL_ARENA_MIN_CAPACITY;
+	while (capacity < height) capacity *= 2;
+	return capacity;
+}
+
+/**
+ * Get the class of arrays with a given capacity.
+ * @param capacity Capacity of the array, as returned by #GetCapacity.
+ * @return Index of the class in #free_arrays.
+ */
+int VoxelArena::GetCapacityClass(uint16 capacity)
+{
+	int cls = 0;
+	while ((VOXEL_ARENA_MIN_CAPACITY << cls) < capacity) cls++;
+	assert(cls < VOXEL_ARENA_CLASS_COUNT && (VOXEL_ARENA_MIN_CAPACITY << cls) == capacity);
+	return cls;
 }
 
 /**
- * Make a new array of voxels, and initialize it.
- * @param height Desired height of the new voxel array.
- * @return New and initialized to 'empty' voxels. Caller should delete[] the memory after use.
+ * Allocate an array of voxels. The voxels are not initialized.
+ * @param capacity Number of voxels in the array, as returned by #GetCapacity.
+ * @return The allocated array.
  */
-static Voxel *MakeNewVoxels(int height)
+Voxel *VoxelArena::Allocate(uint16 capacity)
 {
-	assert(height > 0);
-	Voxel *voxels = new Voxel[height]();
-	for (int i = 0; i < height; i++) voxels[i].ClearVoxel();
+	std::vector<Voxel *> &free_list = this->free_arrays[GetCapacityClass(capacity)];
+	if (!free_list.empty()) {
+		Voxel *voxels = free_list.back();
+		free_list.pop_back();
+		return voxels;
+	}
+
+	if (this->free_count < capacity) this->NextSlab();
+	Voxel *voxels = this->free_start;
+	this->free_start += capacity;
+	this->free_count -= capacity;
 	return voxels;
 }
 
+/**
+ * Return an array of voxels to the arena.
+ * @param voxels Array to release.
+ * @param capacity Number of voxels in the array.
+ */
+void VoxelArena::Release(Voxel *voxels, uint16 capacity)
+{
+	this->free_arrays[GetCapacityClass(capacity)].push_back(voxels);
+}
+
+/** Start carving arrays from the next slab, allocating it if needed. */
+void VoxelArena::NextSlab()
+{
+	/* The remainder of the current slab is smaller than the largest array, hand it out as smaller arrays. */
+	for (int cls = VOXEL_ARENA_CLASS_COUNT - 1; cls >= 0; cls--) {
+		uint16 capacity = VOXEL_ARENA_MIN_CAPACITY << cls;
+		if (this->free_count < capacity) continue;
+
+		this->Release(this->free_start, capacity);
+		this->free_start += capacity;
+		this->free_count -= capacity;
+	}
+
+	if (this->used_slabs == this->slabs.size()) this->slabs.emplace_back(new Voxel[VOXEL_ARENA_SLAB_SIZE]);
+	this->free_start = this->slabs[this->used_slabs].get();
+	this->free_count = VOXEL_ARENA_SLAB_SIZE;
+	this->used_slabs++;
+}
+
+/** Release all voxel arrays at once. The slabs are kept for reuse. */
+void VoxelArena::Reset()
+{
+	for (std::vector<Voxel *> &free_list : this->free_arrays) free_list.clear();
+	this->used_slabs = 0;
+	this->free_start = nullptr;
+	this->free_count = 0;
+}
+
 VoxelObject::~VoxelObject()
 {
 	if (this->added) {
 		this->MarkDirty();
-		Voxel *v = _world.GetCreateVoxel(this->vox_pos, false);
-		this->RemoveSelf(v);
+		this->RemoveSelf();
 	}
 }
 
@@ -150,10 +197,43 @@ VoxelObject::~VoxelObject()
  * @return Sprite to display for the voxel object.
  */
 
+/** Add itself to the voxel objects chain of the voxel at #vox_pos. */
+void VoxelObject::AddSelf()
+{
+	assert(!this->added);
+	this->added = true;
+
+	VoxelChunk *chunk = _world.GetModifyChunk(this->vox_pos.x, this->vox_pos.y);
+	uint16 key = VoxelChunk::GetObjectKey(this->vox_pos);
+	this->next_object = chunk->GetVoxelObjects(key);
+	if (this->next_object != nullptr) this->next_object->prev_object = this;
+	chunk->SetVoxelObjects(key, this);
+	this->prev_object = nullptr;
+	chunk->object_count++;
+}
+
+/** Remove itself from the voxel objects chain of the voxel at #vox_pos. */
+void VoxelObject::RemoveSelf()
+{
+	assert(this->added);
+	this->added = false;
+
+	VoxelChunk *chunk = _world.GetModifyChunk(this->vox_pos.x, this->vox_pos.y);
+	if (this->next_object != nullptr) this->next_object->prev_object = this->prev_object;
+	if (this->prev_object != nullptr) {
+		this->prev_object->next_object = this->next_object;
+	} else {
+		uint16 key = VoxelChunk::GetObjectKey(this->vox_pos);
+		assert(chunk->GetVoxelObjects(key) == this);
+		chunk->SetVoxelObjects(key, this->next_object);
+	}
+	chunk->object_count--;
+}
+
 /** Mark the voxel containing the voxel object as dirty, so it is repainted. */
 void VoxelObject::MarkDirty()
 {
-	MarkVoxelDirty(this->vox_pos);
+	MarkVoxelObjectDirty(this->vox_pos);
 }
 
 /**
@@ -191,26 +271,46 @@ VoxelStack::VoxelStack()
 	this->voxels = nullptr;
 	this->base = 0;
 	this->height = 0;
-}
-
-/** Destructor. */
-VoxelStack::~VoxelStack()
-{
-	delete[] this->voxels;
+	this->chunk = nullptr;
+	this->capacity = 0;
+	this->owner = OWN_NONE;
 }
 
 /** Remove the stack. */
 void VoxelStack::Clear()
 {
-	delete[] this->voxels;
+	if (this->voxels != nullptr) this->chunk->arena->Release(this->voxels, this->capacity);
 	this->voxels = nullptr;
+	this->capacity = 0;
 	this->base = 0;
 	this->height = 0;
 	this->owner = OWN_NONE;
 }
 
 /**
- * (Re)Allocate a voxel stack.
+ * Replace the voxels of the stack by empty voxels.
+ * @param new_base New base voxel height.
+ * @param new_height New number of voxels in the stack.
+ */
+void VoxelStack::Allocate(int16 new_base, uint16 new_height)
+{
+	assert(new_base >= 0 && new_base + new_height <= WORLD_Z_SIZE);
+
+	uint16 new_capacity = (new_height > 0) ? VoxelArena::GetCapacity(new_height) : 0;
+	if (new_capacity != this->capacity) {
+		if (this->voxels != nullptr) this->chunk->arena->Release(this->voxels, this->capacity);
+		this->voxels = (new_capacity > 0) ? this->chunk->arena->Allocate(new_capacity) : nullptr;
+		this->capacity = new_capacity;
+	}
+	ClearNewVoxels(this->voxels, new_height);
+	this->base = new_base;
+	this->height = new_height;
+	if (new_height > 0) this->chunk->ExtendHeightRange(new_base, new_height);
+}
+
+/**
+ * Grow a voxel stack. The stack is extended in place if its array has enough capacity, else it moves to an array
+ * with the next larger capacity.
  * @param new_base New base voxel height.
  * @param new_height New number of voxels in the stack.
  * @return New stack could be created.
@@ -222,14 +322,24 @@ bool VoxelStack::MakeVoxelStack(int16 new_base, uint16 new_height)
 	/* Make sure the voxels live between 0 and WORLD_Z_SIZE. */
 	if (new_base < 0 || new_base + (int)new_height > WORLD_Z_SIZE) return false;
 
-	Voxel *new_voxels = MakeNewVoxels(new_height);
 	assert(this->height == 0 || (this->base >= new_base && this->base + this->height <= new_base + new_height));
-	CopyStackData(new_voxels + (this->base - new_base), this->voxels, this->height, true);
+	int below = (this->height == 0) ? 0 : this->base - new_base; // Number of new voxels below the old stack.
+	if (new_height > this->capacity) {
+		uint16 new_capacity = VoxelArena::GetCapacity(new_height);
+		Voxel *new_voxels = this->chunk->arena->Allocate(new_capacity);
+		CopyStackData(new_voxels + below, this->voxels, this->height);
+		if (this->voxels != nullptr) this->chunk->arena->Release(this->voxels, this->capacity);
+		this->voxels = new_voxels;
+		this->capacity = new_capacity;
+	} else if (below > 0) {
+		std::copy_backward(this->voxels, this->voxels + this->height, this->voxels + below + this->height);
+	}
+	ClearNewVoxels(this->voxels, below);
+	ClearNewVoxels(this->voxels + below + this->height, new_height - below - this->height);
 
-	delete[] this->voxels;
-	this->voxels = new_voxels;
 	this->height = new_height;
 	this->base = new_base;
+	this->chunk->ExtendHeightRange(new_base, new_height);
 	return true;
 }
 
@@ -288,16 +398,16 @@ VoxelWorld::VoxelWorld()
  */
 void VoxelWorld::SetWorldSize(uint16 xs, uint16 ys)
 {
-	assert(xs < WORLD_X_SIZE);
-	assert(ys < WORLD_Y_SIZE);
+	assert(xs <= WORLD_X_SIZE);
+	assert(ys <= WORLD_Y_SIZE);
 
 	this->x_size = xs;
 	this->y_size = ys;
 
 	/* Clear the world. */
-	for (uint pos = 0; pos < WORLD_X_SIZE * WORLD_Y_SIZE; pos++) {
-		this->stacks[pos].Clear();
-	}
+	for (std::unique_ptr<VoxelChunk> &chunk : this->chunks) chunk.reset();
+	this->arena.Reset();
+	_path_graph.Clear();
 }
 
 /**
@@ -356,9 +466,7 @@ void VoxelStack::MoveStack(VoxelStack *vs)
 	int vs_first = 0;
 	int vs_last = 0;
 	for (int i = 0; i < (int)vs->height; i++) {
-		Voxel *v = &vs->voxels[i];
-		assert(!v->HasVoxelObjects()); // There should be no voxel objects in the stack being moved.
-
+		const Voxel *v = &vs->voxels[i];
 		if (!v->IsEmpty()) {
 			vs_last = i;
 		} else {
@@ -369,12 +477,11 @@ void VoxelStack::MoveStack(VoxelStack *vs)
 	/* There should be at least one surface voxel. */
 	assert(vs_first <= vs_last);
 
-	/* Examine current stack with respect to persons. */
+	/* Examine current stack with respect to persons, they must stay inside the stack. */
 	int old_first = 0;
 	int old_last = 0;
 	for (int i = 0; i < (int)this->height; i++) {
-		const Voxel *v = &this->voxels[i];
-		if (v->HasVoxelObjects()) {
+		if (this->chunk->GetVoxelObjects(this->chunk->GetObjectKey(this, this->base + i)) != nullptr) {
 			old_last = i;
 		} else {
 			if (old_first == i) old_first++;
@@ -385,20 +492,18 @@ void VoxelStack::MoveStack(VoxelStack *vs)
 	int new_height = std::max(vs->base + vs_last, this->base + old_last) - new_base + 1;
 	assert(new_base >= 0);
 
-	/* Make a new stack. Copy new surface, then copy the persons. */
-	Voxel *new_voxels = MakeNewVoxels(new_height);
-	CopyStackData(new_voxels + (vs->base + vs_first) - new_base, vs->voxels + vs_first, vs_last - vs_first + 1, false);
-	int i = (this->base + old_first) - new_base;
-	while (old_first <= old_last) {
-		CopyVoxelObjectList(&new_voxels[i], &this->voxels[old_first]);
-		i++;
-		old_first++;
-	}
+	/* Make a new stack, and copy the new surface. The persons are stored at the chunk, and do not move. */
+	uint16 new_capacity = VoxelArena::GetCapacity(new_height);
+	Voxel *new_voxels = this->chunk->arena->Allocate(new_capacity);
+	ClearNewVoxels(new_voxels, new_height);
+	CopyStackData(new_voxels + (vs->base + vs_first) - new_base, vs->voxels + vs_first, vs_last - vs_first + 1);
 
 	this->base = new_base;
 	this->height = new_height;
-	delete[] this->voxels;
+	if (this->voxels != nullptr) this->chunk->arena->Release(this->voxels, this->capacity);
 	this->voxels = new_voxels;
+	this->capacity = new_capacity;
+	this->chunk->ExtendHeightRange(new_base, new_height);
 }
 
 /**
@@ -442,11 +547,8 @@ void VoxelStack::Load(Loader &ldr)
 		if (base < 0 || base + height > WORLD_Z_SIZE || owner >= OWN_COUNT) {
 			ldr.SetFailMessage("Incorrect voxel stack size");
 		} else {
-			this->base = base;
-			this->height = height;
+			this->Allocate(base, height);
 			this->owner = (TileOwner)owner;
-			delete[] this->voxels;
-			this->voxels = (height > 0) ? MakeNewVoxels(height) : nullptr;
 			for (uint i = 0; i < height; i++) this->voxels[i].Load(ldr, version);
 
 			/* In version 3 of VSTK, the fences of the lowest corner of steep slopes have moved from the top voxel to the base voxel. */
@@ -484,48 +586,137 @@ void VoxelStack::Load(Loader &ldr)
 	ldr.CloseBlock();
 }
 
+VoxelObjectTable::VoxelObjectTable()
+{
+	this->used = 0;
+}
+
 /**
- * Save a voxel stack to the save game file.
- * @param svr Output stream to write.
+ * Set the first voxel object of a voxel.
+ * @param key Key of the voxel.
+ * @param first First voxel object of the voxel, \c nullptr removes the voxel from the table.
  */
-void VoxelStack::Save(Saver &svr) const
+void VoxelObjectTable::Set(uint16 key, VoxelObject *first)
 {
-	svr.StartBlock("VSTK", 3);
-	svr.PutWord(this->base);
-	svr.PutWord(this->height);
-	svr.PutByte(this->owner);
-	for (uint i = 0; i < this->height; i++) this->voxels[i].Save(svr);
-	svr.EndBlock();
+	assert(key != FREE_KEY);
+	if (first != nullptr && (this->used + 1) * 4 > this->entries.size() * 3) {
+		this->Resize(std::max<uint32>(this->entries.size() * 2, 16));
+	}
+	if (this->entries.empty()) return;
+
+	uint32 mask = this->entries.size() - 1;
+	for (uint32 i = GetHash(key) & mask;; i = (i + 1) & mask) {
+		Entry &entry = this->entries[i];
+		if (entry.key == key) {
+			if (first != nullptr) {
+				entry.first = first;
+			} else {
+				this->Remove(i);
+			}
+			return;
+		}
+		if (entry.key == FREE_KEY) {
+			if (first != nullptr) {
+				entry.key = key;
+				entry.first = first;
+				this->used++;
+			}
+			return;
+		}
+	}
 }
 
 /**
- * Get a voxel stack.
- * @param x X coordinate of the stack.
- * @param y Y coordinate of the stack.
- * @return The requested voxel stack.
- * @pre The coordinate must exist within the world.
+ * Remove an entry, and move the entries after it that cannot be found anymore.
+ * @param index Index of the entry to remove.
  */
-VoxelStack *VoxelWorld::GetModifyStack(uint16 x, uint16 y)
+void VoxelObjectTable::Remove(uint32 index)
 {
-	assert(x < WORLD_X_SIZE && x < this->x_size);
-	assert(y < WORLD_Y_SIZE && y < this->y_size);
+	uint32 mask = this->entries.size() - 1;
+	uint32 j = index;
+	for (;;) {
+		j = (j + 1) & mask;
+		if (this->entries[j].key == FREE_KEY) break;
+
+		/* Move the entry to the free position, unless its home position is between the free position and the entry. */
+		uint32 home = GetHash(this->entries[j].key) & mask;
+		if (((j - home) & mask) >= ((j - index) & mask)) {
+			this->entries[index] = this->entries[j];
+			index = j;
+		}
+	}
+	this->entries[index].key = FREE_KEY;
+	this->used--;
+}
+
+/**
+ * Change the number of entries of the table, and insert the used entries again.
+ * @param size New number of entries, a power of two.
+ */
+void VoxelObjectTable::Resize(uint32 size)
+{
+	std::vector<Entry> old_entries(size, {FREE_KEY, nullptr});
+	old_entries.swap(this->entries);
 
-	return &this->stacks[x + y * WORLD_X_SIZE];
+	uint32 mask = size - 1;
+	for (const Entry &entry : old_entries) {
+		if (entry.key == FREE_KEY) continue;
+
+		uint32 i = GetHash(entry.key) & mask;
+		while (this->entries[i].key != FREE_KEY) i = (i + 1) & mask;
+		this->entries[i] = entry;
+	}
 }
 
 /**
- * Get a voxel stack (for read-only access).
- * @param x X coordinate of the stack.
- * @param y Y coordinate of the stack.
- * @return The requested voxel stack.
- * @pre The coordinate must exist within the world.
+ * Constructor of a chunk of the world, all its voxel stacks are empty.
+ * @param arena Storage of the voxel arrays of the stacks.
  */
-const VoxelStack *VoxelWorld::GetStack(uint16 x, uint16 y) const
+VoxelChunk::VoxelChunk(VoxelArena *arena)
 {
-	assert(x < WORLD_X_SIZE && x < this->x_size);
-	assert(y < WORLD_Y_SIZE && y < this->y_size);
+	this->arena = arena;
+	this->min_z = WORLD_Z_SIZE;
+	this->max_z = -1;
+	this->object_count = 0;
+	std::fill_n(this->object_voxels, lengthof(this->object_voxels), 0);
+	for (VoxelStack &vs : this->stacks) vs.chunk = this;
+}
 
-	return &this->stacks[x + y * WORLD_X_SIZE];
+/**
+ * Set the first voxel object of a voxel.
+ * @param key Key of the voxel, see #GetObjectKey.
+ * @param first First voxel object of the voxel, \c nullptr if the voxel has no voxel objects anymore.
+ */
+void VoxelChunk::SetVoxelObjects(uint16 key, VoxelObject *first)
+{
+	this->voxel_objects.Set(key, first);
+	SB(this->object_voxels[key / WORLD_Z_SIZE], key % WORLD_Z_SIZE, 1, (uint64)(first != nullptr ? 1 : 0));
+}
+
+/**
+ * Extend the range of heights of the chunk with the voxels of one of its stacks.
+ * @param base Base height of the stack.
+ * @param height Number of voxels in the stack.
+ */
+void VoxelChunk::ExtendHeightRange(int16 base, uint16 height)
+{
+	this->min_z = std::min<int16>(this->min_z, base);
+	this->max_z = std::max<int16>(this->max_z, base + height - 1);
+}
+
+/**
+ * Does a voxel of the chunk contain a path or a ride?
+ * @return Whether the chunk has a voxel with a path or a ride.
+ * @note The voxels of the chunk are examined, which is cheap compared to examining them one at a time through the world.
+ */
+bool VoxelChunk::HasRides() const
+{
+	for (const VoxelStack &vs : this->stacks) {
+		for (int i = 0; i < vs.height; i++) {
+			if (vs.voxels[i].GetInstance() != SRI_FREE) return true;
+		}
+	}
+	return false;
 }
 
 /**
@@ -774,6 +965,7 @@ void VoxelWorld::SetTileOwner(uint16 x, uint16 y, TileOwner owner)
 	this->GetModifyStack(x, y)->owner = owner;
 
 	UpdateLandBorderFence(x, y, 1, 1);
+	_path_graph.MarkChanged(); // The paths to the park border may have changed.
 }
 
 /**
@@ -793,6 +985,7 @@ void VoxelWorld::SetTileOwnerRect(uint16 x, uint16 y, uint16 width, uint16 heigh
 	}
 
 	UpdateLandBorderFence(x, y, width, height);
+	_path_graph.MarkChanged(); // The paths to the park border may have changed.
 }
 
 /**
@@ -804,6 +997,130 @@ void VoxelWorld::SetTileOwnerGlobally(TileOwner owner)
 	SetTileOwnerRect(0, 0, this->GetXSize(), this->GetYSize(), owner);
 }
 
+/**
+ * Write a plane of values of the world to a file, as pairs of a run length and a value.
+ * @param svr Output stream to save to.
+ * @param values Values of the plane.
+ * @param value_size Number of bytes of a value (1, 2, or 4).
+ */
+static void SaveRunLengths(Saver &svr, const std::vector<uint32> &values, int value_size)
+{
+	size_t i = 0;
+	while (i < values.size()) {
+		uint32 value = values[i];
+		uint16 count = 1;
+		while (count < UINT16_MAX && i + count < values.size() && values[i + count] == value) count++;
+
+		svr.PutWord(count);
+		switch (value_size) {
+			case 1: svr.PutByte(value); break;
+			case 2: svr.PutWord(value); break;
+			case 4: svr.PutLong(value); break;
+			default: NOT_REACHED();
+		}
+		i += count;
+	}
+}
+
+/**
+ * Load a plane of values of the world written by #SaveRunLengths.
+ * @param ldr Input stream to read from.
+ * @param values [out] Values of the plane, the vector must have the size of the plane.
+ * @param value_size Number of bytes of a value (1, 2, or 4).
+ */
+static void LoadRunLengths(Loader &ldr, std::vector<uint32> *values, int value_size)
+{
+	size_t i = 0;
+	while (i < values->size() && !ldr.IsFail()) {
+		uint16 count = ldr.GetWord();
+		uint32 value;
+		switch (value_size) {
+			case 1: value = ldr.GetByte(); break;
+			case 2: value = ldr.GetWord(); break;
+			case 4: value = ldr.GetLong(); break;
+			default: NOT_REACHED();
+		}
+		if (count == 0 || count > values->size() - i) {
+			ldr.SetFailMessage("Incorrect run length in world data");
+			return;
+		}
+		std::fill_n(values->begin() + i, count, value);
+		i += count;
+	}
+}
+
+/**
+ * Load the voxel stacks of the world, stored as planes of values (version 2 of the world block).
+ * @param ldr Input stream to read from.
+ * @pre The world has the size of the loaded world, and all stacks are empty.
+ */
+void VoxelWorld::LoadStackPlanes(Loader &ldr)
+{
+	uint stack_count = this->x_size * this->y_size;
+	std::vector<uint32> bases(stack_count);
+	std::vector<uint32> heights(stack_count);
+	std::vector<uint32> owners(stack_count);
+	LoadRunLengths(ldr, &bases, 2);
+	LoadRunLengths(ldr, &heights, 2);
+	LoadRunLengths(ldr, &owners, 1);
+	if (ldr.IsFail()) return;
+
+	/* Allocate all stacks. */
+	uint voxel_count = 0;
+	uint index = 0;
+	for (uint16 x = 0; x < this->x_size; x++) {
+		for (uint16 y = 0; y < this->y_size; y++) {
+			int16 base = bases[index];
+			uint16 height = heights[index];
+			if (base < 0 || base + height > WORLD_Z_SIZE || owners[index] >= OWN_COUNT) {
+				ldr.SetFailMessage("Incorrect voxel stack size");
+				return;
+			}
+
+			VoxelStack *vs = this->GetModifyStack(x, y);
+			vs->Allocate(base, height);
+			vs->owner = (TileOwner)owners[index];
+			voxel_count += height;
+			index++;
+		}
+	}
+
+	std::vector<uint32> grounds(voxel_count);
+	std::vector<uint32> instances(voxel_count);
+	std::vector<uint32> instance_datas(voxel_count);
+	std::vector<uint32> fences(voxel_count);
+	LoadRunLengths(ldr, &grounds, 4);
+	LoadRunLengths(ldr, &instances, 1);
+	LoadRunLengths(ldr, &instance_datas, 2);
+	LoadRunLengths(ldr, &fences, 2);
+	if (ldr.IsFail()) return;
+
+	index = 0;
+	for (uint16 x = 0; x < this->x_size; x++) {
+		for (uint16 y = 0; y < this->y_size; y++) {
+			VoxelStack *vs = this->GetModifyStack(x, y);
+			for (uint i = 0; i < vs->height; i++) {
+				Voxel *v = &vs->voxels[i];
+				v->ground = grounds[index]; /// \todo Check sanity of the data.
+				uint32 instance = instances[index];
+				if (instance == SRI_FREE) {
+					v->SetInstance(SRI_FREE);
+					v->instance_data = 0; // Full rides load after the world, overwriting map data.
+				} else if (instance >= SRI_RIDES_START && instance < SRI_FULL_RIDES) {
+					v->SetInstance((SmallRideInstance)instance);
+					v->instance_data = instance_datas[index];
+				} else {
+					v->SetInstance(SRI_FREE);
+					v->instance_data = 0;
+					ldr.SetFailMessage("Unknown voxel instance data");
+				}
+				v->fences = fences[index];
+				index++;
+			}
+		}
+	}
+}
+
 /**
  * Load the world from a file.
  * @param ldr Input stream to read from.
@@ -813,21 +1130,24 @@ void VoxelWorld::Load(Loader &ldr)
 	uint32 version = ldr.OpenBlock("WRLD");
 	uint16 xsize = 64;
 	uint16 ysize = 64;
-	if (version == 1) {
+	if (version == 1 || version == 2) {
 		xsize = ldr.GetWord();
 		ysize = ldr.GetWord();
 	} else if (version != 0) {
 		ldr.SetFailMessage("Unknown world version.");
 	}
-	if (xsize >= WORLD_X_SIZE || ysize >= WORLD_Y_SIZE) {
+	if (xsize > WORLD_X_SIZE || ysize > WORLD_Y_SIZE) {
 		xsize = std::min<uint16>(xsize, WORLD_X_SIZE);
 		ysize = std::min<uint16>(ysize, WORLD_Y_SIZE);
 		ldr.SetFailMessage("Incorrect world size");
 	}
-	ldr.CloseBlock();
 
 	this->SetWorldSize(xsize, ysize);
-	if (!ldr.IsFail() && version != 0) {
+	if (version == 2 && !ldr.IsFail()) this->LoadStackPlanes(ldr);
+	ldr.CloseBlock();
+
+	/* In version 1, every voxel stack is stored in its own block after the world block. */
+	if (version == 1 && !ldr.IsFail()) {
 		for (uint16 x = 0; x < xsize; x++) {
 			for (uint16 y = 0; y < ysize; y++) {
 				VoxelStack *vs = this->GetModifyStack(x, y);
@@ -840,20 +1160,59 @@ void VoxelWorld::Load(Loader &ldr)
 
 /**
  * Save the world to a file.
+ * The voxel stacks are saved as planes of run-length encoded values, first the base, height, and owner of all stacks,
+ * followed by the ground, instance, instance data, and fences of all voxels (bottom to top in each stack).
  * @param svr Output stream to save to.
  */
 void VoxelWorld::Save(Saver &svr) const
 {
 	/* Save basic map information (rides are saved as part of the ride). */
-	svr.StartBlock("WRLD", 1);
+	svr.StartBlock("WRLD", 2);
 	svr.PutWord(this->GetXSize());
 	svr.PutWord(this->GetYSize());
-	svr.EndBlock();
+
+	uint stack_count = this->GetXSize() * this->GetYSize();
+	std::vector<uint32> bases;
+	std::vector<uint32> heights;
+	std::vector<uint32> owners;
+	bases.reserve(stack_count);
+	heights.reserve(stack_count);
+	owners.reserve(stack_count);
+
+	std::vector<uint32> grounds;
+	std::vector<uint32> instances;
+	std::vector<uint32> instance_datas;
+	std::vector<uint32> fences;
 	for (uint16 x = 0; x < this->GetXSize(); x++) {
 		for (uint16 y = 0; y < this->GetYSize(); y++) {
 			const VoxelStack *vs = this->GetStack(x, y);
-			vs->Save(svr);
+			bases.push_back((uint16)vs->base);
+			heights.push_back(vs->height);
+			owners.push_back(vs->owner);
+
+			for (uint i = 0; i < vs->height; i++) {
+				const Voxel &v = vs->voxels[i];
+				grounds.push_back(GB(v.ground, 0, 24)); // The ride instance is saved separately.
+				SmallRideInstance instance = v.GetInstance();
+				if (instance >= SRI_RIDES_START && instance < SRI_FULL_RIDES) {
+					instances.push_back(instance);
+					instance_datas.push_back(v.instance_data);
+				} else {
+					instances.push_back(SRI_FREE); // Full rides save their own data from the world.
+					instance_datas.push_back(0);
+				}
+				fences.push_back(v.fences);
+			}
 		}
 	}
+
+	SaveRunLengths(svr, bases, 2);
+	SaveRunLengths(svr, heights, 2);
+	SaveRunLengths(svr, owners, 1);
+	SaveRunLengths(svr, grounds, 4);
+	SaveRunLengths(svr, instances, 1);
+	SaveRunLengths(svr, instance_datas, 2);
+	SaveRunLengths(svr, fences, 2);
+	svr.EndBlock();
 }
 
@@ -16,13 +16,23 @@
 #include "sprite_store.h"
 #include "bitmath.h"
 
+#include <algorithm>
 #include <map>
+#include <memory>
+#include <vector>
 
 class Viewport;
 
-static const int WORLD_X_SIZE = 128; ///< Maximal length of the X side (North-West side) of the world.
-static const int WORLD_Y_SIZE = 128; ///< Maximal length of the Y side (North-East side) of the world.
-static const int WORLD_Z_SIZE =  64; ///< Maximal height of the world.
+static const int WORLD_X_SIZE = 1024; ///< Maximal length of the X side (North-West side) of the world.
+static const int WORLD_Y_SIZE = 1024; ///< Maximal length of the Y side (North-East side) of the world.
+static const int WORLD_Z_SIZE =   64; ///< Maximal height of the world.
+
+static const int WORLD_CHUNK_SHIFT = 4;                             ///< Log2 of the number of voxel stacks along a side of a chunk of the world.
+static const int WORLD_CHUNK_SIZE = 1 << WORLD_CHUNK_SHIFT;         ///< Number of voxel stacks along a side of a chunk of the world.
+static const int WORLD_CHUNK_MASK = WORLD_CHUNK_SIZE - 1;           ///< Mask for the position of a voxel stack in its chunk.
+static const int WORLD_X_CHUNKS = WORLD_X_SIZE / WORLD_CHUNK_SIZE; ///< Maximal number of chunks in X direction.
+static const int WORLD_Y_CHUNKS = WORLD_Y_SIZE / WORLD_CHUNK_SIZE; ///< Maximal number of chunks in Y direction.
+assert_compile(WORLD_Z_SIZE <= 64); ///< The voxels of a stack with voxel objects fit in a bit set, see #VoxelChunk::object_voxels.
 
 /**
  * In general, ride instances are stored in the #RidesManager, where there is room to store all the detailed information
@@ -56,12 +66,14 @@ class VoxelObject;
  *   for example use some bits to display variations.
  * The ground data contains the foundations, and the ground (grass).
  *
+ * The voxel is packed in 8 bytes, so the voxels of a stack share few cache lines. The voxel objects in a voxel are
+ * stored at the #VoxelChunk, as only a few voxels have them.
+ *
  * @ingroup map_group
  */
 struct Voxel {
 public:
-	uint8 instance;       ///< Ride instances that uses this voxel.
-	uint16 instance_data; ///< %Voxel data of the #instance stored here.
+	uint16 instance_data; ///< %Voxel data of the ride instance stored here, see #GetInstance.
 
 	/**
 	 * Get the ride instance at this voxel.
@@ -69,7 +81,7 @@ public:
 	 */
 	inline SmallRideInstance GetInstance() const
 	{
-		return (SmallRideInstance)this->instance;
+		return (SmallRideInstance)GB(this->ground, 24, 8);
 	}
 
 	/**
@@ -78,7 +90,7 @@ public:
 	 */
 	inline void SetInstance(SmallRideInstance instance)
 	{
-		this->instance = instance;
+		SB(this->ground, 24, 8, instance);
 	}
 
 	/**
@@ -157,6 +169,7 @@ public:
 	 *   - bit 15: Northern corner of NW edge is up.
 	 * - bit 16..20 (5): Imploded ground slope. @see #ExpandTileSlope
 	 * - bit 21..23 (3): Growth of the tile grass.
+	 * - bit 24..31 (8): Ride instance that uses this voxel. @see SmallRideInstance
 	 */
 	uint32 ground;
 
@@ -273,21 +286,10 @@ public:
 		return this->GetInstance() == SRI_FREE && this->GetGroundType() == GTP_INVALID && this->GetFoundationType() == FDT_INVALID;
 	}
 
-	VoxelObject *voxel_objects; ///< First voxel object in this voxel.
-
-	/**
-	 * Does the voxel have any voxel objects currently?
-	 * @return Whether it has any voxel objects (\c false means it has no voxel objects).
-	 */
-	inline bool HasVoxelObjects() const
-	{
-		return this->voxel_objects != nullptr;
-	}
-
 	void ClearVoxel();
-	void Save(Saver &svr) const;
 	void Load(Loader &ldr, uint32 version);
 };
+assert_compile(sizeof(Voxel) == 8); ///< Check the voxel is packed.
 
 /** Base class for (moving) objects that are stored at a voxel position for easy retrieval during drawing. */
 class VoxelObject {
@@ -300,38 +302,8 @@ public:
 
 	virtual const ImageData *GetSprite(const SpriteStorage *sprites, ViewOrientation orient, const Recolouring **recolour) const = 0;
 
-	/**
-	 * Add itself to the voxel objects chain.
-	 * @param v %Voxel containing the object.
-	 */
-	void AddSelf(Voxel *v)
-	{
-		assert(!this->added);
-		this->added = true;
-
-		this->next_object = v->voxel_objects;
-		if (this->next_object != nullptr) this->next_object->prev_object = this;
-		v->voxel_objects = this;
-		this->prev_object = nullptr;
-	}
-
-	/**
-	 * Remove itself from the voxel objects chain.
-	 * @param v %Voxel containing the object.
-	 */
-	void RemoveSelf(Voxel *v)
-	{
-		assert(this->added);
-		this->added = false;
-
-		if (this->next_object != nullptr) this->next_object->prev_object = this->prev_object;
-		if (this->prev_object != nullptr) {
-			this->prev_object->next_object = this->next_object;
-		} else {
-			assert(v->voxel_objects == this);
-			v->voxel_objects = this->next_object;
-		}
-	}
+	void AddSelf();
+	void RemoveSelf();
 
 	/**
 	 * Merge voxel coordinate, #vox_pos, with in-voxel coordinate, #pix_pos.
@@ -400,7 +372,7 @@ static inline bool HasValidPath(uint16 instance_data)
  */
 static inline bool HasValidPath(const Voxel *v)
 {
-	return v->instance == SRI_PATH && HasValidPath(v->instance_data);
+	return v->GetInstance() == SRI_PATH && HasValidPath(v->instance_data);
 }
 
 /**
@@ -496,6 +468,47 @@ enum TileOwner {
 	OWN_COUNT,    ///< Number of valid tile ownership values.
 };
 
+static const int VOXEL_ARENA_MIN_CAPACITY = 1;    ///< Smallest number of voxels allocated for a voxel stack.
+static const int VOXEL_ARENA_CLASS_COUNT = 7;     ///< Number of different capacities of voxel arrays (1, 2, 4, 8, 16, 32, and 64 voxels).
+static const int VOXEL_ARENA_SLAB_SIZE = 64 * 64; ///< Number of voxels in a slab of the arena.
+
+/**
+ * Storage of the voxel arrays of the voxel stacks. The arrays are carved from large slabs, with a capacity of a power of two.
+ * Released arrays are kept for reuse by other arrays of the same capacity, slabs are only freed with the arena.
+ * @ingroup map_group
+ */
+class VoxelArena {
+public:
+	VoxelArena();
+
+	static uint16 GetCapacity(uint16 height);
+
+	Voxel *Allocate(uint16 capacity);
+	void Release(Voxel *voxels, uint16 capacity);
+	void Reset();
+
+	/**
+	 * Get the number of slabs allocated from the heap.
+	 * @return Number of slabs.
+	 */
+	inline uint GetSlabCount() const
+	{
+		return this->slabs.size();
+	}
+
+private:
+	static int GetCapacityClass(uint16 capacity);
+	void NextSlab();
+
+	std::vector<std::unique_ptr<Voxel[]>> slabs;                ///< Slabs of voxels.
+	uint used_slabs;                                            ///< Number of slabs being carved or used.
+	Voxel *free_start;                                          ///< First never-used voxel of the current slab.
+	uint free_count;                                            ///< Number of never-used voxels in the current slab.
+	std::vector<Voxel *> free_arrays[VOXEL_ARENA_CLASS_COUNT]; ///< Released voxel arrays, by capacity class.
+};
+
+class VoxelChunk;
+
 /**
  * One column of voxels.
  * @ingroup map_group
@@ -503,9 +516,9 @@ enum TileOwner {
 class VoxelStack {
 public:
 	VoxelStack();
-	~VoxelStack();
 
 	void Clear();
+	void Allocate(int16 new_base, uint16 new_height);
 	const Voxel *Get(int16 z) const;
 	Voxel *GetCreate(int16 z, bool create);
 
@@ -514,7 +527,6 @@ public:
 	int GetTopGroundOffset() const;
 	int GetBaseGroundOffset() const;
 
-	void Save(Saver &svr) const;
 	void Load(Loader &ldr);
 
 	Voxel *voxels;   ///< %Voxel array at this stack.
@@ -523,6 +535,247 @@ public:
 	TileOwner owner; ///< Ownership of the base tile of this voxel stack.
 protected:
 	bool MakeVoxelStack(int16 new_base, uint16 new_height);
+
+	VoxelChunk *chunk; ///< Chunk containing the stack.
+	uint16 capacity;   ///< Number of voxels available in the voxel array.
+
+	friend class VoxelChunk;
+};
+
+/**
+ * Hash table from a voxel to its first voxel object, for the few voxels that have voxel objects.
+ * The entries are stored in a single array (open addressing with linear probing), so a lookup examines little memory.
+ * @ingroup map_group
+ */
+class VoxelObjectTable {
+public:
+	VoxelObjectTable();
+
+	/**
+	 * Get the first voxel object of a voxel.
+	 * @param key Key of the voxel.
+	 * @return First voxel object of the voxel, or \c nullptr if it has no voxel objects.
+	 */
+	inline VoxelObject *Get(uint16 key) const
+	{
+		if (this->entries.empty()) return nullptr;
+		uint32 mask = this->entries.size() - 1;
+		for (uint32 i = GetHash(key) & mask;; i = (i + 1) & mask) {
+			const Entry &entry = this->entries[i];
+			if (entry.key == key) return entry.first;
+			if (entry.key == FREE_KEY) return nullptr;
+		}
+	}
+
+	void Set(uint16 key, VoxelObject *first);
+
+	/**
+	 * Get the memory used by the entries of the table.
+	 * @return Number of bytes of the entries.
+	 */
+	inline size_t GetMemorySize() const
+	{
+		return this->entries.size() * sizeof(Entry);
+	}
+
+private:
+	static const uint16 FREE_KEY = UINT16_MAX; ///< Key of an unused entry.
+
+	/** Entry of the table. */
+	struct Entry {
+		uint16 key;         ///< Key of the voxel, #FREE_KEY if the entry is not used.
+		VoxelObject *first; ///< First voxel object of the voxel.
+	};
+
+	/**
+	 * Get the hash of a key. Keys of neighbouring voxels differ in their high bits, which are spread over the hash.
+	 * @param key Key of the voxel.
+	 * @return Hash of the key.
+	 */
+	static inline uint32 GetHash(uint16 key)
+	{
+		return (key * 2654435761U) >> 16;
+	}
+
+	void Remove(uint32 index);
+	void Resize(uint32 size);
+
+	std::vector<Entry> entries; ///< Entries of the table, the number of entries is a power of two.
+	uint32 used;                ///< Number of used entries.
+};
+
+/**
+ * Square part of the world of #WORLD_CHUNK_SIZE by #WORLD_CHUNK_SIZE voxel stacks, allocated when one of its stacks is modified.
+ * Its metadata allows skipping chunks without interesting content.
+ * @ingroup map_group
+ */
+class VoxelChunk {
+public:
+	VoxelChunk(VoxelArena *arena);
+
+	/**
+	 * Get a voxel stack of the chunk.
+	 * @param x X coordinate of the stack in the world.
+	 * @param y Y coordinate of the stack in the world.
+	 * @return The voxel stack.
+	 */
+	inline VoxelStack *GetStack(uint16 x, uint16 y)
+	{
+		return &this->stacks[(x & WORLD_CHUNK_MASK) * WORLD_CHUNK_SIZE + (y & WORLD_CHUNK_MASK)];
+	}
+
+	/**
+	 * Get a voxel stack of the chunk (for read-only access).
+	 * @param x X coordinate of the stack in the world.
+	 * @param y Y coordinate of the stack in the world.
+	 * @return The voxel stack.
+	 */
+	inline const VoxelStack *GetStack(uint16 x, uint16 y) const
+	{
+		return &this->stacks[(x & WORLD_CHUNK_MASK) * WORLD_CHUNK_SIZE + (y & WORLD_CHUNK_MASK)];
+	}
+
+	/**
+	 * Does the chunk have any voxel?
+	 * @return Whether a stack of the chunk has voxels.
+	 */
+	inline bool HasVoxels() const
+	{
+		return this->min_z <= this->max_z;
+	}
+
+	/**
+	 * Get the key of a voxel in #voxel_objects.
+	 * @param vox Coordinate of the voxel in the world.
+	 * @return Key of the voxel.
+	 */
+	static inline uint16 GetObjectKey(const XYZPoint16 &vox)
+	{
+		return ((vox.x & WORLD_CHUNK_MASK) * WORLD_CHUNK_SIZE + (vox.y & WORLD_CHUNK_MASK)) * WORLD_Z_SIZE + vox.z;
+	}
+
+	/**
+	 * Get the key of a voxel in #voxel_objects.
+	 * @param vs Voxel stack of the chunk containing the voxel.
+	 * @param z Z coordinate of the voxel.
+	 * @return Key of the voxel.
+	 */
+	inline uint16 GetObjectKey(const VoxelStack *vs, int16 z) const
+	{
+		return (vs - this->stacks) * WORLD_Z_SIZE + z;
+	}
+
+	/**
+	 * Get the first voxel object of a voxel.
+	 * @param key Key of the voxel, see #GetObjectKey.
+	 * @return First voxel object of the voxel, or \c nullptr if the voxel has no voxel objects.
+	 */
+	inline VoxelObject *GetVoxelObjects(uint16 key) const
+	{
+		if (GB(this->object_voxels[key / WORLD_Z_SIZE], key % WORLD_Z_SIZE, 1) == 0) return nullptr;
+		return this->voxel_objects.Get(key);
+	}
+
+	void SetVoxelObjects(uint16 key, VoxelObject *first);
+
+	/**
+	 * Get the memory used by the table of voxel objects of the chunk.
+	 * @return Number of bytes of the table entries.
+	 */
+	inline size_t GetObjectTableMemorySize() const
+	{
+		return this->voxel_objects.GetMemorySize();
+	}
+
+	void ExtendHeightRange(int16 base, uint16 height);
+	bool HasRides() const;
+
+	VoxelArena *arena;   ///< Storage of the voxel arrays of the stacks.
+	int16 min_z;         ///< Lowest voxel of the chunk, may be lower than the actual lowest voxel.
+	int16 max_z;         ///< Highest voxel of the chunk, may be higher than the actual highest voxel.
+	uint32 object_count; ///< Number of voxel objects (guests and ride cars) in the chunk.
+
+private:
+	VoxelObjectTable voxel_objects; ///< First voxel object of the voxels that have voxel objects, by #GetObjectKey.
+	uint64 object_voxels[WORLD_CHUNK_SIZE * WORLD_CHUNK_SIZE]; ///< For each stack, the voxels that are in #voxel_objects (bit \c z is set for height \c z).
+	VoxelStack stacks[WORLD_CHUNK_SIZE * WORLD_CHUNK_SIZE]; ///< Voxel stacks of the chunk.
+};
+
+/**
+ * Value for every voxel of the world, stored by chunk of the world. The values of a chunk are allocated when one of them is modified,
+ * so memory is only used for the parts of the world that have a value different from the initial value.
+ * @tparam T Type of the value.
+ * @ingroup map_group
+ */
+template <typename T>
+class VoxelChunkArray {
+public:
+	/**
+	 * Constructor of the array.
+	 * @param initial Value of the voxels that have not been modified.
+	 */
+	VoxelChunkArray(const T &initial) : initial(initial)
+	{
+	}
+
+	/**
+	 * Get the value of a voxel (for read-only access).
+	 * @param vox Coordinate of the voxel.
+	 * @return Value of the voxel.
+	 */
+	inline const T &Get(const XYZPoint16 &vox) const
+	{
+		const std::unique_ptr<T[]> &values = this->chunks[GetChunkIndex(vox)];
+		return (values != nullptr) ? values[GetValueIndex(vox)] : this->initial;
+	}
+
+	/**
+	 * Get the value of a voxel, allocating the values of its chunk if needed.
+	 * @param vox Coordinate of the voxel.
+	 * @return Value of the voxel.
+	 */
+	inline T &GetModify(const XYZPoint16 &vox)
+	{
+		std::unique_ptr<T[]> &values = this->chunks[GetChunkIndex(vox)];
+		if (values == nullptr) {
+			values.reset(new T[CHUNK_VALUE_COUNT]);
+			std::fill_n(values.get(), CHUNK_VALUE_COUNT, this->initial);
+		}
+		return values[GetValueIndex(vox)];
+	}
+
+	/** Reset all voxels to the initial value, releasing their memory. */
+	void Clear()
+	{
+		for (std::unique_ptr<T[]> &values : this->chunks) values.reset();
+	}
+
+private:
+	static const int CHUNK_VALUE_COUNT = WORLD_CHUNK_SIZE * WORLD_CHUNK_SIZE * WORLD_Z_SIZE; ///< Number of values of a chunk.
+
+	/**
+	 * Get the index of the chunk containing a voxel.
+	 * @param vox Coordinate of the voxel.
+	 * @return Index of the chunk in #chunks.
+	 */
+	static inline uint32 GetChunkIndex(const XYZPoint16 &vox)
+	{
+		assert(vox.x >= 0 && vox.x < WORLD_X_SIZE && vox.y >= 0 && vox.y < WORLD_Y_SIZE && vox.z >= 0 && vox.z < WORLD_Z_SIZE);
+		return (vox.x >> WORLD_CHUNK_SHIFT) + (vox.y >> WORLD_CHUNK_SHIFT) * WORLD_X_CHUNKS;
+	}
+
+	/**
+	 * Get the index of the value of a voxel in the values of its chunk.
+	 * @param vox Coordinate of the voxel.
+	 * @return Index of the value.
+	 */
+	static inline uint32 GetValueIndex(const XYZPoint16 &vox)
+	{
+		return ((vox.z * WORLD_CHUNK_SIZE) + (vox.y & WORLD_CHUNK_MASK)) * WORLD_CHUNK_SIZE + (vox.x & WORLD_CHUNK_MASK);
+	}
+
+	T initial; ///< Value of the voxels that have not been modified.
+	std::unique_ptr<T[]> chunks[WORLD_X_CHUNKS * WORLD_Y_CHUNKS]; ///< Values of the voxels of each chunk, \c nullptr if no value of the chunk was modified.
 };
 
 /**
@@ -536,8 +789,71 @@ public:
 	void SetWorldSize(uint16 xs, uint16 ys);
 	void MakeFlatWorld(int16 z);
 
-	VoxelStack *GetModifyStack(uint16 x, uint16 y);
-	const VoxelStack *GetStack(uint16 x, uint16 y) const;
+	/**
+	 * Get the chunk containing a voxel stack (for read-only access).
+	 * @param x X coordinate of the stack.
+	 * @param y Y coordinate of the stack.
+	 * @return The chunk containing the stack, or \c nullptr if none of its stacks has been modified.
+	 * @pre The coordinate must exist within the world.
+	 */
+	inline const VoxelChunk *GetChunk(uint16 x, uint16 y) const
+	{
+		assert(x < this->x_size && y < this->y_size);
+		return this->chunks[(x >> WORLD_CHUNK_SHIFT) + (y >> WORLD_CHUNK_SHIFT) * WORLD_X_CHUNKS].get();
+	}
+
+	/**
+	 * Get the chunk containing a voxel stack, allocating it if needed.
+	 * @param x X coordinate of the stack.
+	 * @param y Y coordinate of the stack.
+	 * @return The chunk containing the stack.
+	 * @pre The coordinate must exist within the world.
+	 */
+	inline VoxelChunk *GetModifyChunk(uint16 x, uint16 y)
+	{
+		assert(x < this->x_size && y < this->y_size);
+		std::unique_ptr<VoxelChunk> &chunk = this->chunks[(x >> WORLD_CHUNK_SHIFT) + (y >> WORLD_CHUNK_SHIFT) * WORLD_X_CHUNKS];
+		if (chunk == nullptr) chunk.reset(new VoxelChunk(&this->arena));
+		return chunk.get();
+	}
+
+	/**
+	 * Get a voxel stack.
+	 * @param x X coordinate of the stack.
+	 * @param y Y coordinate of the stack.
+	 * @return The requested voxel stack.
+	 * @pre The coordinate must exist within the world.
+	 */
+	inline VoxelStack *GetModifyStack(uint16 x, uint16 y)
+	{
+		return this->GetModifyChunk(x, y)->GetStack(x, y);
+	}
+
+	/**
+	 * Get a voxel stack (for read-only access).
+	 * @param x X coordinate of the stack.
+	 * @param y Y coordinate of the stack.
+	 * @return The requested voxel stack.
+	 * @pre The coordinate must exist within the world.
+	 */
+	inline const VoxelStack *GetStack(uint16 x, uint16 y) const
+	{
+		const VoxelChunk *chunk = this->GetChunk(x, y);
+		return (chunk != nullptr) ? chunk->GetStack(x, y) : &this->empty_stack;
+	}
+
+	/**
+	 * Get the first voxel object in a voxel.
+	 * @param vox Coordinate of the voxel.
+	 * @return First voxel object of the voxel, or \c nullptr if it has no voxel objects.
+	 * @pre The coordinate must exist within the world.
+	 */
+	inline const VoxelObject *GetVoxelObjects(const XYZPoint16 &vox) const
+	{
+		const VoxelChunk *chunk = this->GetChunk(vox.x, vox.y);
+		return (chunk != nullptr) ? chunk->GetVoxelObjects(VoxelChunk::GetObjectKey(vox)) : nullptr;
+	}
+
 	uint8 GetTopGroundHeight(uint16 x, uint16 y) const;
 	uint8 GetBaseGroundHeight(uint16 x, uint16 y) const;
 
@@ -614,10 +930,14 @@ public:
 	void Load(Loader &ldr);
 
 private:
+	void LoadStackPlanes(Loader &ldr);
+
 	uint16 x_size; ///< Current max x size (in voxels).
 	uint16 y_size; ///< Current max y size (in voxels).
 
-	VoxelStack stacks[WORLD_X_SIZE * WORLD_Y_SIZE]; ///< All voxel stacks in the world.
+	VoxelArena arena;       ///< Storage of the voxel arrays of the stacks.
+	VoxelStack empty_stack; ///< Voxel stack returned for the stacks of chunks that have not been allocated.
+	std::unique_ptr<VoxelChunk> chunks[WORLD_X_CHUNKS * WORLD_Y_CHUNKS]; ///< Chunks of the world, \c nullptr until one of their stacks is modified.
 };
 
 /**
@@ -342,6 +342,17 @@ public:
 		return _recolour_palettes[re.dest];
 	}
 
+	/**
+	 * Get a value identifying the recolouring. Recolourings with the same value recolour sprites in the same way.
+	 * @return Source and destination colour ranges of all entries, packed in one number.
+	 */
+	uint64 GetHash() const
+	{
+		uint64 hash = 0;
+		for (int i = 0; i < MAX_RECOLOUR; i++) hash = (hash << 16) | (this->entries[i].source << 8) | this->entries[i].dest;
+		return hash;
+	}
+
 	/**
 	 * Recolour entries, (one for each layer in 32bpp).
 	 * Don't assign directly, use #Set instead.
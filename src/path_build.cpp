@@ -15,6 +15,7 @@
 #include "gamecontrol.h"
 #include "window.h"
 #include "math_func.h"
+#include "path_graph.h"
 
 /**
  * Build a path at a tile, and claim the voxels above it as well.
@@ -45,6 +46,7 @@ static void BuildPathAtTile(const XYZPoint16 &voxel_pos, PathType path_type, uin
 	}
 
 	MarkVoxelDirty(voxel_pos);
+	_path_graph.UpdateVoxel(voxel_pos);
 }
 
 /**
@@ -72,6 +74,7 @@ static void RemovePathAtTile(const XYZPoint16 &voxel_pos, uint8 path_spr)
 		av->SetInstance(SRI_FREE);
 		av->SetInstanceData(0);
 	}
+	_path_graph.UpdateVoxel(voxel_pos);
 }
 
 /**
@@ -95,6 +98,7 @@ static void ChangePathAtTile(const XYZPoint16 &voxel_pos, PathType path_type, ui
 	av->SetInstanceData(MakePathInstanceData(slope, path_type));
 
 	MarkVoxelDirty(voxel_pos);
+	_path_graph.UpdateVoxel(voxel_pos);
 }
 
 /**
@@ -10,62 +10,283 @@
 #include "stdafx.h"
 #include "path_finding.h"
 #include "map.h"
+#include <vector>
+
+static const uint POSITION_BLOCK_SIZE = 256; ///< Number of walked positions allocated at the same time.
+
+/**
+ * Data structures of a path search. They are kept between searches, so a new search does not need to allocate memory.
+ * Visited voxels are found by voxel coordinate, a voxel is visited in the current search if its generation matches the generation of the search.
+ */
+class PathSearchData {
+public:
+	PathSearchData();
+	~PathSearchData();
+
+	void Start();
+	WalkedPosition *GetPosition(const XYZPoint16 &vox);
+	WalkedPosition *AddPosition(const XYZPoint16 &vox);
+
+	void PushOpen(WalkedPosition *wp);
+	void UpdateOpen(WalkedPosition *wp);
+	WalkedPosition *PopOpen();
+
+	/**
+	 * Are there open points left to explore?
+	 * @return Whether the open points are exhausted.
+	 */
+	inline bool IsOpenEmpty() const
+	{
+		return this->open_points.empty();
+	}
+
+	bool in_use; ///< Data is used by a path searcher.
+
+private:
+	/** Visit information of a voxel. */
+	struct VisitedVoxel {
+		uint32 generation; ///< Search generation that last visited the voxel.
+		uint32 position;   ///< Index of the walked position of the voxel (only valid if the voxel is visited).
+	};
+
+	uint32 generation;                   ///< Generation of the current search.
+	VoxelChunkArray<VisitedVoxel> visited; ///< Visit information of all voxels of the world.
+	std::vector<WalkedPosition *> blocks; ///< Storage blocks of #POSITION_BLOCK_SIZE walked positions.
+	uint32 position_count;               ///< Number of walked positions in use.
+	std::vector<WalkedPosition *> open_points; ///< Binary heap of positions to explore further, best position at the top.
+
+	inline void SetHeapEntry(uint32 index, WalkedPosition *wp);
+	void SiftUp(uint32 index);
+	void SiftDown(uint32 index);
+};
+
+static PathSearchData _path_search_data; ///< Data structures of the path searches.
 
 /**
- * Constructor of a walked position.
- * @param cur_vox Current voxel position.
- * @param traveled Length of travel from the starting point so far.
- * @param estimate Estimated length of remaining travel to the destination (should be less or equal to the real value for optimal solutions).
- * @param prev_pos Previous walked position used to get at the new position, \c nullptr for the first position.
+ * Compare two walked positions, and order on minimal total distance.
+ * @param wp1 First position to compare.
+ * @param wp2 Second position to compare.
+ * @return Whether \a wp1 should be explored before \a wp2.
  */
-WalkedPosition::WalkedPosition(const XYZPoint16 &cur_vox, uint32 traveled, uint32 estimate, const WalkedPosition *prev_pos)
-		: cur_vox(cur_vox), traveled(traveled), estimate(estimate), prev_pos(prev_pos)
+static inline bool IsBetterPosition(const WalkedPosition *wp1, const WalkedPosition *wp2)
+{
+	uint32 total1 = wp1->traveled + wp1->estimate;
+	uint32 total2 = wp2->traveled + wp2->estimate;
+	if (total1 != total2) return total1 < total2;
+	return wp1->traveled < wp2->traveled;
+}
+
+/** Constructor of the path search data, memory is allocated when searching. */
+PathSearchData::PathSearchData() : visited({0, 0})
 {
+	this->in_use = false;
+	this->generation = 0;
+	this->position_count = 0;
+}
+
+PathSearchData::~PathSearchData()
+{
+	for (WalkedPosition *block : this->blocks) delete[] block;
+}
+
+/** Start a new search, forgetting all visited positions and open points of the previous search. */
+void PathSearchData::Start()
+{
+	this->generation++;
+	if (this->generation == 0) { // Wrapped around, old generation numbers may look valid again.
+		this->visited.Clear();
+		this->generation = 1;
+	}
+	this->position_count = 0;
+	this->open_points.clear();
 }
 
 /**
-* Compare two walked positions, and order on position.
-* @param wp1 First position to compare.
-* @param wp2 Second position to compare.
-* @return Whether \a wp1 should come before \a wp2.
-*/
-bool operator<(const WalkedPosition &wp1, const WalkedPosition &wp2)
+ * Get the walked position of a voxel.
+ * @param vox Coordinate of the voxel.
+ * @return The walked position of the voxel, or \c nullptr if it has not been visited in this search.
+ */
+WalkedPosition *PathSearchData::GetPosition(const XYZPoint16 &vox)
 {
-	return wp1.cur_vox < wp2.cur_vox;
+	const VisitedVoxel &vv = this->visited.Get(vox);
+	if (vv.generation != this->generation) return nullptr;
+	return &this->blocks[vv.position / POSITION_BLOCK_SIZE][vv.position % POSITION_BLOCK_SIZE];
 }
 
 /**
- * Walked distance constructor.
- * @param traveled Length of travel from the starting point to \a pos.
- * @param estimate Estimated length of remaining travel from \a pos to the destination.
- * @param pos Current position.
+ * Add a walked position for a voxel that has not been visited in this search.
+ * @param vox Coordinate of the voxel.
+ * @return The new walked position, only its #WalkedPosition::cur_vox is set.
  */
-WalkedDistance::WalkedDistance(uint32 traveled, uint32 estimate, const WalkedPosition *pos) : traveled(traveled), estimate(estimate), pos(pos)
+WalkedPosition *PathSearchData::AddPosition(const XYZPoint16 &vox)
 {
+	uint32 index = this->position_count++;
+	if (index / POSITION_BLOCK_SIZE == this->blocks.size()) this->blocks.push_back(new WalkedPosition[POSITION_BLOCK_SIZE]);
+
+	VisitedVoxel &vv = this->visited.GetModify(vox);
+	vv.generation = this->generation;
+	vv.position = index;
+
+	WalkedPosition *wp = &this->blocks[index / POSITION_BLOCK_SIZE][index % POSITION_BLOCK_SIZE];
+	wp->cur_vox = vox;
+	wp->heap_index = WalkedPosition::NOT_OPEN;
+	return wp;
 }
 
 /**
- * Compare two walked distances, and order on minimal total distance.
- * @param wd1 First distance to compare.
- * @param wd2 Second distance to compare.
- * @return Whether \a wd1 should come before \a wd2.
+ * Store a walked position in the heap of open points.
+ * @param index Index in the heap.
+ * @param wp Walked position to store.
  */
-bool operator<(const WalkedDistance &wd1, const WalkedDistance &wd2)
+inline void PathSearchData::SetHeapEntry(uint32 index, WalkedPosition *wp)
 {
-	uint32 total1 = wd1.traveled + wd1.estimate;
-	uint32 total2 = wd2.traveled + wd2.estimate;
-	if (total1 != total2) return total1 < total2;
-	return wd1.traveled < wd2.traveled;
+	this->open_points[index] = wp;
+	wp->heap_index = index;
+}
+
+/**
+ * Move a position up in the heap until its parent is not worse.
+ * @param index Index of the position in the heap.
+ */
+void PathSearchData::SiftUp(uint32 index)
+{
+	WalkedPosition *wp = this->open_points[index];
+	while (index > 0) {
+		uint32 parent = (index - 1) / 2;
+		if (!IsBetterPosition(wp, this->open_points[parent])) break;
+		this->SetHeapEntry(index, this->open_points[parent]);
+		index = parent;
+	}
+	this->SetHeapEntry(index, wp);
+}
+
+/**
+ * Move a position down in the heap until its children are not better.
+ * @param index Index of the position in the heap.
+ */
+void PathSearchData::SiftDown(uint32 index)
+{
+	WalkedPosition *wp = this->open_points[index];
+	uint32 count = this->open_points.size();
+	for (;;) {
+		uint32 child = 2 * index + 1;
+		if (child >= count) break;
+		if (child + 1 < count && IsBetterPosition(this->open_points[child + 1], this->open_points[child])) child++;
+		if (!IsBetterPosition(this->open_points[child], wp)) break;
+		this->SetHeapEntry(index, this->open_points[child]);
+		index = child;
+	}
+	this->SetHeapEntry(index, wp);
+}
+
+/**
+ * Add a position to the open points.
+ * @param wp Position to add, must not be open already.
+ */
+void PathSearchData::PushOpen(WalkedPosition *wp)
+{
+	assert(wp->heap_index == WalkedPosition::NOT_OPEN);
+	this->open_points.push_back(wp);
+	this->SiftUp(this->open_points.size() - 1);
+}
+
+/**
+ * Update the place of an open position after its distance has decreased, or add it if it was not open.
+ * @param wp Position with a decreased distance.
+ */
+void PathSearchData::UpdateOpen(WalkedPosition *wp)
+{
+	if (wp->heap_index == WalkedPosition::NOT_OPEN) {
+		this->PushOpen(wp);
+	} else {
+		this->SiftUp(wp->heap_index);
+	}
+}
+
+/**
+ * Take the best position from the open points.
+ * @return The open position with the shortest estimated path length.
+ * @pre There are open points left.
+ */
+WalkedPosition *PathSearchData::PopOpen()
+{
+	WalkedPosition *best = this->open_points.front();
+	best->heap_index = WalkedPosition::NOT_OPEN;
+
+	WalkedPosition *last = this->open_points.back();
+	this->open_points.pop_back();
+	if (!this->open_points.empty()) {
+		this->SetHeapEntry(0, last);
+		this->SiftDown(0);
+	}
+	return best;
+}
+
+/**
+ * Find the path voxels that can be reached from a voxel in a single step.
+ * @param vox Coordinate of the voxel to leave.
+ * @param neighbours [out] Coordinate of the reached path voxel for each edge, only valid for the edges in the returned set.
+ * @return Bit set of edges that lead to a neighbouring path voxel.
+ */
+uint8 GetPathNeighbours(const XYZPoint16 &vox, XYZPoint16 *neighbours)
+{
+	const Voxel *v = _world.GetVoxel(vox);
+	if (v == nullptr) return 0; // No voxel at the expected point, don't bother.
+
+	uint8 edges = 0;
+	uint8 exits = GetPathExits(v);
+	for (TileEdge edge = EDGE_BEGIN; edge < EDGE_COUNT; edge++) {
+		if ((exits & (0x11 << edge)) == 0) continue;
+
+		/* There is an outgoing connection, is it also on the world? */
+		Point16 dxy = _tile_dxy[edge];
+		if (dxy.x < 0 && vox.x == 0) continue;
+		if (dxy.x > 0 && vox.x + 1 == _world.GetXSize()) continue;
+		if (dxy.y < 0 && vox.y == 0) continue;
+		if (dxy.y > 0 && vox.y + 1 == _world.GetYSize()) continue;
+
+		int extra_z = ((exits & (0x10 << edge)) != 0);
+		if (vox.z + extra_z < 0 || vox.z + extra_z >= WORLD_Z_SIZE) continue;
+
+		/* Now check the other side, new_z is the voxel where the path should be at the bottom. */
+		const Voxel *v2 = _world.GetVoxel(vox + XYZPoint16(dxy.x, dxy.y, extra_z));
+		if (v2 == nullptr) continue;
+
+		uint8 other_exits = GetPathExits(v2);
+		if ((other_exits & (1 << ((edge + 2) % 4))) == 0) { // No path here, try one voxel below
+			extra_z--;
+			if (vox.z + extra_z < 0) continue;
+			v2 = _world.GetVoxel(vox + XYZPoint16(dxy.x, dxy.y, extra_z));
+			if (v2 == nullptr) continue;
+			other_exits = GetPathExits(v2);
+			if ((other_exits & (0x10 << ((edge + 2) % 4))) == 0) continue;
+		}
+		neighbours[edge] = vox + XYZPoint16(dxy.x, dxy.y, extra_z);
+		edges |= 1 << edge;
+	}
+	return edges;
 }
 
 /**
  * Constructor, find a path to (\a dest_x, \a dest_y, \a dest_z). Give starting points through PathSearcher::AddStart.
  * @param dest_vox Coordinate of the destination voxel.
+ * @note Only one path searcher can exist at a time, as they share their data structures.
  */
 PathSearcher::PathSearcher(const XYZPoint16 &dest_vox)
 {
 	this->dest_vox = dest_vox;
 	this->dest_pos = nullptr;
+	this->data = &_path_search_data;
+
+	assert(!this->data->in_use);
+	this->data->in_use = true;
+	this->data->Start();
+}
+
+/** Destructor, releases the search data for the next path searcher. */
+PathSearcher::~PathSearcher()
+{
+	this->data->in_use = false;
 }
 
 /**
@@ -98,24 +319,18 @@ inline uint32 PathSearcher::GetEstimate(const XYZPoint16 &vox)
 void PathSearcher::AddOpen(const XYZPoint16 &vox, uint32 traveled, const WalkedPosition *prev_pos)
 {
 	uint32 estimate = this->GetEstimate(vox);
-	WalkedPosition wp(vox, traveled, estimate, prev_pos);
-
-	/* Find the position. */
-	PositionSet::iterator pos_iter = this->positions.find(wp);
-	if (pos_iter == positions.end()) { // New position.
-		pos_iter = this->positions.insert(wp).first;
-		this->open_points.emplace(traveled, estimate, &(*pos_iter));
-		return;
+
+	WalkedPosition *wp = this->data->GetPosition(vox);
+	if (wp == nullptr) { // New position.
+		wp = this->data->AddPosition(vox);
+	} else if (wp->traveled + wp->estimate <= traveled + estimate) {
+		return; // Existing position is at least as good.
 	}
-	/* Existing position, update if needed. */
-	const WalkedPosition *pwp = &(*pos_iter);
-	if (pwp->traveled + pwp->estimate <= traveled + estimate) return;
 
-	/* New one is better, update. */
-	pwp->traveled = traveled;
-	pwp->estimate = estimate; // The sum is changed, making any old open points invalid.
-	pwp->prev_pos = prev_pos;
-	this->open_points.emplace(traveled, estimate, pwp);
+	wp->traveled = traveled;
+	wp->estimate = estimate;
+	wp->prev_pos = prev_pos;
+	this->data->UpdateOpen(wp);
 }
 
 /**
@@ -125,52 +340,20 @@ void PathSearcher::AddOpen(const XYZPoint16 &vox, uint32 traveled, const WalkedP
 bool PathSearcher::Search()
 {
 	this->dest_pos = nullptr;
-	while (!open_points.empty()) {
-		WalkedDistance wd = *open_points.begin();
-		open_points.erase(open_points.begin());
-
-		if (wd.traveled != wd.pos->traveled || wd.estimate != wd.pos->estimate) continue; // Invalid open point.
+	while (!this->data->IsOpenEmpty()) {
+		const WalkedPosition *wp = this->data->PopOpen();
 
 		/* Reached the destination? */
-		const WalkedPosition *wp = wd.pos;
 		if (wp->cur_vox == this->dest_vox) {
 			this->dest_pos = wp;
 			return true;
 		}
 
 		/* Add new open points. */
-		const Voxel *v = _world.GetVoxel(wp->cur_vox);
-		if (v == nullptr) continue; // No voxel at the expected point, don't bother.
-
-		uint8 exits = GetPathExits(v);
+		XYZPoint16 neighbours[EDGE_COUNT];
+		uint8 edges = GetPathNeighbours(wp->cur_vox, neighbours);
 		for (TileEdge edge = EDGE_BEGIN; edge < EDGE_COUNT; edge++) {
-			if ((exits & (0x11 << edge)) == 0) continue;
-
-			/* There is an outgoing connection, is it also on the world? */
-			Point16 dxy = _tile_dxy[edge];
-			if (dxy.x < 0 && wp->cur_vox.x == 0) continue;
-			if (dxy.x > 0 && wp->cur_vox.x + 1 == _world.GetXSize()) continue;
-			if (dxy.y < 0 && wp->cur_vox.y == 0) continue;
-			if (dxy.y > 0 && wp->cur_vox.y + 1 == _world.GetYSize()) continue;
-
-			int extra_z = ((exits & (0x10 << edge)) != 0);
-			if (wp->cur_vox.z + extra_z < 0 || wp->cur_vox.z + extra_z >= WORLD_Z_SIZE) continue;
-
-			/* Now check the other side, new_z is the voxel where the path should be at the bottom. */
-			const Voxel *v2 = _world.GetVoxel(wp->cur_vox + XYZPoint16(dxy.x, dxy.y, extra_z));
-			if (v2 == nullptr) continue;
-
-			uint8 other_exits = GetPathExits(v2);
-			if ((other_exits & (1 << ((edge + 2) % 4))) == 0) { // No path here, try one voxel below
-				extra_z--;
-				if (wp->cur_vox.z + extra_z < 0) continue;
-				v2 = _world.GetVoxel(wp->cur_vox + XYZPoint16(dxy.x, dxy.y, extra_z));
-				if (v2 == nullptr) continue;
-				other_exits = GetPathExits(v2);
-				if ((other_exits & (0x10 << ((edge + 2) % 4))) == 0) continue;
-			}
-			/* Add new open point to the path finder. */
-			this->AddOpen(wp->cur_vox + XYZPoint16(dxy.x, dxy.y, extra_z), wp->traveled + 1, wp);
+			if ((edges & (1 << edge)) != 0) this->AddOpen(neighbours[edge], wp->traveled + 1, wp);
 		}
 	}
 	return false;
@@ -179,8 +362,7 @@ bool PathSearcher::Search()
 /** Clear the used data structures of the path searcher. */
 void PathSearcher::Clear()
 {
-	this->open_points.clear();
-	this->positions.clear();
+	this->data->Start();
 	this->dest_pos = nullptr;
 }
 
@@ -10,38 +10,27 @@
 #ifndef PATH_FINDING_H
 #define PATH_FINDING_H
 
-#include <set>
-
 #include "geometry.h"
 
+class PathSearchData;
+
 /** Intermediate position of a walk. */
 class WalkedPosition {
 public:
-	WalkedPosition(const XYZPoint16 &cur_vox, uint32 traveled, uint32 estimate, const WalkedPosition *prev_pos);
-
 	XYZPoint16 cur_vox; ///< Coordinate of the current position.
-	mutable uint32 traveled; ///< Length of the traveled path so far.
-	mutable uint32 estimate; ///< Estimated distance to the destination.
-	mutable const WalkedPosition *prev_pos; ///< Position coming from (\c nullptr for initial position).
-};
-
-/** Guessed path length at a (partially) explored position. */
-class WalkedDistance {
-public:
-	WalkedDistance(uint32 traveled, uint32 estimate, const WalkedPosition *pos);
-
 	uint32 traveled; ///< Length of the traveled path so far.
 	uint32 estimate; ///< Estimated distance to the destination.
-	const WalkedPosition *pos; ///< Current position.
-};
+	const WalkedPosition *prev_pos; ///< Position coming from (\c nullptr for initial position).
+	uint32 heap_index; ///< Index of the position in the heap of open points, or #NOT_OPEN.
 
-typedef std::set<WalkedPosition> PositionSet;	  ///< Visited positions (best solution so far).
-typedef std::multiset<WalkedDistance> OpenPoints; ///< Points for further exploration.
+	static const uint32 NOT_OPEN = UINT32_MAX; ///< Value of #heap_index for positions that are not open for further exploration.
+};
 
 /** Class for searching (and hopefully finding) a path between tiles. */
 class PathSearcher {
 public:
 	PathSearcher(const XYZPoint16 &dest_vox);
+	~PathSearcher();
 
 	void AddStart(const XYZPoint16 &start_vox);
 	bool Search();
@@ -51,12 +40,13 @@ public:
 	const WalkedPosition *dest_pos; ///< If path was found, this points to the end-point of the walk.
 
 protected:
-	PositionSet positions;   ///< Examined positions.
-	OpenPoints  open_points; ///< Open points to examine further.
+	PathSearchData *data; ///< Visited positions and open points of the search.
 
 	inline uint32 GetEstimate(const XYZPoint16 &vox);
 	void AddOpen(const XYZPoint16 &vox, uint32 traveled, const WalkedPosition *prev_pos);
 };
 
+uint8 GetPathNeighbours(const XYZPoint16 &vox, XYZPoint16 *neighbours);
+
 #endif
 
@@ -0,0 +1,599 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file path_graph.cpp Graph of the path network. */
+
+#include "stdafx.h"
+#include "path_graph.h"
+#include "path_finding.h"
+#include "map.h"
+#include <algorithm>
+
+PathGraph _path_graph; ///< Graph of the paths in the world.
+
+/*
+ * Voxel elements store the part of the graph that a voxel belongs to.
+ * A node is stored as its index with #ELEMENT_NODE set, a segment is stored as its index plus one.
+ */
+static const uint32 ELEMENT_NONE = 0;          ///< %Voxel is not part of the graph.
+static const uint32 ELEMENT_NODE = 0x80000000; ///< Flag denoting the voxel is a node.
+
+/**
+ * Count the number of edges in a set of edges.
+ * @param edges Bit set of edges.
+ * @return Number of edges in the set.
+ */
+static inline uint CountEdges(uint8 edges)
+{
+	uint count = 0;
+	for (; edges != 0; edges &= edges - 1) count++;
+	return count;
+}
+
+/**
+ * Does the voxel contain a path?
+ * @param vox Coordinate of the voxel.
+ * @return Whether the voxel has a valid path.
+ */
+static bool IsPathVoxel(const XYZPoint16 &vox)
+{
+	const Voxel *v = _world.GetVoxel(vox);
+	return v != nullptr && HasValidPath(v);
+}
+
+/**
+ * Is the path voxel simply a piece of path between two other path voxels? Such a voxel is part of a segment of the graph,
+ * all other path voxels are nodes.
+ * @param vox Coordinate of the path voxel.
+ * @return Whether the path voxel connects to exactly two other path voxels, and has no other exits.
+ */
+static bool IsPassThroughVoxel(const XYZPoint16 &vox)
+{
+	XYZPoint16 neighbours[EDGE_COUNT];
+	if (CountEdges(GetPathNeighbours(vox, neighbours)) != 2) return false;
+
+	uint8 exits = GetPathExits(_world.GetVoxel(vox));
+	return CountEdges((exits | (exits >> 4)) & 0xF) == 2;
+}
+
+PathGraph::PathGraph() : voxel_elements(ELEMENT_NONE), voxel_positions(0)
+{
+	this->built = false;
+	this->version = 0;
+	this->xsize = 0;
+	this->ysize = 0;
+	this->generation = 0;
+}
+
+/** Forget the graph, for example when the world changes completely. It is built again when it is needed. */
+void PathGraph::Clear()
+{
+	this->built = false;
+	this->version++;
+	this->nodes.clear();
+	this->free_nodes.clear();
+	this->segments.clear();
+	this->free_segments.clear();
+	this->voxel_elements.Clear();
+	this->voxel_positions.Clear();
+	this->pending_nodes.clear();
+	this->node_search.clear();
+	this->open_nodes.clear();
+}
+
+/**
+ * Is the voxel inside the world of the graph?
+ * @param vox Coordinate of the voxel.
+ * @return Whether the voxel coordinate is valid.
+ */
+bool PathGraph::IsInWorld(const XYZPoint16 &vox) const
+{
+	return vox.x >= 0 && vox.x < this->xsize && vox.y >= 0 && vox.y < this->ysize && vox.z >= 0 && vox.z < WORLD_Z_SIZE;
+}
+
+/**
+ * Get a voxel of a segment, including its end nodes.
+ * @param ps Segment to examine.
+ * @param pos Position in the segment, \c 0 is the first node, the length of the segment is the second node.
+ * @return Coordinate of the voxel at the given position.
+ */
+XYZPoint16 PathGraph::GetSegmentVoxel(const PathSegment &ps, uint32 pos) const
+{
+	if (pos == 0) return this->nodes[ps.nodes[0]].vox;
+	if (pos == ps.GetLength()) return this->nodes[ps.nodes[1]].vox;
+	return ps.voxels[pos - 1];
+}
+
+/** Build the graph of all paths in the world. */
+void PathGraph::Build()
+{
+	this->Clear();
+	this->built = true;
+	this->xsize = _world.GetXSize();
+	this->ysize = _world.GetYSize();
+
+	/* Only chunks with paths or rides can have path voxels, the stacks of the other chunks are skipped. */
+	uint16 x_chunks = (this->xsize + WORLD_CHUNK_MASK) >> WORLD_CHUNK_SHIFT;
+	uint16 y_chunks = (this->ysize + WORLD_CHUNK_MASK) >> WORLD_CHUNK_SHIFT;
+	std::vector<bool> has_rides(x_chunks * y_chunks);
+	for (uint16 cy = 0; cy < y_chunks; cy++) {
+		for (uint16 cx = 0; cx < x_chunks; cx++) {
+			const VoxelChunk *chunk = _world.GetChunk(cx << WORLD_CHUNK_SHIFT, cy << WORLD_CHUNK_SHIFT);
+			has_rides[cx + cy * x_chunks] = chunk != nullptr && chunk->HasRides();
+		}
+	}
+
+	for (uint16 x = 0; x < this->xsize; x++) {
+		for (uint16 y = 0; y < this->ysize; y++) {
+			if (!has_rides[(x >> WORLD_CHUNK_SHIFT) + (y >> WORLD_CHUNK_SHIFT) * x_chunks]) {
+				y |= WORLD_CHUNK_MASK;
+				continue;
+			}
+			const VoxelStack *vs = _world.GetStack(x, y);
+			for (int i = 0; i < vs->height; i++) {
+				XYZPoint16 vox(x, y, vs->base + i);
+				if (IsPathVoxel(vox) && !IsPassThroughVoxel(vox)) this->AddNode(vox);
+			}
+		}
+	}
+	this->TracePendingNodes();
+
+	/* Remaining path voxels are in loops without nodes. */
+	for (uint16 x = 0; x < this->xsize; x++) {
+		for (uint16 y = 0; y < this->ysize; y++) {
+			if (!has_rides[(x >> WORLD_CHUNK_SHIFT) + (y >> WORLD_CHUNK_SHIFT) * x_chunks]) {
+				y |= WORLD_CHUNK_MASK;
+				continue;
+			}
+			const VoxelStack *vs = _world.GetStack(x, y);
+			for (int i = 0; i < vs->height; i++) this->CoverVoxel(XYZPoint16(x, y, vs->base + i));
+		}
+	}
+}
+
+/**
+ * Add a node to the graph. Its segments are traced by #TracePendingNodes.
+ * @param vox Coordinate of the path voxel of the node, must not be part of the graph yet.
+ * @return Index of the new node.
+ */
+uint32 PathGraph::AddNode(const XYZPoint16 &vox)
+{
+	uint32 node;
+	if (this->free_nodes.empty()) {
+		node = this->nodes.size();
+		this->nodes.emplace_back();
+	} else {
+		node = this->free_nodes.back();
+		this->free_nodes.pop_back();
+	}
+
+	PathNode &pn = this->nodes[node];
+	pn.vox = vox;
+	for (TileEdge edge = EDGE_BEGIN; edge < EDGE_COUNT; edge++) pn.segments[edge] = INVALID_PATH_ELEMENT;
+	pn.used = true;
+
+	uint32 &element = this->voxel_elements.GetModify(vox);
+	assert(element == ELEMENT_NONE);
+	element = ELEMENT_NODE | node;
+
+	this->pending_nodes.push_back(node);
+	return node;
+}
+
+/**
+ * Remove a node and its segments from the graph.
+ * @param node Index of the node to remove.
+ * @param released [out] Voxels that are not part of the graph any more. Nodes at the other end of the removed segments are added too.
+ */
+void PathGraph::RemoveNode(uint32 node, std::vector<XYZPoint16> *released)
+{
+	PathNode &pn = this->nodes[node];
+	for (TileEdge edge = EDGE_BEGIN; edge < EDGE_COUNT; edge++) {
+		if (pn.segments[edge] != INVALID_PATH_ELEMENT) this->RemoveSegment(pn.segments[edge], released);
+	}
+
+	this->voxel_elements.GetModify(pn.vox) = ELEMENT_NONE;
+	released->push_back(pn.vox);
+	pn.used = false;
+	this->free_nodes.push_back(node);
+}
+
+/**
+ * Remove a segment from the graph.
+ * @param segment Index of the segment to remove.
+ * @param released [out] Voxels that are not part of the graph any more, and the end nodes of the segment.
+ */
+void PathGraph::RemoveSegment(uint32 segment, std::vector<XYZPoint16> *released)
+{
+	PathSegment &ps = this->segments[segment];
+	for (const XYZPoint16 &vox : ps.voxels) {
+		this->voxel_elements.GetModify(vox) = ELEMENT_NONE;
+		released->push_back(vox);
+	}
+	for (int i = 0; i < 2; i++) {
+		this->nodes[ps.nodes[i]].segments[ps.edges[i]] = INVALID_PATH_ELEMENT;
+		released->push_back(this->nodes[ps.nodes[i]].vox);
+	}
+
+	ps.voxels.clear();
+	ps.used = false;
+	this->free_segments.push_back(segment);
+}
+
+/**
+ * Follow the path from a node through pass-through voxels until the next node, and add the segment to the graph.
+ * A voxel without choices that is not part of a proper segment becomes a node instead.
+ * @param node Index of the node to start from.
+ * @param edge Edge of the node to leave, must not have a segment yet.
+ */
+void PathGraph::TraceSegment(uint32 node, TileEdge edge)
+{
+	XYZPoint16 neighbours[EDGE_COUNT];
+	if ((GetPathNeighbours(this->nodes[node].vox, neighbours) & (1 << edge)) == 0) return;
+
+	uint32 segment;
+	if (this->free_segments.empty()) {
+		segment = this->segments.size();
+		this->segments.emplace_back();
+	} else {
+		segment = this->free_segments.back();
+		this->free_segments.pop_back();
+	}
+
+	std::vector<XYZPoint16> &voxels = this->segments[segment].voxels;
+	assert(voxels.empty());
+
+	XYZPoint16 prev = this->nodes[node].vox;
+	XYZPoint16 cur = neighbours[edge];
+	uint32 end_node = INVALID_PATH_ELEMENT;
+	for (;;) {
+		uint32 &element = this->voxel_elements.GetModify(cur);
+		if ((element & ELEMENT_NODE) != 0) {
+			end_node = element & ~ELEMENT_NODE;
+			break;
+		}
+		if (element != ELEMENT_NONE) break; // Voxel is already part of a segment.
+		if (!IsPassThroughVoxel(cur)) {
+			end_node = this->AddNode(cur);
+			break;
+		}
+
+		/* Continue at the neighbour that does not lead back. */
+		uint8 edges = GetPathNeighbours(cur, neighbours);
+		TileEdge back = INVALID_EDGE;
+		TileEdge forward = INVALID_EDGE;
+		for (TileEdge e = EDGE_BEGIN; e < EDGE_COUNT; e++) {
+			if ((edges & (1 << e)) == 0) continue;
+			if (neighbours[e] == prev) {
+				back = e;
+			} else {
+				forward = e;
+			}
+		}
+		if (back == INVALID_EDGE || forward == INVALID_EDGE || voxels.size() + 1 == UINT16_MAX) {
+			end_node = this->AddNode(cur); // The way back is missing, or the segment is too long.
+			break;
+		}
+
+		element = segment + 1;
+		voxels.push_back(cur);
+		this->voxel_positions.GetModify(cur) = voxels.size();
+		prev = cur;
+		cur = neighbours[forward];
+	}
+
+	/* Find the edge of the end node where the segment arrives. */
+	TileEdge end_edge = INVALID_EDGE;
+	if (end_node != INVALID_PATH_ELEMENT) {
+		const PathNode &pn = this->nodes[end_node];
+		uint8 edges = GetPathNeighbours(pn.vox, neighbours);
+		for (TileEdge e = EDGE_BEGIN; e < EDGE_COUNT; e++) {
+			if ((edges & (1 << e)) == 0 || neighbours[e] != prev || pn.segments[e] != INVALID_PATH_ELEMENT) continue;
+			if (end_node == node && e == edge) continue;
+			end_edge = e;
+			break;
+		}
+	}
+
+	if (end_edge == INVALID_EDGE) { // No proper segment, make its voxels nodes.
+		std::vector<XYZPoint16> loose;
+		loose.swap(voxels);
+		this->free_segments.push_back(segment);
+		for (const XYZPoint16 &vox : loose) {
+			this->voxel_elements.GetModify(vox) = ELEMENT_NONE;
+			this->AddNode(vox);
+		}
+		return;
+	}
+
+	PathSegment &ps = this->segments[segment];
+	ps.nodes[0] = node;
+	ps.edges[0] = edge;
+	ps.nodes[1] = end_node;
+	ps.edges[1] = end_edge;
+	ps.used = true;
+	this->nodes[node].segments[edge] = segment;
+	this->nodes[end_node].segments[end_edge] = segment;
+}
+
+/** Trace the missing segments of the pending nodes. */
+void PathGraph::TracePendingNodes()
+{
+	while (!this->pending_nodes.empty()) {
+		uint32 node = this->pending_nodes.back();
+		this->pending_nodes.pop_back();
+		if (!this->nodes[node].used) continue;
+
+		XYZPoint16 neighbours[EDGE_COUNT];
+		uint8 edges = GetPathNeighbours(this->nodes[node].vox, neighbours);
+		for (TileEdge edge = EDGE_BEGIN; edge < EDGE_COUNT; edge++) {
+			if ((edges & (1 << edge)) != 0 && this->nodes[node].segments[edge] == INVALID_PATH_ELEMENT) this->TraceSegment(node, edge);
+		}
+	}
+}
+
+/**
+ * Make sure a path voxel is part of the graph, by making it a node if it is not covered yet.
+ * @param vox Coordinate of the voxel.
+ */
+void PathGraph::CoverVoxel(const XYZPoint16 &vox)
+{
+	if (this->voxel_elements.Get(vox) != ELEMENT_NONE || !IsPathVoxel(vox)) return;
+
+	this->AddNode(vox);
+	this->TracePendingNodes();
+}
+
+/**
+ * Update the graph after the paths at or around a voxel have changed.
+ * @param vox Coordinate of the changed voxel.
+ */
+void PathGraph::UpdateVoxel(const XYZPoint16 &vox)
+{
+	this->version++;
+	if (!this->built) return;
+
+	/* Changing a path also changes the edges of its neighbours. */
+	std::vector<XYZPoint16> changed;
+	for (int dx = -1; dx <= 1; dx++) {
+		for (int dy = -1; dy <= 1; dy++) {
+			for (int dz = -2; dz <= 2; dz++) {
+				XYZPoint16 pos(vox.x + dx, vox.y + dy, vox.z + dz);
+				if (this->IsInWorld(pos)) changed.push_back(pos);
+			}
+		}
+	}
+
+	/* Take the changed part out of the graph. */
+	std::vector<XYZPoint16> released;
+	for (const XYZPoint16 &pos : changed) {
+		uint32 element = this->voxel_elements.Get(pos);
+		if ((element & ELEMENT_NODE) != 0) {
+			this->RemoveNode(element & ~ELEMENT_NODE, &released);
+		} else if (element != ELEMENT_NONE) {
+			this->RemoveSegment(element - 1, &released);
+		}
+	}
+
+	/* Add the changed part again. */
+	for (const XYZPoint16 &pos : changed) {
+		if (this->voxel_elements.Get(pos) == ELEMENT_NONE && IsPathVoxel(pos) && !IsPassThroughVoxel(pos)) this->AddNode(pos);
+	}
+	for (const XYZPoint16 &pos : released) {
+		uint32 element = this->voxel_elements.Get(pos);
+		if ((element & ELEMENT_NODE) != 0) this->pending_nodes.push_back(element & ~ELEMENT_NODE);
+	}
+	this->TracePendingNodes();
+
+	for (const XYZPoint16 &pos : changed) this->CoverVoxel(pos);
+	for (const XYZPoint16 &pos : released) this->CoverVoxel(pos);
+}
+
+/**
+ * Notify the graph of a change in the routes that does not change the paths, like a change in the park border.
+ * Flow fields are computed again when they are used next.
+ */
+void PathGraph::MarkChanged()
+{
+	this->version++;
+}
+
+/**
+ * Compare two nodes to explore.
+ * @param on1 First node.
+ * @param on2 Second node.
+ * @return Whether \a on1 should be explored after \a on2.
+ */
+bool PathGraph::IsFartherNode(const OpenNode &on1, const OpenNode &on2)
+{
+	return on1.distance > on2.distance;
+}
+
+/**
+ * A path from a start has reached a node. Add the node for exploring if the path is shorter than the known path.
+ * @param node Index of the reached node.
+ * @param distance Length of the path from the start.
+ * @param prev Voxel before the node at the path.
+ */
+void PathGraph::ReachNode(uint32 node, uint32 distance, const XYZPoint16 &prev)
+{
+	NodeSearch &ns = this->node_search[node];
+	if (ns.generation == this->generation) {
+		if (ns.settled || ns.distance <= distance) return;
+	} else {
+		ns.generation = this->generation;
+		ns.settled = false;
+	}
+	ns.distance = distance;
+	ns.prev = prev;
+
+	this->open_nodes.push_back({distance, node});
+	std::push_heap(this->open_nodes.begin(), this->open_nodes.end(), IsFartherNode);
+}
+
+/**
+ * Take the nearest node from the nodes to explore, its distance becomes final.
+ * @return Index of the nearest node, or #INVALID_PATH_ELEMENT if there are no nodes left to explore.
+ */
+uint32 PathGraph::PopNearestNode()
+{
+	while (!this->open_nodes.empty()) {
+		std::pop_heap(this->open_nodes.begin(), this->open_nodes.end(), IsFartherNode);
+		OpenNode on = this->open_nodes.back();
+		this->open_nodes.pop_back();
+
+		NodeSearch &ns = this->node_search[on.node];
+		if (ns.settled || ns.distance != on.distance) continue; // Outdated entry.
+		ns.settled = true;
+		return on.node;
+	}
+	return INVALID_PATH_ELEMENT;
+}
+
+/**
+ * Reach the nodes at the other end of the segments of a node.
+ * @param node Index of the node to expand, its distance must be final.
+ */
+void PathGraph::ExpandNode(uint32 node)
+{
+	const PathNode &pn = this->nodes[node];
+	uint32 distance = this->node_search[node].distance;
+	for (TileEdge edge = EDGE_BEGIN; edge < EDGE_COUNT; edge++) {
+		if (pn.segments[edge] == INVALID_PATH_ELEMENT) continue;
+
+		const PathSegment &ps = this->segments[pn.segments[edge]];
+		uint32 length = ps.GetLength();
+		if (ps.nodes[0] == node && ps.edges[0] == edge) {
+			this->ReachNode(ps.nodes[1], distance + length, this->GetSegmentVoxel(ps, length - 1));
+		} else {
+			this->ReachNode(ps.nodes[0], distance + length, this->GetSegmentVoxel(ps, 1));
+		}
+	}
+}
+
+/**
+ * Compute the ways to the nearest target from all nodes, by searching from all targets at the same time.
+ * @param targets Coordinates of the target voxels.
+ * @param ff [out] Flow field to fill.
+ */
+void PathGraph::ComputeFlowField(const std::vector<XYZPoint16> &targets, FlowField *ff)
+{
+	if (!this->built) this->Build();
+
+	this->generation++;
+	if (this->generation == 0) { // Wrapped around, old generation numbers may look valid again.
+		for (NodeSearch &ns : this->node_search) ns.generation = 0;
+		this->generation = 1;
+	}
+	if (this->node_search.size() < this->nodes.size()) this->node_search.resize(this->nodes.size(), {0, 0, XYZPoint16(), false});
+	this->open_nodes.clear();
+
+	ff->segment_targets.clear();
+	for (const XYZPoint16 &target : targets) {
+		if (!this->IsInWorld(target)) continue;
+		uint32 element = this->voxel_elements.Get(target);
+		if (element == ELEMENT_NONE) continue;
+
+		if ((element & ELEMENT_NODE) != 0) {
+			this->ReachNode(element & ~ELEMENT_NODE, 0, target);
+			continue;
+		}
+		const PathSegment &ps = this->segments[element - 1];
+		uint32 pos = this->voxel_positions.Get(target);
+		uint32 length = ps.GetLength();
+		this->ReachNode(ps.nodes[0], pos, this->GetSegmentVoxel(ps, 1));
+		this->ReachNode(ps.nodes[1], length - pos, this->GetSegmentVoxel(ps, length - 1));
+		ff->segment_targets.push_back({element - 1, pos});
+	}
+
+	ff->nodes.assign(this->nodes.size(), {UINT32_MAX, INVALID_EDGE});
+	for (;;) {
+		uint32 node = this->PopNearestNode();
+		if (node == INVALID_PATH_ELEMENT) break;
+
+		const NodeSearch &ns = this->node_search[node];
+		FlowField::FlowNode &fn = ff->nodes[node];
+		fn.distance = ns.distance;
+		if (ns.distance > 0) {
+			const XYZPoint16 &vox = this->nodes[node].vox;
+			fn.edge = GetAdjacentEdge(vox.x, vox.y, ns.prev.x, ns.prev.y);
+		}
+		this->ExpandNode(node);
+	}
+}
+
+/**
+ * Get the direction to walk from a path voxel to the nearest target of a flow field.
+ * @param ff Flow field computed for the current graph.
+ * @param vox Coordinate of the current position.
+ * @return Edge to leave the current position, or #INVALID_EDGE if no path exists or the current position is a target.
+ */
+TileEdge PathGraph::GetFlowDirection(const FlowField &ff, const XYZPoint16 &vox) const
+{
+	if (!this->IsInWorld(vox)) return INVALID_EDGE;
+	uint32 element = this->voxel_elements.Get(vox);
+	if (element == ELEMENT_NONE) return INVALID_EDGE;
+	if ((element & ELEMENT_NODE) != 0) return ff.nodes[element & ~ELEMENT_NODE].edge;
+
+	/* Inside a segment, go to the nearer end node, or to a target in the segment. */
+	const PathSegment &ps = this->segments[element - 1];
+	uint32 pos = this->voxel_positions.Get(vox);
+	uint32 best_distance = UINT32_MAX;
+	uint32 best_pos = 0;
+
+	uint32 distance = ff.nodes[ps.nodes[0]].distance;
+	if (distance != UINT32_MAX && distance + pos < best_distance) {
+		best_distance = distance + pos;
+		best_pos = pos - 1;
+	}
+	distance = ff.nodes[ps.nodes[1]].distance;
+	if (distance != UINT32_MAX && distance + ps.GetLength() - pos < best_distance) {
+		best_distance = distance + ps.GetLength() - pos;
+		best_pos = pos + 1;
+	}
+	for (const FlowField::SegmentTarget &st : ff.segment_targets) {
+		if (st.segment != element - 1) continue;
+		if (st.position == pos) return INVALID_EDGE; // Already at a target.
+
+		distance = (st.position < pos) ? pos - st.position : st.position - pos;
+		if (distance < best_distance) {
+			best_distance = distance;
+			best_pos = (st.position < pos) ? pos - 1 : pos + 1;
+		}
+	}
+	if (best_distance == UINT32_MAX) return INVALID_EDGE;
+
+	XYZPoint16 next = this->GetSegmentVoxel(ps, best_pos);
+	return GetAdjacentEdge(vox.x, vox.y, next.x, next.y);
+}
+
+FlowField::FlowField()
+{
+	this->valid = false;
+	this->version = 0;
+}
+
+FlowField::~FlowField()
+{
+}
+
+/**
+ * Get the direction to walk from a path voxel to the nearest target.
+ * @param vox Coordinate of the current position.
+ * @return Edge to leave the current position, or #INVALID_EDGE if no path exists or the current position is a target.
+ */
+TileEdge FlowField::GetDirection(const XYZPoint16 &vox)
+{
+	if (!this->valid || this->version != _path_graph.version) {
+		std::vector<XYZPoint16> targets;
+		this->GetTargets(&targets);
+		_path_graph.ComputeFlowField(targets, this);
+		this->valid = true;
+		this->version = _path_graph.version;
+	}
+	return _path_graph.GetFlowDirection(*this, vox);
+}
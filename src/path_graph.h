@@ -0,0 +1,155 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file path_graph.h Graph of the path network, for finding routes over the paths. */
+
+#ifndef PATH_GRAPH_H
+#define PATH_GRAPH_H
+
+#include "geometry.h"
+#include "tile.h"
+#include "map.h"
+#include <vector>
+
+static const uint32 INVALID_PATH_ELEMENT = UINT32_MAX; ///< Index of a non-existing node or segment in the path graph.
+
+/**
+ * Node in the path graph. A node is a path voxel where a walker has something to decide, like a junction,
+ * a dead end, or a path next to a ride entrance.
+ */
+struct PathNode {
+	XYZPoint16 vox;              ///< Coordinate of the path voxel of the node.
+	uint32 segments[EDGE_COUNT]; ///< Segment leaving the node at each edge, #INVALID_PATH_ELEMENT if there is none.
+	bool used;                   ///< Whether the node is in use.
+};
+
+/** Segment in the path graph, a sequence of path voxels without choices between two nodes. */
+struct PathSegment {
+	uint32 nodes[2];                ///< Nodes at both ends of the segment, may be the same node.
+	TileEdge edges[2];              ///< Edge of each end node where the segment leaves the node.
+	std::vector<XYZPoint16> voxels; ///< Path voxels between the end nodes, ordered from the first to the second node.
+	bool used;                      ///< Whether the segment is in use.
+
+	/**
+	 * Get the length of the segment.
+	 * @return Number of steps to walk from one end node to the other end node.
+	 */
+	inline uint32 GetLength() const
+	{
+		return this->voxels.size() + 1;
+	}
+};
+
+/**
+ * Directions from every path voxel to the nearest of a set of target voxels.
+ * The directions are computed over the path graph when they are first needed after a change in the paths,
+ * so all walkers going to the same targets share a single search.
+ */
+class FlowField {
+	friend class PathGraph;
+
+public:
+	FlowField();
+	virtual ~FlowField();
+
+	TileEdge GetDirection(const XYZPoint16 &vox);
+
+protected:
+	/**
+	 * Collect the voxels to walk to.
+	 * @param targets [out] Coordinates of the target voxels.
+	 */
+	virtual void GetTargets(std::vector<XYZPoint16> *targets) = 0;
+
+private:
+	/** Way to the nearest target from a node. */
+	struct FlowNode {
+		uint32 distance; ///< Length of the path to the nearest target, \c UINT32_MAX if no target can be reached.
+		TileEdge edge;   ///< Edge to leave the node, #INVALID_EDGE if the node is a target or no target can be reached.
+	};
+
+	/** Target voxel inside a segment. */
+	struct SegmentTarget {
+		uint32 segment;  ///< Index of the segment.
+		uint32 position; ///< Position of the target in the segment.
+	};
+
+	bool valid;     ///< Whether the flow field has been computed.
+	uint32 version; ///< Version of the path graph that the flow field was computed for.
+	std::vector<FlowNode> nodes;                  ///< Way to the nearest target for each node of the path graph.
+	std::vector<SegmentTarget> segment_targets;   ///< Targets that are not a node.
+};
+
+/**
+ * Graph of the path network. Path voxels are either a node or part of a segment between two nodes.
+ * The graph is built when it is first needed, and kept up to date with #UpdateVoxel after that.
+ */
+class PathGraph {
+	friend class FlowField;
+
+public:
+	PathGraph();
+
+	void Clear();
+	void UpdateVoxel(const XYZPoint16 &vox);
+	void MarkChanged();
+
+private:
+	/** Search information of a node. */
+	struct NodeSearch {
+		uint32 generation; ///< Search generation that last reached the node.
+		uint32 distance;   ///< Length of the shortest known path from a start to the node.
+		XYZPoint16 prev;   ///< Voxel before the node at the shortest known path.
+		bool settled;      ///< Whether the distance of the node is final.
+	};
+
+	/** Node to explore in a search. */
+	struct OpenNode {
+		uint32 distance; ///< Length of the path from a start to the node.
+		uint32 node;     ///< Index of the node.
+	};
+
+	bool built;     ///< Whether the graph is built.
+	uint32 version; ///< Version of the graph, changes with every change of the paths.
+	uint16 xsize;   ///< Horizontal size of the world of the graph.
+	uint16 ysize;   ///< Vertical size of the world of the graph.
+
+	std::vector<PathNode> nodes;         ///< Nodes of the graph.
+	std::vector<uint32> free_nodes;      ///< Indices of the unused nodes.
+	std::vector<PathSegment> segments;   ///< Segments of the graph.
+	std::vector<uint32> free_segments;   ///< Indices of the unused segments.
+	VoxelChunkArray<uint32> voxel_elements;  ///< Node or segment of each voxel of the world.
+	VoxelChunkArray<uint16> voxel_positions; ///< Position of each voxel in its segment.
+	std::vector<uint32> pending_nodes;   ///< Nodes that may have segments that are not traced yet.
+
+	uint32 generation;                   ///< Generation of the current search.
+	std::vector<NodeSearch> node_search; ///< Search information of the nodes.
+	std::vector<OpenNode> open_nodes;    ///< Heap of nodes to explore, nearest node at the top.
+
+	void Build();
+	bool IsInWorld(const XYZPoint16 &vox) const;
+	XYZPoint16 GetSegmentVoxel(const PathSegment &ps, uint32 pos) const;
+
+	uint32 AddNode(const XYZPoint16 &vox);
+	void RemoveNode(uint32 node, std::vector<XYZPoint16> *released);
+	void RemoveSegment(uint32 segment, std::vector<XYZPoint16> *released);
+	void TraceSegment(uint32 node, TileEdge edge);
+	void TracePendingNodes();
+	void CoverVoxel(const XYZPoint16 &vox);
+
+	static bool IsFartherNode(const OpenNode &on1, const OpenNode &on2);
+	void ReachNode(uint32 node, uint32 distance, const XYZPoint16 &prev);
+	uint32 PopNearestNode();
+	void ExpandNode(uint32 node);
+
+	void ComputeFlowField(const std::vector<XYZPoint16> &targets, FlowField *ff);
+	TileEdge GetFlowDirection(const FlowField &ff, const XYZPoint16 &vox) const;
+};
+
+extern PathGraph _path_graph;
+
+#endif
@@ -17,9 +17,72 @@
 #include "person.h"
 #include "people.h"
 #include "gamelevel.h"
+#include "path_graph.h"
+#include "jobs.h"
 
 Guests _guests; ///< %Guests in the world/park.
 
+thread_local GuestCommandBuffer *_guest_commands = nullptr; ///< Buffer to record changes of guests updated in parallel, \c nullptr while updating serially.
+
+static const uint DAILY_GUESTS_PER_JOB = 32; ///< Number of guests getting their daily update in a single job.
+
+/**
+ * Record continuing the animation of a guest.
+ * @param g %Guest that advanced its animation.
+ * @param progress Progress of the animation.
+ */
+void GuestCommandBuffer::Animate(Guest *g, AnimateProgress progress)
+{
+	GuestCommand gc;
+	gc.type = GCT_ANIMATE;
+	gc.guest = g;
+	gc.progress = progress;
+	this->commands.push_back(gc);
+}
+
+/**
+ * Record de-activating a guest.
+ * @param g %Guest to de-activate.
+ */
+void GuestCommandBuffer::Remove(Guest *g)
+{
+	GuestCommand gc;
+	gc.type = GCT_REMOVE;
+	gc.guest = g;
+	this->commands.push_back(gc);
+}
+
+/**
+ * Record notifying windows of a change.
+ * @param wtype %Window type.
+ * @param wnumber Number of the window.
+ * @param code Unique change number.
+ * @param parameter Parameter of the change number.
+ */
+void GuestCommandBuffer::Notify(WindowTypes wtype, WindowNumber wnumber, ChangeCode code, uint32 parameter)
+{
+	GuestCommand gc;
+	gc.type = GCT_NOTIFY;
+	gc.guest = nullptr;
+	gc.wtype = wtype;
+	gc.wnumber = wnumber;
+	gc.code = code;
+	gc.parameter = parameter;
+	this->commands.push_back(gc);
+}
+
+/**
+ * Record deciding whether a guest drops its wrapper, which needs a random number.
+ * @param g %Guest with a wrapper.
+ */
+void GuestCommandBuffer::DropWrapper(Guest *g)
+{
+	GuestCommand gc;
+	gc.type = GCT_DROP_WRAPPER;
+	gc.guest = g;
+	this->commands.push_back(gc);
+}
+
 /**
  * Guest block constructor. Fills the id of the persons with an incrementing number.
  * @param base_id Id number of the first person in this block.
@@ -30,6 +93,47 @@ GuestBlock::GuestBlock(uint16 base_id)
 		this->guests[i].id = base_id;
 		base_id++;
 	}
+	for (uint i = 0; i < lengthof(this->active); i++) this->active[i] = 0;
+	this->active_count = 0;
+}
+
+/**
+ * Mark a guest as active or non-active.
+ * @param i Index of the person (should be between \c 0 and #GUEST_BLOCK_SIZE).
+ * @param active Whether the guest is active.
+ */
+void GuestBlock::SetActive(uint i, bool active)
+{
+	assert(i < lengthof(this->guests));
+	if (this->IsActive(i) == active) return;
+
+	uint64 bit = static_cast<uint64>(1) << (i % 64);
+	if (active) {
+		this->active[i / 64] |= bit;
+		this->active_count++;
+	} else {
+		this->active[i / 64] &= ~bit;
+		this->active_count--;
+	}
+}
+
+/**
+ * Collect the active guests of the block.
+ * @param guests [out] Array of #GUEST_BLOCK_SIZE entries to store the active guests.
+ * @return Number of active guests stored in \a guests.
+ */
+uint GuestBlock::GetActiveGuests(Guest **guests)
+{
+	uint count = 0;
+	if (this->active_count == 0) return count;
+
+	for (uint w = 0; w < lengthof(this->active); w++) {
+		uint64 bits = this->active[w];
+		for (uint i = w * 64; bits != 0; i++, bits >>= 1) {
+			if ((bits & 1) != 0) guests[count++] = &this->guests[i];
+		}
+	}
+	return count;
 }
 
 /**
@@ -66,29 +170,30 @@ static Point16 FindEdgeRoad()
 	return {-1, -1};
 }
 
-Guests::Guests() : block(0), rnd()
+Guests::Guests() : rnd()
 {
-	this->free_idx = 0;
+	this->active_count = 0;
 	this->start_voxel.x = -1;
 	this->start_voxel.y = -1;
 	this->daily_frac = 0;
 	this->next_daily_index = 0;
+	this->AddBlock();
 }
 
 Guests::~Guests()
 {
+	for (GuestBlock *gb : this->blocks) delete gb;
 }
 
 /** Deactivate all guests and reset variables. */
 void Guests::Uninitialize()
 {
-	for (int i = 0; i < GUEST_BLOCK_SIZE; i++) {
-		Guest *g = this->block.Get(i);
-		if (g->IsActive()) {
-			g->DeActivate(OAR_REMOVE);
-			this->AddFree(g);
-		}
+	Guest *guests[GUEST_BLOCK_SIZE];
+	for (GuestBlock *gb : this->blocks) {
+		uint count = gb->GetActiveGuests(guests);
+		for (uint i = 0; i < count; i++) guests[i]->DeActivate(OAR_REMOVE);
 	}
+	this->RebuildFreeGuests();
 	this->start_voxel.x = -1;
 	this->start_voxel.y = -1;
 	this->daily_frac = 0;
@@ -107,16 +212,25 @@ void Guests::Load(Loader &ldr)
 		this->start_voxel.y = ldr.GetWord();
 		this->daily_frac = ldr.GetWord();
 		this->next_daily_index = ldr.GetWord();
-		this->free_idx = ldr.GetLong();
+		ldr.GetLong(); // Lowest index of a non-active guest, the free guests are found after loading instead.
 		uint active_guest_count = ldr.GetLong();
 		for (uint i = 0; i < active_guest_count; i++) {
-			Guest *g = this->block.Get(ldr.GetWord());
+			uint16 id = ldr.GetWord();
+			while (id >= this->blocks.size() * GUEST_BLOCK_SIZE) {
+				if (!this->AddBlock()) break;
+			}
+			if (id >= this->blocks.size() * GUEST_BLOCK_SIZE) {
+				ldr.SetFailMessage("Guest number too high.");
+				break;
+			}
+			Guest *g = this->Get(id);
 			g->Load(ldr);
 		}
 	} else {
 		ldr.SetFailMessage("Incorrect version of Guests block.");
 	}
 	ldr.CloseBlock();
+	this->RebuildFreeGuests();
 }
 
 /**
@@ -130,45 +244,50 @@ void Guests::Save(Saver &svr)
 	svr.PutWord(this->start_voxel.y);
 	svr.PutWord(this->daily_frac);
 	svr.PutWord(this->next_daily_index);
-	svr.PutLong(this->free_idx);
+	svr.PutLong(0); // Lowest index of a non-active guest, not used any more.
 	svr.PutLong(this->CountActiveGuests());
-	for (uint i = 0; i < GUEST_BLOCK_SIZE; i++) {
-		Guest *g = this->block.Get(i);
-		if (g->IsActive()) {
-			svr.PutWord(g->id);
-			g->Save(svr);
+	Guest *guests[GUEST_BLOCK_SIZE];
+	for (GuestBlock *gb : this->blocks) {
+		uint count = gb->GetActiveGuests(guests);
+		for (uint i = 0; i < count; i++) {
+			svr.PutWord(guests[i]->id);
+			guests[i]->Save(svr);
 		}
 	}
 	svr.EndBlock();
 }
 
 /**
- * Update #free_idx to the next free guest (if available).
- * @return Whether a free guest was found.
+ * Add a block of non-active guests.
+ * @return Whether a block could be added.
  */
-bool Guests::FindNextFreeGuest()
+bool Guests::AddBlock()
 {
-	while (this->free_idx < GUEST_BLOCK_SIZE) {
-		Guest *g = this->block.Get(this->free_idx);
-		if (!g->IsActive()) return true;
-		this->free_idx++;
-	}
-	return false;
+	if (this->blocks.size() >= MAX_GUEST_BLOCKS) return false;
+
+	uint16 base_id = this->blocks.size() * GUEST_BLOCK_SIZE;
+	this->blocks.push_back(new GuestBlock(base_id));
+	for (int i = GUEST_BLOCK_SIZE - 1; i >= 0; i--) this->free_guests.push_back(base_id + i); // Lowest id at the back.
+	return true;
 }
 
-/**
- * Update #free_idx to the next free guest (if available).
- * @return Whether a free guest was found.
- */
-bool Guests::FindNextFreeGuest() const
+/** Find the active and non-active guests after guests were (de)activated without using #GetFree and #AddFree. */
+void Guests::RebuildFreeGuests()
 {
-	uint idx = this->free_idx;
-	while (idx < GUEST_BLOCK_SIZE) {
-		const Guest *g = this->block.Get(idx);
-		if (!g->IsActive()) return true;
-		idx++;
+	this->free_guests.clear();
+	this->active_count = 0;
+	for (int b = this->blocks.size() - 1; b >= 0; b--) {
+		GuestBlock *gb = this->blocks[b];
+		for (int i = GUEST_BLOCK_SIZE - 1; i >= 0; i--) {
+			const Guest *g = gb->Get(i);
+			gb->SetActive(i, g->IsActive());
+			if (g->IsActive()) {
+				this->active_count++;
+			} else {
+				this->free_guests.push_back(g->id);
+			}
+		}
 	}
-	return false;
 }
 
 /**
@@ -177,12 +296,7 @@ bool Guests::FindNextFreeGuest() const
  */
 uint Guests::CountActiveGuests()
 {
-	uint count = this->free_idx;
-	for (uint i = this->free_idx; i < GUEST_BLOCK_SIZE; i++) {
-		Guest *g = this->block.Get(i);
-		if (g->IsActive()) count++;
-	}
-	return count;
+	return this->active_count;
 }
 
 /**
@@ -192,48 +306,117 @@ uint Guests::CountActiveGuests()
 uint Guests::CountGuestsInPark()
 {
 	uint count = 0;
-	for (uint i = 0; i < GUEST_BLOCK_SIZE; i++) {
-		Guest *g = this->block.Get(i);
-		if (g->IsActive() && g->IsInPark()) count++;
+	Guest *guests[GUEST_BLOCK_SIZE];
+	for (GuestBlock *gb : this->blocks) {
+		uint active = gb->GetActiveGuests(guests);
+		for (uint i = 0; i < active; i++) {
+			if (guests[i]->IsInPark()) count++;
+		}
 	}
 	return count;
 }
 
+/**
+ * Do the changes recorded by the jobs of a parallel update, in the order of the jobs.
+ * @param job_count Number of jobs of the update.
+ */
+void Guests::ApplyCommands(uint job_count)
+{
+	for (uint j = 0; j < job_count; j++) {
+		GuestCommandBuffer &gcb = this->command_buffers[j];
+		for (const GuestCommand &gc : gcb.commands) {
+			switch (gc.type) {
+				case GCT_ANIMATE: {
+					AnimateResult ar = gc.guest->ContinueAnimation(gc.progress);
+					if (ar != OAR_OK) {
+						gc.guest->DeActivate(ar);
+						this->AddFree(gc.guest);
+					}
+					break;
+				}
+
+				case GCT_REMOVE:
+					gc.guest->DeActivate(OAR_REMOVE);
+					this->AddFree(gc.guest);
+					break;
+
+				case GCT_NOTIFY:
+					NotifyChange(gc.wtype, gc.wnumber, gc.code, gc.parameter);
+					break;
+
+				case GCT_DROP_WRAPPER:
+					gc.guest->DecideDropWrapper();
+					break;
+
+				default: NOT_REACHED();
+			}
+		}
+		gcb.commands.clear();
+	}
+}
+
 /**
  * Some time has passed, update the animation.
+ * The guests of each block advance their animation in parallel, their walks end at the main thread afterwards.
  * @param delay Number of milliseconds time that have past since the last animation update.
  */
 void Guests::OnAnimate(int delay)
 {
-	for (int i = 0; i < GUEST_BLOCK_SIZE; i++) {
-		Guest *p = this->block.Get(i);
-		if (!p->IsActive()) continue;
-
-		AnimateResult ar = p->OnAnimate(delay);
-		if (ar != OAR_OK) {
-			p->DeActivate(ar);
-			this->AddFree(p);
+	uint block_count = this->blocks.size();
+	if (this->command_buffers.size() < block_count) this->command_buffers.resize(block_count);
+
+	_job_pool.Run(block_count, [this, delay](uint b) {
+		GuestBlock *gb = this->blocks[b];
+		if (gb->active_count == 0) return;
+
+		GuestCommandBuffer &gcb = this->command_buffers[b];
+		Guest *guests[GUEST_BLOCK_SIZE];
+		uint count = gb->GetActiveGuests(guests);
+		for (uint i = 0; i < count; i++) {
+			AnimateProgress progress = guests[i]->AdvanceAnimation(delay);
+			if (progress != AP_WAITING) gcb.Animate(guests[i], progress);
 		}
-	}
+	});
+	this->ApplyCommands(block_count);
 }
 
 /** A new frame arrived, perform the daily call for some of the guests. */
 void Guests::DoTick()
 {
+	int guest_count = this->blocks.size() * GUEST_BLOCK_SIZE;
 	this->daily_frac++;
-	int end_index = std::min(this->daily_frac * GUEST_BLOCK_SIZE / TICK_COUNT_PER_DAY, GUEST_BLOCK_SIZE);
+	int end_index = std::min(this->daily_frac * guest_count / TICK_COUNT_PER_DAY, guest_count);
+	this->daily_guests.clear();
 	while (this->next_daily_index < end_index) {
-		Guest *p = this->block.Get(this->next_daily_index);
-		if (p->IsActive() && !p->DailyUpdate()) {
-			p->DeActivate(OAR_REMOVE);
-			this->AddFree(p);
+		GuestBlock *gb = this->blocks[this->next_daily_index / GUEST_BLOCK_SIZE];
+		if (gb->active_count == 0) { // Skip the entire block.
+			this->next_daily_index = std::min((this->next_daily_index / GUEST_BLOCK_SIZE + 1) * GUEST_BLOCK_SIZE, end_index);
+			continue;
 		}
+
+		uint index = this->next_daily_index % GUEST_BLOCK_SIZE;
+		if (gb->IsActive(index)) this->daily_guests.push_back(gb->Get(index));
 		this->next_daily_index++;
 	}
-	if (this->next_daily_index >= GUEST_BLOCK_SIZE) {
+	if (this->next_daily_index >= guest_count) {
 		this->daily_frac = 0;
 		this->next_daily_index = 0;
 	}
+
+	uint job_count = (this->daily_guests.size() + DAILY_GUESTS_PER_JOB - 1) / DAILY_GUESTS_PER_JOB;
+	if (this->command_buffers.size() < job_count) this->command_buffers.resize(job_count);
+
+	_job_pool.Run(job_count, [this](uint j) {
+		GuestCommandBuffer &gcb = this->command_buffers[j];
+		_guest_commands = &gcb;
+		uint end = std::min<uint>((j + 1) * DAILY_GUESTS_PER_JOB, this->daily_guests.size());
+		for (uint i = j * DAILY_GUESTS_PER_JOB; i < end; i++) {
+			Guest *p = this->daily_guests[i];
+			if (!p->DailyUpdate()) gcb.Remove(p);
+		}
+		_guest_commands = nullptr;
+	});
+	this->ApplyCommands(job_count);
 }
 
 /**
@@ -246,16 +429,27 @@ void Guests::OnNewDay()
 	if (this->CountActiveGuests() >= _scenario.max_guests) return;
 	if (!this->rnd.Success1024(_scenario.GetSpawnProbability(512))) return;
 
+	this->SpawnGuest();
+}
+
+/**
+ * Add a new guest to the park, at the path at the edge of the world.
+ * @return Whether a guest was added.
+ */
+bool Guests::SpawnGuest()
+{
 	if (!IsGoodEdgeRoad(this->start_voxel.x, this->start_voxel.y)) {
 		/* New guest, but no road. */
 		this->start_voxel = FindEdgeRoad();
-		if (!IsGoodEdgeRoad(this->start_voxel.x, this->start_voxel.y)) return;
+		_path_graph.MarkChanged(); // Guests go home to another tile.
+		if (!IsGoodEdgeRoad(this->start_voxel.x, this->start_voxel.y)) return false;
 	}
 
-	if (!this->HasFreeGuests()) return; // No more quests available.
+	if (!this->HasFreeGuests()) return false; // No more quests available.
 	/* New guest! */
 	Guest *g = this->GetFree();
 	g->Activate(this->start_voxel, PERSON_GUEST);
+	return true;
 }
 
 /**
@@ -263,21 +457,20 @@ void Guests::OnNewDay()
  * @param ri Ride being removed.
  */
 void Guests::NotifyRideDeletion(const RideInstance *ri) {
-	for (int i = 0; i < GUEST_BLOCK_SIZE; i++) {
-		Guest *p = this->block.Get(i);
-		if (!p->IsActive()) continue;
-
-		p->NotifyRideDeletion(ri);
+	Guest *guests[GUEST_BLOCK_SIZE];
+	for (GuestBlock *gb : this->blocks) {
+		uint count = gb->GetActiveGuests(guests);
+		for (uint i = 0; i < count; i++) guests[i]->NotifyRideDeletion(ri);
 	}
 }
 
 /**
- * Return whether there are still non-active guests.
+ * Return whether there are still non-active guests, adding a block of guests if needed.
  * @return \c true if there are non-active guests, else \c false.
  */
-bool Guests::HasFreeGuests() const
+bool Guests::HasFreeGuests()
 {
-	return this->FindNextFreeGuest();
+	return !this->free_guests.empty() || this->AddBlock();
 }
 
 /**
@@ -286,7 +479,9 @@ bool Guests::HasFreeGuests() const
  */
 void Guests::AddFree(Guest *g)
 {
-	this->free_idx = std::min(this->block.Index(g), this->free_idx);
+	this->blocks[g->id / GUEST_BLOCK_SIZE]->SetActive(g->id % GUEST_BLOCK_SIZE, false);
+	this->free_guests.push_back(g->id);
+	this->active_count--;
 }
 
 /**
@@ -296,10 +491,11 @@ void Guests::AddFree(Guest *g)
  */
 Guest *Guests::GetFree()
 {
-	bool b = this->FindNextFreeGuest();
-	assert(b);
+	assert(!this->free_guests.empty());
+	uint16 id = this->free_guests.back();
+	this->free_guests.pop_back();
 
-	Guest *g = this->block.Get(this->free_idx);
-	this->free_idx++;
-	return g;
+	this->blocks[id / GUEST_BLOCK_SIZE]->SetActive(id % GUEST_BLOCK_SIZE, true);
+	this->active_count++;
+	return this->Get(id);
 }
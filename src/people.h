@@ -10,7 +10,11 @@
 #ifndef PEOPLE_H
 #define PEOPLE_H
 
+#include "window.h"
+#include <vector>
+
 static const int GUEST_BLOCK_SIZE = 512; ///< Number of guests in a block.
+static const int MAX_GUEST_BLOCKS = 0xFFFF / GUEST_BLOCK_SIZE; ///< Maximal number of guest blocks, guest ids must fit in 16 bit.
 
 /** A block of guests. */
 class GuestBlock {
@@ -44,20 +48,72 @@ public:
 	 * @param g %Guest object to query.
 	 * @return Index of the guest in the block.
 	 */
-	inline uint Index(Guest *g)
+	inline uint Index(const Guest *g) const
 	{
 		uint idx = g - this->guests;
 		assert(idx < lengthof(this->guests));
 		return idx;
 	}
 
+	/**
+	 * Is the guest at the given index active?
+	 * @param i Index of the person (should be between \c 0 and #GUEST_BLOCK_SIZE).
+	 * @return Whether the guest is marked as active.
+	 */
+	inline bool IsActive(uint i) const
+	{
+		return (this->active[i / 64] & (static_cast<uint64>(1) << (i % 64))) != 0;
+	}
+
+	void SetActive(uint i, bool active);
+	uint GetActiveGuests(Guest **guests);
+
+	uint64 active[GUEST_BLOCK_SIZE / 64]; ///< Bit set of the active guests in the block.
+	uint active_count;                     ///< Number of active guests in the block.
+
 protected:
 	Guest guests[GUEST_BLOCK_SIZE]; ///< Persons in the block.
 };
 
+/** Kinds of changes that guests updated in parallel leave for the main thread. */
+enum GuestCommandType {
+	GCT_ANIMATE,      ///< Continue the animation of the guest, see Person::ContinueAnimation.
+	GCT_REMOVE,       ///< De-activate the guest after its daily update.
+	GCT_NOTIFY,       ///< Notify windows of a change, see #NotifyChange.
+	GCT_DROP_WRAPPER, ///< Decide whether the guest drops its wrapper, see Guest::DecideDropWrapper.
+};
+
+/** Change left by a guest updated in parallel, to be done by the main thread. */
+struct GuestCommand {
+	GuestCommandType type;    ///< Kind of change.
+	Guest *guest;             ///< %Guest to change.
+	AnimateProgress progress; ///< Progress of the animation (#GCT_ANIMATE only).
+	WindowTypes wtype;        ///< Type of the windows to notify (#GCT_NOTIFY only).
+	WindowNumber wnumber;     ///< Number of the windows to notify (#GCT_NOTIFY only).
+	ChangeCode code;          ///< Change to notify (#GCT_NOTIFY only).
+	uint32 parameter;         ///< Parameter of the change (#GCT_NOTIFY only).
+};
+
+/**
+ * Changes of guests updated by one job, in the order of the guests.
+ * Guests only change themselves while updated in parallel. Changes to the world, the windows, or the shared random
+ * number generator are recorded instead, and done afterwards by the main thread in the order of a serial update.
+ */
+class GuestCommandBuffer {
+public:
+	void Animate(Guest *g, AnimateProgress progress);
+	void Remove(Guest *g);
+	void Notify(WindowTypes wtype, WindowNumber wnumber, ChangeCode code, uint32 parameter);
+	void DropWrapper(Guest *g);
+
+	std::vector<GuestCommand> commands; ///< Recorded changes.
+};
+
+extern thread_local GuestCommandBuffer *_guest_commands;
+
 /**
- * All our guests.
- * @todo Allow to have several blocks of guests.
+ * All our guests. Guests are stored in blocks that are never moved or released while the game runs, so pointers
+ * to guests stay valid. More blocks are added when all guests are active.
  */
 class Guests {
 public:
@@ -74,44 +130,52 @@ public:
 
 	/**
 	 * Get a guest from the array.
-	 * @param idx Index of the person (should be between \c 0 and #GUEST_BLOCK_SIZE).
+	 * @param idx Index of the person (should be less than the number of guests in the blocks).
 	 * @return The requested person.
 	 */
 	inline Guest *Get(int idx)
 	{
-		return this->block.Get(idx);
+		assert(idx >= 0 && static_cast<uint>(idx) < this->blocks.size() * GUEST_BLOCK_SIZE);
+		return this->blocks[idx / GUEST_BLOCK_SIZE]->Get(idx % GUEST_BLOCK_SIZE);
 	}
 
 	/**
 	 * Get a guest from the array.
-	 * @param idx Index of the person (should be between \c 0 and #GUEST_BLOCK_SIZE).
+	 * @param idx Index of the person (should be less than the number of guests in the blocks).
 	 * @return The requested person.
 	 */
 	inline const Guest *Get(int idx) const
 	{
-		return this->block.Get(idx);
+		assert(idx >= 0 && static_cast<uint>(idx) < this->blocks.size() * GUEST_BLOCK_SIZE);
+		return this->blocks[idx / GUEST_BLOCK_SIZE]->Get(idx % GUEST_BLOCK_SIZE);
 	}
 
 	void OnAnimate(int delay);
 	void DoTick();
 	void OnNewDay();
+	bool SpawnGuest();
 
 	void NotifyRideDeletion(const RideInstance *);
 
 	Point16 start_voxel;  ///< Entry x/y coordinate of the voxel stack at the edge (negative X/Y coordinate means invalid).
 
 private:
-	GuestBlock block;     ///< The data of all actual guests.
-	uint free_idx;        ///< All guests less than this index are active.
+	std::vector<GuestBlock *> blocks; ///< The data of all actual guests.
+	std::vector<uint16> free_guests;  ///< Ids of the non-active guests, the next guest to use at the back.
+	uint active_count;    ///< Number of active guests.
 	Random rnd;           ///< Random number generator for creating new guests.
 	int daily_frac;       ///< Frame counter.
 	int next_daily_index; ///< Index of the next guest to give daily service.
 
-	bool FindNextFreeGuest();
-	bool FindNextFreeGuest() const;
-	bool HasFreeGuests() const;
+	std::vector<GuestCommandBuffer> command_buffers; ///< Changes recorded by the jobs of a parallel update.
+	std::vector<Guest *> daily_guests;               ///< Guests getting their daily update in the current frame.
+
+	bool AddBlock();
+	void RebuildFreeGuests();
+	bool HasFreeGuests();
 	void AddFree(Guest *g);
 	Guest *GetFree();
+	void ApplyCommands(uint job_count);
 };
 
 extern Guests _guests;
@@ -17,7 +17,7 @@
 #include "people.h"
 #include "fileio.h"
 #include "map.h"
-#include "path_finding.h"
+#include "path_graph.h"
 #include "viewport.h"
 #include "weather.h"
 
@@ -183,7 +183,7 @@ void Person::Activate(const Point16 &start, PersonType person_type)
 	this->vox_pos.x = start.x;
 	this->vox_pos.y = start.y;
 	this->vox_pos.z = _world.GetBaseGroundHeight(start.x, start.y);
-	this->AddSelf(_world.GetCreateVoxel(this->vox_pos, false));
+	this->AddSelf();
 
 	if (start.x == 0) {
 		this->pix_pos.x = 0;
@@ -416,8 +416,9 @@ void Person::Load(Loader &ldr)
 	this->offset = ldr.GetWord();
 	this->name = ldr.GetText();
 
+	/* The saved colours replace all random colours, do not draw random numbers for them. */
 	const PersonTypeData &person_type_data = GetPersonTypeData(this->type);
-	this->recolour = person_type_data.graphics.MakeRecolouring();
+	this->recolour = person_type_data.graphics.recolours;
 	this->recolour.Load(ldr);
 
 	this->walk = DecodeWalk(ldr.GetWord());
@@ -430,7 +431,7 @@ void Person::Load(Loader &ldr)
 	this->frames = anim->frames;
 	this->frame_count = anim->frame_count;
 
-	this->AddSelf(_world.GetCreateVoxel(this->vox_pos, false));
+	this->AddSelf();
 	this->MarkDirty();
 }
 
@@ -549,7 +550,7 @@ void Guest::ExitRide(RideInstance *ri, TileEdge entry)
 	this->vox_pos.y = exit_pos.y >> 8; this->pix_pos.y = exit_pos.y & 0xff;
 	this->vox_pos.z = exit_pos.z >> 8; this->pix_pos.z = exit_pos.z & 0xff;
 	this->activity = GA_WANDER;
-	this->AddSelf(_world.GetCreateVoxel(this->vox_pos, false));
+	this->AddSelf();
 	this->DecideMoveDirection();
 }
 
@@ -618,16 +619,19 @@ uint8 Guest::GetExitDirections(const Voxel *v, TileEdge start_edge, bool *seen_w
 	return (shops << 4) | bot_exits;
 }
 
+/** Directions to the paths at the border of the park. */
+class ParkEntryFlowField : public FlowField {
+protected:
+	void GetTargets(std::vector<XYZPoint16> *targets) override;
+};
+
 /**
- * From a junction, find the direction that leads to an entrance of the park.
- * @param pos Current position.
- * @return Edge to go to to go to an entrance of the park, or #INVALID_EDGE if no path could be found.
+ * Collect the path tiles with a connection to outside the park.
+ * @param targets [out] Coordinates of the path tiles.
  */
-static TileEdge GetParkEntryDirection(const XYZPoint16 &pos)
+void ParkEntryFlowField::GetTargets(std::vector<XYZPoint16> *targets)
 {
-	PathSearcher ps(pos); // Current position is the destination.
-
-	/* Add path tiles with a connection to outside the park to the initial starting points. */
+	/* Add path tiles with a connection to outside the park to the targets. */
 	for (int x = 0; x < _world.GetXSize() - 1; x++) {
 		for (int y = 0; y < _world.GetYSize() - 1; y++) {
 			const VoxelStack *vs = _world.GetStack(x, y);
@@ -637,7 +641,7 @@ static TileEdge GetParkEntryDirection(const XYZPoint16 &pos)
 					const Voxel *v = vs->voxels + offset;
 					if (HasValidPath(v) && GetImplodedPathSlope(v) < PATH_FLAT_COUNT &&
 							(GetPathExits(v) & ((1 << EDGE_SE) | (1 << EDGE_SW))) != 0) {
-						ps.AddStart(XYZPoint16(x, y, vs->base + offset));
+						targets->push_back(XYZPoint16(x, y, vs->base + offset));
 					}
 				}
 			} else {
@@ -647,7 +651,7 @@ static TileEdge GetParkEntryDirection(const XYZPoint16 &pos)
 					const Voxel *v = vs->voxels + offset;
 					if (HasValidPath(v) && GetImplodedPathSlope(v) < PATH_FLAT_COUNT &&
 							(GetPathExits(v) & (1 << EDGE_NE)) != 0) {
-						ps.AddStart(XYZPoint16(x + 1, y, vs->base + offset));
+						targets->push_back(XYZPoint16(x + 1, y, vs->base + offset));
 					}
 				}
 
@@ -657,19 +661,42 @@ static TileEdge GetParkEntryDirection(const XYZPoint16 &pos)
 					const Voxel *v = vs->voxels + offset;
 					if (HasValidPath(v) && GetImplodedPathSlope(v) < PATH_FLAT_COUNT &&
 							(GetPathExits(v) & (1 << EDGE_NW)) != 0) {
-						ps.AddStart(XYZPoint16(x, y + 1, vs->base + offset));
+						targets->push_back(XYZPoint16(x, y + 1, vs->base + offset));
 					}
 				}
 			}
 		}
 	}
-	if (!ps.Search()) return INVALID_EDGE; // Search failed.
+}
+
+/** Directions to the 'go home' tile. */
+class GoHomeFlowField : public FlowField {
+protected:
+	void GetTargets(std::vector<XYZPoint16> *targets) override;
+};
+
+/**
+ * Collect the 'go home' tile.
+ * @param targets [out] Coordinate of the 'go home' tile.
+ */
+void GoHomeFlowField::GetTargets(std::vector<XYZPoint16> *targets)
+{
+	int x = _guests.start_voxel.x;
+	int y = _guests.start_voxel.y;
+	targets->push_back(XYZPoint16(x, y, _world.GetBaseGroundHeight(x, y)));
+}
 
-	const WalkedPosition *dest = ps.dest_pos;
-	const WalkedPosition *prev = dest->prev_pos;
-	if (prev == nullptr) return INVALID_EDGE; // Already at tile.
+static ParkEntryFlowField _park_entry_flow; ///< Directions to the entrances of the park, shared by all guests.
+static GoHomeFlowField _go_home_flow;       ///< Directions to the 'go home' tile, shared by all guests.
 
-	return GetAdjacentEdge(dest->cur_vox.x, dest->cur_vox.y, prev->cur_vox.x, prev->cur_vox.y);
+/**
+ * From a junction, find the direction that leads to an entrance of the park.
+ * @param pos Current position.
+ * @return Edge to go to to go to an entrance of the park, or #INVALID_EDGE if no path could be found.
+ */
+static TileEdge GetParkEntryDirection(const XYZPoint16 &pos)
+{
+	return _park_entry_flow.GetDirection(pos);
 }
 
 /**
@@ -679,19 +706,7 @@ static TileEdge GetParkEntryDirection(const XYZPoint16 &pos)
  */
 static TileEdge GetGoHomeDirection(const XYZPoint16 &pos)
 {
-	PathSearcher ps(pos); // Current position is the destination.
-
-	int x = _guests.start_voxel.x;
-	int y = _guests.start_voxel.y;
-	ps.AddStart(XYZPoint16(x, y, _world.GetBaseGroundHeight(x, y)));
-
-	if (!ps.Search()) return INVALID_EDGE;
-
-	const WalkedPosition *dest = ps.dest_pos;
-	const WalkedPosition *prev = dest->prev_pos;
-	if (prev == nullptr) return INVALID_EDGE; // Already at tile.
-
-	return GetAdjacentEdge(dest->cur_vox.x, dest->cur_vox.y, prev->cur_vox.x, prev->cur_vox.y);
+	return _go_home_flow.GetDirection(pos);
 }
 
 /**
@@ -887,7 +902,7 @@ void Person::DeActivate(AnimateResult ar)
 
 	if (ar == OAR_REMOVE && _world.VoxelExists(this->vox_pos)) {
 		/* If not wandered off-world, remove the person from the voxel person list. */
-		this->RemoveSelf(_world.GetCreateVoxel(this->vox_pos, false));
+		this->RemoveSelf();
 	}
 
 	this->type = PERSON_INVALID;
@@ -903,12 +918,39 @@ void Person::DeActivate(AnimateResult ar)
  */
 AnimateResult Person::OnAnimate(int delay)
 {
-	this->frame_time -= delay;
-	if (this->frame_time > 0) return OAR_OK;
+	return this->ContinueAnimation(this->AdvanceAnimation(delay));
+}
+
+/**
+ * Handle the result of advancing the animation, which may change the world around the person.
+ * @param progress Progress of the animation, as returned by #AdvanceAnimation.
+ * @return Whether to keep the person active or how to deactivate him/her.
+ */
+AnimateResult Person::ContinueAnimation(AnimateProgress progress)
+{
+	if (progress == AP_WAITING) return OAR_OK;
 
 	this->MarkDirty(); // Marks the entire voxel dirty, which should be big enough even after moving.
 
-	if (this->frames == nullptr || this->frame_count == 0) return OAR_REMOVE;
+	switch (progress) {
+		case AP_MOVED:     return OAR_OK;
+		case AP_WALK_DONE: return this->FinishWalk();
+		case AP_NO_FRAMES: return OAR_REMOVE;
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Move the person along the frames of its animation. Only the person itself is changed, so persons can be advanced in parallel.
+ * @param delay Amount of milliseconds since the last update.
+ * @return How far the animation progressed.
+ */
+AnimateProgress Person::AdvanceAnimation(int delay)
+{
+	this->frame_time -= delay;
+	if (this->frame_time > 0) return AP_WAITING;
+
+	if (this->frames == nullptr || this->frame_count == 0) return AP_NO_FRAMES;
 
 	int16 x_limit = -1;
 	switch (GB(this->walk->limit_type, WLM_X_START, WLM_LIMIT_LENGTH)) {
@@ -954,9 +996,17 @@ AnimateResult Person::OnAnimate(int delay)
 		this->frame_time = this->frames[index].duration;
 
 		this->pix_pos.z = GetZHeight(this->vox_pos, this->pix_pos.x, this->pix_pos.y);
-		return OAR_OK;
+		return AP_MOVED;
 	}
+	return AP_WALK_DONE;
+}
 
+/**
+ * The person reached the end of its walk, start the next walk at the tile, or move to the next tile.
+ * @return Whether to keep the person active or how to deactivate him/her.
+ */
+AnimateResult Person::FinishWalk()
+{
 	/* Reached the goal, start the next walk. */
 	if (this->walk[1].anim_type != ANIM_INVALID) {
 		this->StartAnimation(this->walk + 1);
@@ -969,7 +1019,7 @@ AnimateResult Person::OnAnimate(int delay)
 	int dz = 0;
 	TileEdge exit_edge = INVALID_EDGE;
 
-	this->RemoveSelf(_world.GetCreateVoxel(this->vox_pos, false));
+	this->RemoveSelf();
 	if (this->pix_pos.x < 0) {
 		dx--;
 		this->vox_pos.x--;
@@ -1017,7 +1067,7 @@ AnimateResult Person::OnAnimate(int delay)
 			/* Ride is could not be visited, fall-through to reversing movement. */
 
 		} else if (HasValidPath(v)) {
-			this->AddSelf(v);
+			this->AddSelf();
 			this->DecideMoveDirection();
 			return OAR_OK;
 
@@ -1027,7 +1077,7 @@ AnimateResult Person::OnAnimate(int delay)
 			this->pix_pos.z = 255;
 			Voxel *w = _world.GetCreateVoxel(this->vox_pos, false);
 			if (w != nullptr && HasValidPath(w)) {
-				this->AddSelf(w);
+				this->AddSelf();
 				this->DecideMoveDirection();
 				return OAR_OK;
 			}
@@ -1038,7 +1088,7 @@ AnimateResult Person::OnAnimate(int delay)
 		if (dy != 0) { this->vox_pos.y -= dy; this->pix_pos.y = (dy > 0) ? 255 : 0; }
 		if (dz != 0) { this->vox_pos.z -= dz; this->pix_pos.z = (dz > 0) ? 255 : 0; }
 
-		this->AddSelf(_world.GetCreateVoxel(this->vox_pos, false));
+		this->AddSelf();
 		this->DecideMoveDirection();
 		return OAR_OK;
 	}
@@ -1050,7 +1100,7 @@ AnimateResult Person::OnAnimate(int delay)
 		v = _world.GetCreateVoxel(this->vox_pos, false);
 	}
 	if (v != nullptr && HasValidPath(v)) {
-		this->AddSelf(v);
+		this->AddSelf();
 		this->DecideMoveDirection();
 		return OAR_OK;
 	}
@@ -1149,7 +1199,7 @@ void Guest::Load(Loader &ldr)
 	this->cash_spent = static_cast<Money>(ldr.GetLongLong());
 
 	uint16 ride_index = ldr.GetWord();
-	if (ride_index != INVALID_RIDE_INSTANCE) this->ride = _rides_manager.GetRideInstance(ride_index);
+	this->ride = (ride_index != INVALID_RIDE_INSTANCE) ? _rides_manager.GetRideInstance(ride_index) : nullptr;
 
 	this->has_map = ldr.GetByte();
 	this->has_umbrella = ldr.GetByte();
@@ -1198,10 +1248,10 @@ void Guest::Save(Saver &svr)
 	svr.PutByte(this->nausea);
 }
 
-AnimateResult Guest::OnAnimate(int delay)
+AnimateProgress Guest::AdvanceAnimation(int delay)
 {
-	if (this->activity == GA_ON_RIDE) return OAR_OK; // Guest is not animated while on ride.
-	return this->Person::OnAnimate(delay);
+	if (this->activity == GA_ON_RIDE) return AP_WAITING; // Guest is not animated while on ride.
+	return this->Person::AdvanceAnimation(delay);
 }
 
 AnimateResult Guest::EdgeOfWorldOnAnimate()
@@ -1237,6 +1287,22 @@ AnimateResult Guest::VisitRideOnAnimate(RideInstance *ri, TileEdge exit_edge)
 	return OAR_CONTINUE;
 }
 
+/**
+ * Notify windows of a change of a guest. While guests are updated in parallel, the notification is recorded instead.
+ * @param wtype %Window type.
+ * @param wnumber Number of the window.
+ * @param code Unique change number.
+ * @param parameter Parameter of the change number.
+ */
+static void NotifyGuestChange(WindowTypes wtype, WindowNumber wnumber, ChangeCode code, uint32 parameter)
+{
+	if (_guest_commands != nullptr) {
+		_guest_commands->Notify(wtype, wnumber, code, parameter);
+	} else {
+		NotifyChange(wtype, wnumber, code, parameter);
+	}
+}
+
 /**
  * Update the happiness of the guest.
  * @param amount Amount of change.
@@ -1248,7 +1314,13 @@ void Guest::ChangeHappiness(int16 amount)
 	int16 old_happiness = this->happiness;
 	this->happiness = Clamp(this->happiness + amount, 0, 100);
 	if (amount > 0) this->total_happiness = std::min(1000, this->total_happiness + this->happiness - old_happiness);
-	NotifyChange(WC_GUEST_INFO, this->id, CHG_DISPLAY_OLD, 0);
+	NotifyGuestChange(WC_GUEST_INFO, this->id, CHG_DISPLAY_OLD, 0);
+}
+
+/** Decide whether the guest drops the wrapper of its food or drink. */
+void Guest::DecideDropWrapper()
+{
+	if (this->rnd.Success1024(25)) this->has_wrapper = false; // XXX Drop litter.
 }
 
 /**
@@ -1286,7 +1358,14 @@ bool Guest::DailyUpdate()
 
 	int16 happiness_change = 0;
 	if (!eating) {
-		if (this->has_wrapper && this->rnd.Success1024(25)) this->has_wrapper = false; // XXX Drop litter.
+		if (this->has_wrapper) {
+			/* The random generator is shared, draw from it in the order of a serial update. */
+			if (_guest_commands != nullptr) {
+				_guest_commands->DropWrapper(this);
+			} else {
+				this->DecideDropWrapper();
+			}
+		}
 		if (this->hunger_level > 200) happiness_change--;
 	}
 	if (this->waste > 170) happiness_change -= 2;
@@ -1312,7 +1391,7 @@ bool Guest::DailyUpdate()
 
 	if (this->activity == GA_WANDER && this->happiness <= 10) {
 		this->activity = GA_GO_HOME; // Go home when bored.
-		NotifyChange(WC_BOTTOM_TOOLBAR, ALL_WINDOWS_OF_TYPE, CHG_GUEST_COUNT, 0);
+		NotifyGuestChange(WC_BOTTOM_TOOLBAR, ALL_WINDOWS_OF_TYPE, CHG_GUEST_COUNT, 0);
 	}
 	return true;
 }
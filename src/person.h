@@ -78,6 +78,17 @@ enum AnimateResult {
 	OAR_DEACTIVATE, ///< Person is already removed from the person-list, only de-activate.
 };
 
+/**
+ * Progress of the Person::AdvanceAnimation call, which only changes the person itself.
+ * The animation is completed with Person::ContinueAnimation.
+ */
+enum AnimateProgress {
+	AP_WAITING,   ///< Current frame is not finished yet, nothing changed.
+	AP_MOVED,     ///< Moved to the next frame of the animation.
+	AP_WALK_DONE, ///< Reached the end of the walk, start the next walk.
+	AP_NO_FRAMES, ///< Person has no animation, remove the person.
+};
+
 /** Desire to visit a ride. */
 enum RideVisitDesire {
 	RVD_NO_RIDE,    ///< There is no ride here (used to distinguish between paths and rides).
@@ -100,6 +111,8 @@ public:
 	const ImageData *GetSprite(const SpriteStorage *sprites, ViewOrientation orient, const Recolouring **recolour) const override;
 
 	virtual AnimateResult OnAnimate(int delay);
+	virtual AnimateProgress AdvanceAnimation(int delay);
+	AnimateResult ContinueAnimation(AnimateProgress progress);
 	virtual bool DailyUpdate() = 0;
 
 	virtual void Activate(const Point16 &start, PersonType person_type);
@@ -149,6 +162,7 @@ protected:
 
 	virtual void DecideMoveDirection() = 0;
 	void StartAnimation(const WalkInformation *walk);
+	AnimateResult FinishWalk();
 
 	virtual RideVisitDesire WantToVisit(const RideInstance *ri);
 	virtual AnimateResult EdgeOfWorldOnAnimate() = 0;
@@ -186,10 +200,11 @@ public:
 		return this->activity != GA_ENTER_PARK && this->activity != GA_GO_HOME;
 	}
 
-	AnimateResult OnAnimate(int delay) override;
+	AnimateProgress AdvanceAnimation(int delay) override;
 	bool DailyUpdate() override;
 
 	void ChangeHappiness(int16 amount);
+	void DecideDropWrapper();
 	ItemType SelectItem(const RideInstance *ri);
 	void BuyItem(RideInstance *ri);
 	void NotifyRideDeletion(const RideInstance *ri);
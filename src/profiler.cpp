@@ -0,0 +1,190 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file profiler.cpp Measuring the time spent in the phases of a frame. */
+
+#include "stdafx.h"
+#include "profiler.h"
+#include "window.h"
+#include "video.h"
+
+FrameProfiler _frame_profiler; ///< Profiler of the frames.
+
+static const int OVERLAY_UPDATE_INTERVAL = 10; ///< Number of frames between two updates of the overlay window.
+
+/** Column names of the phases in the CSV file. */
+static const char *_phase_csv_names[PFP_COUNT] = {
+	"windows",
+	"collect",
+	"sort",
+	"blit",
+	"finish_repaint",
+	"guest_tick",
+	"date",
+	"guest_animate",
+	"ride_animate",
+};
+
+/** Column names of the counted events in the CSV file. */
+static const char *_count_csv_names[PFN_COUNT] = {
+	"sprite_cache_hits",
+	"sprite_cache_misses",
+	"sprite_cache_evictions",
+	"text_cache_hits",
+	"text_cache_misses",
+};
+
+FrameProfiler::FrameProfiler()
+{
+	this->enabled = false;
+	this->overlay = false;
+	this->csv_file = nullptr;
+	this->frame_count = 0;
+	this->current = {};
+}
+
+FrameProfiler::~FrameProfiler()
+{
+	this->CloseCsvFile();
+}
+
+/**
+ * Write a row for every measured frame to a CSV file, with the times in microseconds.
+ * @param fname Name of the file to write.
+ * @return Whether the file could be opened.
+ */
+bool FrameProfiler::OpenCsvFile(const char *fname)
+{
+	this->CloseCsvFile();
+	this->csv_file = fopen(fname, "w");
+	if (this->csv_file == nullptr) return false;
+
+	fprintf(this->csv_file, "frame,total");
+	for (int i = 0; i < PFP_COUNT; i++) fprintf(this->csv_file, ",%s", _phase_csv_names[i]);
+	for (int i = 0; i < PFN_COUNT; i++) fprintf(this->csv_file, ",%s", _count_csv_names[i]);
+	fprintf(this->csv_file, "\n");
+	this->enabled = true;
+	this->StartFrame(); // The frame may already be running.
+	return true;
+}
+
+/** Stop writing the CSV file. */
+void FrameProfiler::CloseCsvFile()
+{
+	if (this->csv_file == nullptr) return;
+
+	fclose(this->csv_file);
+	this->csv_file = nullptr;
+	this->enabled = this->overlay;
+}
+
+/**
+ * The overlay window was opened or closed.
+ * @param shown Whether the overlay is shown.
+ */
+void FrameProfiler::SetOverlay(bool shown)
+{
+	this->overlay = shown;
+	this->enabled = this->overlay || this->csv_file != nullptr;
+	this->StartFrame(); // The frame may already be running.
+}
+
+/** A new frame starts. */
+void FrameProfiler::StartFrame()
+{
+	if (!this->enabled) return;
+
+	this->current = {};
+	this->GetCounts(this->start_counts);
+	this->frame_start = ProfileClock::now();
+}
+
+/** The current frame has ended, store its measurements. */
+void FrameProfiler::EndFrame()
+{
+	if (!this->enabled) return;
+
+	this->current.total = std::chrono::duration<float, std::micro>(ProfileClock::now() - this->frame_start).count();
+	uint64 counts[PFN_COUNT];
+	this->GetCounts(counts);
+	for (int i = 0; i < PFN_COUNT; i++) this->current.counts[i] = counts[i] - this->start_counts[i];
+	this->history[this->frame_count % PROFILE_HISTORY_LENGTH] = this->current;
+	this->frame_count++;
+
+	if (this->csv_file != nullptr) this->WriteCsvRow(this->current);
+	if (this->overlay && this->frame_count % OVERLAY_UPDATE_INTERVAL == 0) NotifyChange(WC_PROFILER, ALL_WINDOWS_OF_TYPE, CHG_DISPLAY_OLD, 0);
+}
+
+/**
+ * Write the measurements of a frame to the CSV file.
+ * @param fp Measurements of the frame.
+ */
+void FrameProfiler::WriteCsvRow(const FrameProfile &fp)
+{
+	fprintf(this->csv_file, "%u,%.1f", this->frame_count, fp.total);
+	for (int i = 0; i < PFP_COUNT; i++) fprintf(this->csv_file, ",%.1f", fp.phases[i]);
+	for (int i = 0; i < PFN_COUNT; i++) fprintf(this->csv_file, ",%.0f", fp.counts[i]);
+	fprintf(this->csv_file, "\n");
+}
+
+/**
+ * Get the current values of the event counters.
+ * @param [out] counts Current value of each counter.
+ */
+void FrameProfiler::GetCounts(uint64 *counts) const
+{
+	const SpriteCache &cache = _video.GetSpriteCache();
+	counts[PFN_SPRITE_CACHE_HITS] = cache.hits;
+	counts[PFN_SPRITE_CACHE_MISSES] = cache.misses;
+	counts[PFN_SPRITE_CACHE_EVICTIONS] = cache.evictions;
+
+	const TextCache &text_cache = _video.GetTextCache();
+	counts[PFN_TEXT_CACHE_HITS] = text_cache.hits;
+	counts[PFN_TEXT_CACHE_MISSES] = text_cache.misses;
+}
+
+/**
+ * Get the measurements of a frame from the history.
+ * @param age Number of frames before the last measured frame.
+ * @return The measurements of the frame.
+ * @pre \a age is less than #GetHistorySize.
+ */
+const FrameProfile &FrameProfiler::GetFrame(int age) const
+{
+	assert(age >= 0 && age < this->GetHistorySize());
+	return this->history[(this->frame_count - 1 - age) % PROFILE_HISTORY_LENGTH];
+}
+
+/**
+ * Compute the average and maximum times and event counts of the frames in the history.
+ * @param [out] average Average time of the frame and its phases, and average number of events.
+ * @param [out] maximum Maximum time of the frame and its phases, and maximum number of events.
+ */
+void FrameProfiler::GetAverage(FrameProfile *average, FrameProfile *maximum) const
+{
+	*average = {};
+	*maximum = {};
+	int count = this->GetHistorySize();
+	for (int age = 0; age < count; age++) {
+		const FrameProfile &fp = this->GetFrame(age);
+		average->total += fp.total;
+		maximum->total = std::max(maximum->total, fp.total);
+		for (int i = 0; i < PFP_COUNT; i++) {
+			average->phases[i] += fp.phases[i];
+			maximum->phases[i] = std::max(maximum->phases[i], fp.phases[i]);
+		}
+		for (int i = 0; i < PFN_COUNT; i++) {
+			average->counts[i] += fp.counts[i];
+			maximum->counts[i] = std::max(maximum->counts[i], fp.counts[i]);
+		}
+	}
+	if (count == 0) return;
+
+	average->total /= count;
+	for (int i = 0; i < PFP_COUNT; i++) average->phases[i] /= count;
+	for (int i = 0; i < PFN_COUNT; i++) average->counts[i] /= count;
+}
@@ -0,0 +1,141 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file profiler.h Measuring the time spent in the phases of a frame. */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+/** Phases of a frame that are measured by the profiler. */
+enum ProfilePhase {
+	PFP_WINDOWS,        ///< Updating and repainting the windows.
+	PFP_COLLECT,        ///< Collecting the sprites of the viewport (part of #PFP_WINDOWS).
+	PFP_SORT,           ///< Sorting the sprites of the viewport (part of #PFP_WINDOWS).
+	PFP_BLIT,           ///< Blitting the sprites of the viewport (part of #PFP_WINDOWS).
+	PFP_FINISH_REPAINT, ///< Copying the repainted areas to the display (part of #PFP_WINDOWS).
+	PFP_GUEST_TICK,     ///< Daily update of the guests.
+	PFP_DATE,           ///< Advancing the date, including the daily and monthly updates.
+	PFP_GUEST_ANIMATE,  ///< Animating the guests.
+	PFP_RIDE_ANIMATE,   ///< Animating the rides.
+
+	PFP_COUNT,          ///< Number of measured phases.
+};
+
+/** Events of a frame that are counted by the profiler. */
+enum ProfileCount {
+	PFN_SPRITE_CACHE_HITS,      ///< Sprites drawn from the sprite cache.
+	PFN_SPRITE_CACHE_MISSES,    ///< Sprites decoded into the sprite cache.
+	PFN_SPRITE_CACHE_EVICTIONS, ///< Sprites dropped from the sprite cache.
+	PFN_TEXT_CACHE_HITS,        ///< Text sizes and masks taken from the text cache.
+	PFN_TEXT_CACHE_MISSES,      ///< Text sizes and masks rendered into the text cache.
+
+	PFN_COUNT,                  ///< Number of counted events.
+};
+
+static const int PROFILE_HISTORY_LENGTH = 128; ///< Number of frames kept in the history of the profiler.
+
+typedef std::chrono::steady_clock ProfileClock; ///< Clock used for measuring the phases.
+
+/** Time spent in a frame, in microseconds, and the events of the frame. */
+struct FrameProfile {
+	float total;             ///< Time of the entire frame.
+	float phases[PFP_COUNT]; ///< Time of each phase.
+	float counts[PFN_COUNT]; ///< Number of each event.
+};
+
+/** Profiler of the frames. Measuring is only enabled while the overlay is shown or a CSV file is written. */
+class FrameProfiler {
+public:
+	FrameProfiler();
+	~FrameProfiler();
+
+	bool OpenCsvFile(const char *fname);
+	void CloseCsvFile();
+	void SetOverlay(bool shown);
+
+	/**
+	 * Is the profiler measuring the frames?
+	 * @return Whether the profiler is measuring.
+	 */
+	inline bool IsEnabled() const
+	{
+		return this->enabled;
+	}
+
+	/**
+	 * Add time spent in a phase of the current frame.
+	 * @param phase Phase that took the time.
+	 * @param duration Time spent in the phase.
+	 */
+	inline void AddTime(ProfilePhase phase, ProfileClock::duration duration)
+	{
+		this->current.phases[phase] += std::chrono::duration<float, std::micro>(duration).count();
+	}
+
+	void StartFrame();
+	void EndFrame();
+
+	/**
+	 * Get the number of frames in the history.
+	 * @return Number of available frames.
+	 */
+	inline int GetHistorySize() const
+	{
+		return std::min<uint32>(this->frame_count, PROFILE_HISTORY_LENGTH);
+	}
+
+	const FrameProfile &GetFrame(int age) const;
+	void GetAverage(FrameProfile *average, FrameProfile *maximum) const;
+
+private:
+	void WriteCsvRow(const FrameProfile &fp);
+	void GetCounts(uint64 *counts) const;
+
+	bool enabled;     ///< Whether the frames are measured.
+	bool overlay;     ///< Whether the overlay window is shown.
+	FILE *csv_file;   ///< File receiving a row for every measured frame, if not \c nullptr.
+	uint32 frame_count; ///< Number of measured frames.
+
+	ProfileClock::time_point frame_start;         ///< Start of the current frame.
+	uint64 start_counts[PFN_COUNT];               ///< Event counters at the start of the current frame.
+	FrameProfile current;                         ///< Measurements of the current frame.
+	FrameProfile history[PROFILE_HISTORY_LENGTH]; ///< Ring buffer of the last measured frames.
+};
+
+extern FrameProfiler _frame_profiler;
+
+/**
+ * Scoped timer, measures the time from its construction to its destruction as time spent in a phase of the frame.
+ * When the profiler is disabled, only the enabled flag is checked.
+ */
+class ProfileTimer {
+public:
+	/**
+	 * Start measuring a phase.
+	 * @param phase Phase being measured.
+	 */
+	inline ProfileTimer(ProfilePhase phase) : phase(phase), enabled(_frame_profiler.IsEnabled())
+	{
+		if (this->enabled) this->start = ProfileClock::now();
+	}
+
+	inline ~ProfileTimer()
+	{
+		if (this->enabled) _frame_profiler.AddTime(this->phase, ProfileClock::now() - this->start);
+	}
+
+private:
+	ProfilePhase phase;              ///< Phase being measured.
+	bool enabled;                    ///< Whether the profiler was enabled at the start of the measurement.
+	ProfileClock::time_point start;  ///< Start of the measurement.
+};
+
+#endif
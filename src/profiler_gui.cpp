@@ -0,0 +1,162 @@
+/*
+ * This file is part of FreeRCT.
+ * FreeRCT is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * FreeRCT is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with FreeRCT. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file profiler_gui.cpp Overlay window of the frame profiler. */
+
+#include "stdafx.h"
+#include "window.h"
+#include "profiler.h"
+
+/** Columns with times in the profiler window. */
+enum ProfilerColumns {
+	PFC_LAST,    ///< Time of the last frame.
+	PFC_AVERAGE, ///< Average time of the frames in the history.
+	PFC_MAXIMUM, ///< Maximum time of the frames in the history.
+
+	PFC_COUNT,   ///< Number of columns with times.
+};
+
+static const int PROFILER_ROW_TOTAL = PFP_COUNT; ///< Row of the total frame time, after the rows of the phases.
+static const int PROFILER_ROW_FIRST_COUNT = PROFILER_ROW_TOTAL + 1; ///< Row of the first event count, after the row of the total time.
+static const int PROFILER_ROW_COUNT = PROFILER_ROW_FIRST_COUNT + PFN_COUNT; ///< Number of rows with values.
+
+/**
+ * Widget numbers of the profiler GUI. The times are numbered from #PFW_FIRST_TIME, by row and column.
+ * @ingroup gui_group
+ */
+enum ProfilerWidgets {
+	PFW_FIRST_TIME, ///< Widget of the first time.
+};
+
+/**
+ * GUI showing the time spent in the phases of the recent frames, and the number of events in them.
+ * @ingroup gui_group
+ */
+class ProfilerGui : public GuiWindow {
+public:
+	ProfilerGui();
+	~ProfilerGui();
+
+	void SetWidgetStringParameters(WidgetNumber wid_num) const override;
+	void OnChange(ChangeCode code, uint32 parameter) override;
+
+private:
+	void UpdateTimes();
+
+	FrameProfile times[PFC_COUNT];             ///< Times being displayed.
+	mutable uint8 text[PROFILER_ROW_COUNT][PFC_COUNT][16]; ///< Formatted times and event counts.
+};
+
+/**
+ * Helper macro to generate a row of the profiler window. Intended for use in #_profiler_gui_parts.
+ * @param id Name of the phase.
+ * @param row Row of the times in the window.
+ * @param indent Indentation of the name of the phase.
+ */
+#define PROFILER_ROW(id, row, indent) \
+	Widget(WT_LEFT_TEXT, INVALID_WIDGET_INDEX, COL_RANGE_GREY), \
+		SetPadding(2, 10, 2, 2 + (indent)), \
+		SetData(GUI_PROFILER_ ## id ## _TEXT, STR_NULL), \
+	Widget(WT_RIGHT_TEXT, PFW_FIRST_TIME + (row) * PFC_COUNT + PFC_LAST, COL_RANGE_GREY), \
+		SetMinimalSize(50, 10), SetPadding(2, 5, 2, 5), SetData(STR_ARG1, STR_NULL), \
+	Widget(WT_RIGHT_TEXT, PFW_FIRST_TIME + (row) * PFC_COUNT + PFC_AVERAGE, COL_RANGE_GREY), \
+		SetMinimalSize(50, 10), SetPadding(2, 5, 2, 5), SetData(STR_ARG1, STR_NULL), \
+	Widget(WT_RIGHT_TEXT, PFW_FIRST_TIME + (row) * PFC_COUNT + PFC_MAXIMUM, COL_RANGE_GREY), \
+		SetMinimalSize(50, 10), SetPadding(2, 5, 2, 5), SetData(STR_ARG1, STR_NULL)
+
+/** Widget parts of the #ProfilerGui window. */
+static const WidgetPart _profiler_gui_parts[] = {
+	Intermediate(0, 1),
+		Intermediate(1, 0),
+			Widget(WT_TITLEBAR, INVALID_WIDGET_INDEX, COL_RANGE_GREY), SetData(GUI_PROFILER_TITLE, GUI_TITLEBAR_TIP),
+			Widget(WT_CLOSEBOX, INVALID_WIDGET_INDEX, COL_RANGE_GREY),
+		EndContainer(),
+		Widget(WT_PANEL, INVALID_WIDGET_INDEX, COL_RANGE_GREY),
+			Intermediate(PROFILER_ROW_COUNT + 1, 1 + PFC_COUNT), SetPadding(2, 2, 2, 2),
+				Widget(WT_LEFT_TEXT, INVALID_WIDGET_INDEX, COL_RANGE_GREY), SetPadding(2, 10, 2, 2), SetData(GUI_PROFILER_PHASE_TEXT, STR_NULL),
+				Widget(WT_RIGHT_TEXT, INVALID_WIDGET_INDEX, COL_RANGE_GREY), SetPadding(2, 5, 2, 5), SetData(GUI_PROFILER_LAST_TEXT, STR_NULL),
+				Widget(WT_RIGHT_TEXT, INVALID_WIDGET_INDEX, COL_RANGE_GREY), SetPadding(2, 5, 2, 5), SetData(GUI_PROFILER_AVERAGE_TEXT, STR_NULL),
+				Widget(WT_RIGHT_TEXT, INVALID_WIDGET_INDEX, COL_RANGE_GREY), SetPadding(2, 5, 2, 5), SetData(GUI_PROFILER_MAXIMUM_TEXT, STR_NULL),
+				PROFILER_ROW(WINDOWS,        PFP_WINDOWS,        0),
+				PROFILER_ROW(COLLECT,        PFP_COLLECT,        10),
+				PROFILER_ROW(SORT,           PFP_SORT,           10),
+				PROFILER_ROW(BLIT,           PFP_BLIT,           10),
+				PROFILER_ROW(FINISH_REPAINT, PFP_FINISH_REPAINT, 10),
+				PROFILER_ROW(GUEST_TICK,     PFP_GUEST_TICK,     0),
+				PROFILER_ROW(DATE,           PFP_DATE,           0),
+				PROFILER_ROW(GUEST_ANIMATE,  PFP_GUEST_ANIMATE,  0),
+				PROFILER_ROW(RIDE_ANIMATE,   PFP_RIDE_ANIMATE,   0),
+				PROFILER_ROW(TOTAL,          PROFILER_ROW_TOTAL, 0),
+				PROFILER_ROW(SPRITE_CACHE_HITS,      PROFILER_ROW_FIRST_COUNT + PFN_SPRITE_CACHE_HITS,      0),
+				PROFILER_ROW(SPRITE_CACHE_MISSES,    PROFILER_ROW_FIRST_COUNT + PFN_SPRITE_CACHE_MISSES,    0),
+				PROFILER_ROW(SPRITE_CACHE_EVICTIONS, PROFILER_ROW_FIRST_COUNT + PFN_SPRITE_CACHE_EVICTIONS, 0),
+				PROFILER_ROW(TEXT_CACHE_HITS,        PROFILER_ROW_FIRST_COUNT + PFN_TEXT_CACHE_HITS,        0),
+				PROFILER_ROW(TEXT_CACHE_MISSES,      PROFILER_ROW_FIRST_COUNT + PFN_TEXT_CACHE_MISSES,      0),
+			EndContainer(),
+	EndContainer(),
+};
+#undef PROFILER_ROW
+
+ProfilerGui::ProfilerGui() : GuiWindow(WC_PROFILER, ALL_WINDOWS_OF_TYPE)
+{
+	this->SetupWidgetTree(_profiler_gui_parts, lengthof(_profiler_gui_parts));
+	_frame_profiler.SetOverlay(true);
+	this->UpdateTimes();
+}
+
+ProfilerGui::~ProfilerGui()
+{
+	_frame_profiler.SetOverlay(false);
+}
+
+/** Copy the times to display from the history of the profiler. */
+void ProfilerGui::UpdateTimes()
+{
+	if (_frame_profiler.GetHistorySize() == 0) {
+		for (FrameProfile &fp : this->times) fp = {};
+		return;
+	}
+	this->times[PFC_LAST] = _frame_profiler.GetFrame(0);
+	_frame_profiler.GetAverage(&this->times[PFC_AVERAGE], &this->times[PFC_MAXIMUM]);
+}
+
+void ProfilerGui::SetWidgetStringParameters(WidgetNumber wid_num) const
+{
+	if (wid_num < PFW_FIRST_TIME || wid_num >= PFW_FIRST_TIME + PROFILER_ROW_COUNT * PFC_COUNT) return;
+
+	int row = (wid_num - PFW_FIRST_TIME) / PFC_COUNT;
+	int column = (wid_num - PFW_FIRST_TIME) % PFC_COUNT;
+	const FrameProfile &fp = this->times[column];
+
+	uint8 *text = this->text[row][column];
+	if (row >= PROFILER_ROW_FIRST_COUNT) {
+		snprintf((char *)text, lengthof(this->text[row][column]), (column == PFC_AVERAGE) ? "%.1f" : "%.0f", fp.counts[row - PROFILER_ROW_FIRST_COUNT]);
+	} else {
+		float time = (row == PROFILER_ROW_TOTAL) ? fp.total : fp.phases[row];
+		snprintf((char *)text, lengthof(this->text[row][column]), "%.2f", time / 1000.0f);
+	}
+	_str_params.SetUint8(1, text);
+}
+
+void ProfilerGui::OnChange(ChangeCode code, uint32 parameter)
+{
+	if (code != CHG_DISPLAY_OLD) return;
+
+	this->UpdateTimes();
+	this->MarkDirty();
+}
+
+/** Open the frame profiler window, or close it if it is already opened. */
+void ToggleProfilerGui()
+{
+	Window *w = GetWindowByType(WC_PROFILER, ALL_WINDOWS_OF_TYPE);
+	if (w != nullptr) {
+		delete w;
+		return;
+	}
+	new ProfilerGui;
+}
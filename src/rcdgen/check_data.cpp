@@ -1496,66 +1496,30 @@ static std::shared_ptr<SpriteBlock> ConvertSpriteNode(std::shared_ptr<NodeGroup>
 	vals.PrepareNamedValues(ng->values, true, false);
 
 	if (vals.named_count > 0) {
-		std::string file = vals.GetString("file");
-		int xbase        = vals.GetNumber("x_base");
-		int ybase        = vals.GetNumber("y_base");
-		int width        = vals.GetNumber("width");
-		int height       = vals.GetNumber("height");
-		int xoffset      = vals.GetNumber("x_offset");
-		int yoffset      = vals.GetNumber("y_offset");
+		FileSpriteSource *source = new FileSpriteSource(ng->pos, ng->name);
+		source->file    = vals.GetString("file");
+		source->xbase   = vals.GetNumber("x_base");
+		source->ybase   = vals.GetNumber("y_base");
+		source->width   = vals.GetNumber("width");
+		source->height  = vals.GetNumber("height");
+		source->xoffset = vals.GetNumber("x_offset");
+		source->yoffset = vals.GetNumber("y_offset");
 
-		std::string recolour = "";
-		if (vals.HasValue("recolour")) recolour = vals.GetString("recolour");
+		if (vals.HasValue("recolour")) source->recolour = vals.GetString("recolour");
 
-		bool crop = true;
-		if (vals.HasValue("crop")) crop = vals.GetNumber("crop") != 0;
+		source->crop = true;
+		if (vals.HasValue("crop")) source->crop = vals.GetNumber("crop") != 0;
 
-		std::shared_ptr<BitMask> bm;
 		if (vals.HasValue("mask")) {
 			std::shared_ptr<ValueInformation> vi = vals.FindValue("mask");
-			bm = std::dynamic_pointer_cast<BitMask>(vi->node_value);
-			if (bm == nullptr) {
+			source->mask = std::dynamic_pointer_cast<BitMask>(vi->node_value);
+			if (source->mask == nullptr) {
 				fprintf(stderr, "Error at %s: Field \"mask\" of node \"sprite\" is not a bitmask node\n", vi->pos.ToString());
 				exit(1);
 			}
 		}
 
-		ImageFile imf;
-		const char *err = imf.LoadFile(file);
-		if (err != nullptr) {
-			fprintf(stderr, "Error at %s, loading of the sprite for \"%s\" failed: %s\n", ng->pos.ToString(), ng->name.c_str(), err);
-			exit(1);
-		}
-
-		BitMaskData *bmd = (bm == nullptr) ? nullptr : &bm->data;
-		if (imf.Is8bpp()) {
-			Image8bpp img(&imf, bmd);
-			if (recolour != "") fprintf(stderr, "Error at %s, cannot recolour an 8bpp image, ignoring the file.\n", ng->pos.ToString());
-			err = sb->sprite_image.CopySprite(&img, xoffset, yoffset, xbase, ybase, width, height, crop);
-		} else {
-			Image32bpp img(&imf, bmd);
-			if (recolour == "") {
-				err = sb->sprite_image.CopySprite(&img, xoffset, yoffset, xbase, ybase, width, height, crop);
-			} else {
-				ImageFile rmf;
-				err = rmf.LoadFile(recolour);
-				if (err != nullptr) {
-					fprintf(stderr, "Error at %s, loading of the recolour file failed: %s\n", ng->pos.ToString(), err);
-					exit(1);
-				}
-				if (!rmf.Is8bpp()) {
-					fprintf(stderr, "Error at %s, recolour file must be an 8bpp image.\n", ng->pos.ToString());
-					exit(1);
-				}
-				Image8bpp rim(&rmf, nullptr);
-				img.SetRecolourImage(&rim);
-				err = sb->sprite_image.CopySprite(&img, xoffset, yoffset, xbase, ybase, width, height, crop);
-			}
-		}
-		if (err != nullptr) {
-			fprintf(stderr, "Error at %s, copying the sprite for \"%s\" failed: %s\n", ng->pos.ToString(), ng->name.c_str(), err);
-			exit(1);
-		}
+		AddSpriteJob(sb, source);
 	}
 
 	vals.VerifyUsage();
@@ -126,6 +126,20 @@ void FileBlock::Write(FILE *fp)
 	}
 }
 
+/**
+ * Compute a hash of the block contents (the header with name, version, and length, and the data).
+ * @return Hash of the block.
+ */
+uint64 FileBlock::GetHash() const
+{
+	uint64 hash = 14695981039346656037ULL; // 64 bit FNV-1a.
+	for (int i = 0; i < this->length; i++) {
+		hash ^= this->data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
 /**
  * Check whether two file blocks are identical.
  * @param fb1 First block to compare.
@@ -141,6 +155,8 @@ bool operator==(const FileBlock &fb1, const FileBlock &fb2)
 
 FileWriter::FileWriter()
 {
+	this->added_blocks = 0;
+	this->duplicate_blocks = 0;
 }
 
 FileWriter::~FileWriter()
@@ -149,23 +165,28 @@ FileWriter::~FileWriter()
 }
 
 /**
- * Add a block to the file.
+ * Add a block to the file. Blocks with the same contents are stored only once.
  * @param blk Block to add.
  * @return Block index number where the block is stored in the file.
  */
 int FileWriter::AddBlock(FileBlock *blk)
 {
-	int idx = 1;
-	for (auto &iter : this->blocks) {
+	this->added_blocks++;
+
+	uint64 hash = blk->GetHash();
+	auto range = this->block_hashes.equal_range(hash);
+	for (auto iter = range.first; iter != range.second; ++iter) {
 		/* Block already added, just return the old block number. */
-		if (*iter == *blk) {
+		if (*this->blocks[iter->second] == *blk) {
 			delete blk;
-			return idx;
+			this->duplicate_blocks++;
+			return iter->second + 1;
 		}
-		idx++;
 	}
+
+	this->block_hashes.insert({hash, (uint)this->blocks.size()});
 	this->blocks.push_back(blk);
-	return idx;
+	return this->blocks.size();
 }
 
 /**
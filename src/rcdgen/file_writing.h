@@ -10,7 +10,8 @@
 #ifndef FILE_WRITING_H
 #define FILE_WRITING_H
 
-#include <list>
+#include <unordered_map>
+#include <vector>
 
 /** A block in an RCD file. See #StartSave for details on usage. */
 class FileBlock {
@@ -28,6 +29,7 @@ public:
 	void CheckEndSave();
 
 	void Write(FILE *fp);
+	uint64 GetHash() const;
 
 	uint8 *data;    ///< Data of the block.
 	int length;     ///< Length of the block.
@@ -36,9 +38,6 @@ public:
 
 bool operator==(const FileBlock &fb1, const FileBlock &fb2);
 
-/** Type definition for a list of file blocks. */
-typedef std::list<FileBlock *> FileBlockPtrList;
-
 /** RCD output file. */
 class FileWriter {
 public:
@@ -49,8 +48,12 @@ public:
 
 	void WriteFile(const std::string fname);
 
+	uint added_blocks;     ///< Number of blocks offered with #AddBlock.
+	uint duplicate_blocks; ///< Number of offered blocks that were already stored.
+
 private:
-	FileBlockPtrList blocks; ///< Blocks stored in the file so far.
+	std::vector<FileBlock *> blocks;                    ///< Blocks stored in the file so far.
+	std::unordered_multimap<uint64, uint> block_hashes; ///< Index in #blocks of the stored blocks, by hash of their contents.
 };
 
 #endif
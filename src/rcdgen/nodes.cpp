@@ -8,7 +8,9 @@
 /** @file nodes.cpp Code of the RCD file nodes. */
 
 #include "../stdafx.h"
+#include "../jobs.h"
 #include <cmath>
+#include <cstdarg>
 #include "ast.h"
 #include "nodes.h"
 #include "string_storage.h"
@@ -266,6 +268,7 @@ SheetBlock::SheetBlock(const Position &pos) : pos(pos)
 	this->img_sheet = nullptr;
 	this->rmf = nullptr;
 	this->rim = nullptr;
+	this->loaded = false;
 }
 
 SheetBlock::~SheetBlock()
@@ -276,24 +279,49 @@ SheetBlock::~SheetBlock()
 	delete this->rim;
 }
 
+/**
+ * Append a formatted message to the messages of making a sprite.
+ * @param messages [inout] Messages to extend.
+ * @param fmt Format of the message.
+ */
+static void AddMessage(std::string *messages, const char *fmt, ...)
+{
+	char buffer[1024];
+	va_list va;
+
+	va_start(va, fmt);
+	vsnprintf(buffer, lengthof(buffer), fmt, va);
+	va_end(va);
+
+	*messages += buffer;
+}
+
 /**
  * Get the sprite sheet. Loads the sheet from the disk on the first call.
- * @return The loaded image.
+ * @param messages [out] Messages for the user are appended to it.
+ * @return The loaded image, or \c nullptr if loading failed.
+ * @note May be called by several threads at the same time.
  */
-Image *SheetBlock::GetSheet()
+Image *SheetBlock::GetSheet(std::string *messages)
 {
-	if (this->img_sheet != nullptr) return this->img_sheet;
+	std::lock_guard<std::mutex> guard(this->lock);
+	if (this->loaded) {
+		*messages += this->load_error;
+		return this->img_sheet;
+	}
+	this->loaded = true;
 
 	this->imf = new ImageFile;
 	const char *err = this->imf->LoadFile(this->file);
 	if (err != nullptr) {
-		fprintf(stderr, "Error at %s, loading of the sheet-image failed: %s\n", this->pos.ToString(), err);
-		exit(1);
+		AddMessage(&this->load_error, "Error at %s, loading of the sheet-image failed: %s\n", this->pos.ToString(), err);
+		*messages += this->load_error;
+		return nullptr;
 	}
 	BitMaskData *bmd = (this->mask == nullptr) ? nullptr : &this->mask->data;
 	if (this->imf->Is8bpp()) {
 		this->img_sheet = new Image8bpp(this->imf, bmd);
-		if (this->recolour != "") fprintf(stderr, "Error at %s, cannot recolour an 8bpp image, ignoring the file.\n", this->pos.ToString());
+		if (this->recolour != "") AddMessage(messages, "Error at %s, cannot recolour an 8bpp image, ignoring the file.\n", this->pos.ToString());
 	} else {
 		Image32bpp *im = new Image32bpp(this->imf, bmd);
 		this->img_sheet = im;
@@ -301,12 +329,15 @@ Image *SheetBlock::GetSheet()
 			this->rmf = new ImageFile;
 			const char *err = this->rmf->LoadFile(this->recolour);
 			if (err != nullptr) {
-				fprintf(stderr, "Error at %s, loading of the recolour file failed: %s\n", this->pos.ToString(), err);
-				exit(1);
+				AddMessage(&this->load_error, "Error at %s, loading of the recolour file failed: %s\n", this->pos.ToString(), err);
+			} else if (!this->rmf->Is8bpp()) {
+				AddMessage(&this->load_error, "Error at %s, recolour file must be an 8bpp image.\n", this->pos.ToString());
 			}
-			if (!this->rmf->Is8bpp()) {
-				fprintf(stderr, "Error at %s, recolour file must be an 8bpp image.\n", this->pos.ToString());
-				exit(1);
+			if (!this->load_error.empty()) {
+				*messages += this->load_error;
+				delete this->img_sheet;
+				this->img_sheet = nullptr;
+				return nullptr;
 			}
 			this->rim = new Image8bpp(this->rmf, nullptr);
 			im->SetRecolourImage(this->rim);
@@ -317,19 +348,16 @@ Image *SheetBlock::GetSheet()
 
 std::shared_ptr<BlockNode> SheetBlock::GetSubNode(int row, int col, const char *name, const Position &pos)
 {
-	Image *img = this->GetSheet();
-	std::shared_ptr<SpriteBlock> spr_blk(new SpriteBlock);
 	const char *err = nullptr;
 	if (this->y_count >= 0 && row >= this->y_count) err = "No sprite available at the queried row.";
 	if (err == nullptr && this->x_count >= 0 && col >= this->x_count) err = "No sprite available at the queried column.";
-	if (err == nullptr) {
-		err = spr_blk->sprite_image.CopySprite(img, this->x_offset, this->y_offset,
-				this->x_base + this->x_step * col, this->y_base + this->y_step * row, this->width, this->height, this->crop);
-	}
 	if (err != nullptr) {
 		fprintf(stderr, "Error at %s, loading of the sprite for \"%s\" failed: %s\n", pos.ToString(), name, err);
 		exit(1);
 	}
+
+	std::shared_ptr<SpriteBlock> spr_blk(new SpriteBlock);
+	AddSpriteJob(spr_blk, new SheetSpriteSource(pos, name, this->shared_from_this(), row, col));
 	return spr_blk;
 }
 
@@ -338,51 +366,160 @@ std::shared_ptr<BlockNode> SpriteFilesBlock::GetSubNode(int row, int col, const
 	const char *err = nullptr;
 	if (row >= 1) err = "No sprites available at this row.";
 	if (err == nullptr && col >= this->file.GetCount()) err = "No sprite available at the queried column.";
-
 	if (err != nullptr) {
-report_error:
 		fprintf(stderr, "Error at %s, loading of the sprite for \"%s\" failed: %s\n", pos.ToString(), name, err);
 		exit(1);
 	}
 
-	ImageFile *imf = nullptr;
-	ImageFile *rmf = nullptr;
-	Image *img = nullptr;
-	Image8bpp *rim = nullptr;
+	FileSpriteSource *source = new FileSpriteSource(pos, name);
+	source->file = this->file.MakeFilename(col);
+	if (this->recolour.length >= 0) source->recolour = this->recolour.MakeFilename(col);
+	source->mask = this->mask;
+	source->xbase = this->xbase;
+	source->ybase = this->ybase;
+	source->xoffset = this->xoffset;
+	source->yoffset = this->yoffset;
+	source->width = this->width;
+	source->height = this->height;
+	source->crop = this->crop;
 
-	imf = new ImageFile;
-	err = imf->LoadFile(this->file.MakeFilename(col));
-	if (err != nullptr) goto report_error;
+	std::shared_ptr<SpriteBlock> spr_blk(new SpriteBlock);
+	AddSpriteJob(spr_blk, source);
+	return spr_blk;
+}
+
+/**
+ * Constructor of a sprite source.
+ * @param pos %Position of the sprite in the input.
+ * @param name %Name of the sprite.
+ */
+SpriteSource::SpriteSource(const Position &pos, const std::string &name) : pos(pos.ToString()), name(name)
+{
+}
+
+SpriteSource::~SpriteSource()
+{
+}
+
+/**
+ * Constructor of a sprite from its own image file.
+ * @param pos %Position of the sprite in the input.
+ * @param name %Name of the sprite.
+ */
+FileSpriteSource::FileSpriteSource(const Position &pos, const std::string &name) : SpriteSource(pos, name)
+{
+}
+
+bool FileSpriteSource::MakeSprite(SpriteImage *sprite_image, std::string *messages)
+{
+	ImageFile imf;
+	const char *err = imf.LoadFile(this->file);
+	if (err != nullptr) {
+		AddMessage(messages, "Error at %s, loading of the sprite for \"%s\" failed: %s\n", this->pos.c_str(), this->name.c_str(), err);
+		return false;
+	}
 
 	BitMaskData *bmd = (this->mask == nullptr) ? nullptr : &this->mask->data;
-	if (imf->Is8bpp()) {
-		img = new Image8bpp(imf, bmd);
-		if (this->recolour.length >= 0) fprintf(stderr, "Error at %s, cannot recolour an 8bpp image, ignoring the file.\n", this->pos.ToString());
+	if (imf.Is8bpp()) {
+		Image8bpp img(&imf, bmd);
+		if (this->recolour != "") AddMessage(messages, "Error at %s, cannot recolour an 8bpp image, ignoring the file.\n", this->pos.c_str());
+		err = sprite_image->CopySprite(&img, this->xoffset, this->yoffset, this->xbase, this->ybase, this->width, this->height, this->crop);
 	} else {
-		Image32bpp *im32 = new Image32bpp(imf, bmd);
-		img = im32;
-		if (this->recolour.length >= 0) {
-			rmf = new ImageFile;
-			err = rmf->LoadFile(this->recolour.MakeFilename(col));
-			if (err != nullptr) goto report_error;
-			if (!rmf->Is8bpp()) {
-				err = "Recolour file is not an 8bpp image.\n";
-				goto report_error;
+		Image32bpp img(&imf, bmd);
+		if (this->recolour == "") {
+			err = sprite_image->CopySprite(&img, this->xoffset, this->yoffset, this->xbase, this->ybase, this->width, this->height, this->crop);
+		} else {
+			ImageFile rmf;
+			err = rmf.LoadFile(this->recolour);
+			if (err != nullptr) {
+				AddMessage(messages, "Error at %s, loading of the recolour file failed: %s\n", this->pos.c_str(), err);
+				return false;
+			}
+			if (!rmf.Is8bpp()) {
+				AddMessage(messages, "Error at %s, recolour file must be an 8bpp image.\n", this->pos.c_str());
+				return false;
 			}
-			rim = new Image8bpp(rmf, nullptr);
-			im32->SetRecolourImage(rim);
+			Image8bpp rim(&rmf, nullptr);
+			img.SetRecolourImage(&rim);
+			err = sprite_image->CopySprite(&img, this->xoffset, this->yoffset, this->xbase, this->ybase, this->width, this->height, this->crop);
 		}
 	}
+	if (err != nullptr) {
+		AddMessage(messages, "Error at %s, copying the sprite for \"%s\" failed: %s\n", this->pos.c_str(), this->name.c_str(), err);
+		return false;
+	}
+	return true;
+}
 
-	std::shared_ptr<SpriteBlock> spr_blk(new SpriteBlock);
-	err = spr_blk->sprite_image.CopySprite(img, this->xoffset, this->yoffset, this->xbase, this->ybase, this->width, this->height, this->crop);
-	if (err != nullptr) goto report_error;
+/**
+ * Constructor of a sprite from a sprite sheet.
+ * @param pos %Position of the sprite in the input.
+ * @param name %Name of the sprite.
+ * @param sheet Sheet containing the sprite.
+ * @param row Row of the sprite in the sheet.
+ * @param col Column of the sprite in the sheet.
+ */
+SheetSpriteSource::SheetSpriteSource(const Position &pos, const std::string &name, std::shared_ptr<SheetBlock> sheet, int row, int col)
+		: SpriteSource(pos, name), sheet(sheet), row(row), col(col)
+{
+}
 
-	delete imf;
-	delete rmf;
-	delete img;
-	delete rim;
-	return spr_blk;
+bool SheetSpriteSource::MakeSprite(SpriteImage *sprite_image, std::string *messages)
+{
+	Image *img = this->sheet->GetSheet(messages);
+	if (img == nullptr) return false;
+
+	const SheetBlock *sb = this->sheet.get();
+	const char *err = sprite_image->CopySprite(img, sb->x_offset, sb->y_offset,
+			sb->x_base + sb->x_step * this->col, sb->y_base + sb->y_step * this->row, sb->width, sb->height, sb->crop);
+	if (err != nullptr) {
+		AddMessage(messages, "Error at %s, loading of the sprite for \"%s\" failed: %s\n", this->pos.c_str(), this->name.c_str(), err);
+		return false;
+	}
+	return true;
+}
+
+/** Sprite waiting to be made by #MakeSprites. */
+struct SpriteJob {
+	std::shared_ptr<SpriteBlock> sprite;  ///< Sprite block to fill.
+	std::unique_ptr<SpriteSource> source; ///< Source of the sprite image.
+	std::string messages;                 ///< Messages of making the sprite.
+	bool success;                         ///< Whether making the sprite succeeded.
+};
+
+static std::vector<SpriteJob> _sprite_jobs; ///< Sprites waiting to be made, in the order of the input.
+
+/**
+ * Add a sprite to make by #MakeSprites.
+ * @param sprite Sprite block to fill.
+ * @param source Source of the sprite image, ownership is taken.
+ */
+void AddSpriteJob(std::shared_ptr<SpriteBlock> sprite, SpriteSource *source)
+{
+	_sprite_jobs.emplace_back();
+	SpriteJob &job = _sprite_jobs.back();
+	job.sprite = sprite;
+	job.source.reset(source);
+	job.success = false;
+}
+
+/**
+ * Load and encode all sprites added with #AddSpriteJob, using the threads of the job pool.
+ * Messages are printed in the order of the input, and the program stops at the first sprite that failed.
+ */
+void MakeSprites()
+{
+	_job_pool.Run(_sprite_jobs.size(), [](uint number) {
+		SpriteJob &job = _sprite_jobs[number];
+		job.success = job.source->MakeSprite(&job.sprite->sprite_image, &job.messages);
+		job.source = nullptr; // Release the sheet after its last sprite.
+	});
+
+	for (const SpriteJob &job : _sprite_jobs) {
+		fputs(job.messages.c_str(), stderr);
+		if (!job.success) exit(1);
+	}
+	_sprite_jobs.clear();
 }
 
 TSELBlock::TSELBlock() : GameBlock("TSEL", 2)
@@ -16,6 +16,7 @@
 #include <map>
 #include <memory>
 #include <array>
+#include <mutex>
 #include "image.h"
 
 class FileWriter;
@@ -124,13 +125,13 @@ public:
 };
 
 /** Block containing a sprite sheet. */
-class SheetBlock : public BlockNode {
+class SheetBlock : public BlockNode, public std::enable_shared_from_this<SheetBlock> {
 public:
 	SheetBlock(const Position &pos);
 	~SheetBlock();
 
 	std::shared_ptr<BlockNode> GetSubNode(int row, int col, const char *name, const Position &pos) override;
-	Image *GetSheet();
+	Image *GetSheet(std::string *messages);
 
 	Position pos;         ///< Line number defining the sheet.
 	std::string file;     ///< %Name of the file containing the sprite sheet.
@@ -153,6 +154,10 @@ public:
 	std::shared_ptr<BitMask> mask; ///< Bit mask to apply first (if available).
 	ImageFile *rmf;   ///< Loaded recolour file.
 	Image8bpp *rim;   ///< Recolour image.
+
+	std::mutex lock;        ///< Lock for loading the sheet while making sprites in parallel.
+	bool loaded;            ///< Whether loading of the sheet has been tried.
+	std::string load_error; ///< Error message of loading the sheet, empty if loading succeeded.
 };
 
 /** A 'spritefiles' block. */
@@ -175,6 +180,62 @@ public:
 	std::shared_ptr<BitMask> mask; ///< Bit mask to apply first (if available).
 };
 
+/**
+ * Source of the image of a sprite. Sprites are loaded and encoded after checking the input
+ * by #MakeSprites, which may make several sprites at the same time.
+ */
+class SpriteSource {
+public:
+	SpriteSource(const Position &pos, const std::string &name);
+	virtual ~SpriteSource();
+
+	/**
+	 * Load and encode the sprite. Different sprites may be made at the same time.
+	 * @param sprite_image [out] Sprite to fill.
+	 * @param messages [out] Messages for the user are appended to it.
+	 * @return Whether making the sprite succeeded.
+	 */
+	virtual bool MakeSprite(SpriteImage *sprite_image, std::string *messages) = 0;
+
+	std::string pos;  ///< Text of the position of the sprite in the input.
+	std::string name; ///< %Name of the sprite.
+};
+
+/** Sprite from its own image file. */
+class FileSpriteSource : public SpriteSource {
+public:
+	FileSpriteSource(const Position &pos, const std::string &name);
+
+	bool MakeSprite(SpriteImage *sprite_image, std::string *messages) override;
+
+	std::string file;     ///< %Name of the image file.
+	std::string recolour; ///< %Name of the file containing 32bpp recolour information (\c "" means no file).
+	std::shared_ptr<BitMask> mask; ///< Bit mask to apply first (if available).
+
+	int xbase;   ///< Horizontal base offset in the image.
+	int ybase;   ///< Vertical base offset in the image.
+	int xoffset; ///< Sprite offset (from the origin to the left edge of the sprite).
+	int yoffset; ///< Sprite offset (from the origin to the top edge of the sprite).
+	int width;   ///< Width of the sprite.
+	int height;  ///< Height of the sprite.
+	bool crop;   ///< Crop sprite.
+};
+
+/** Sprite from a sprite sheet. */
+class SheetSpriteSource : public SpriteSource {
+public:
+	SheetSpriteSource(const Position &pos, const std::string &name, std::shared_ptr<SheetBlock> sheet, int row, int col);
+
+	bool MakeSprite(SpriteImage *sprite_image, std::string *messages) override;
+
+	std::shared_ptr<SheetBlock> sheet; ///< Sheet containing the sprite.
+	int row; ///< Row of the sprite in the sheet.
+	int col; ///< Column of the sprite in the sheet.
+};
+
+void AddSpriteJob(std::shared_ptr<SpriteBlock> sprite, SpriteSource *source);
+void MakeSprites();
+
 /** A 'TSEL' block. */
 class TSELBlock : public GameBlock {
 public:
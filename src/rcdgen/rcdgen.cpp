@@ -9,10 +9,12 @@
 
 #include "../stdafx.h"
 #include "../getoptdata.h"
+#include "../jobs.h"
 #include "scanner_funcs.h"
 #include "ast.h"
 #include "nodes.h"
 #include "file_writing.h"
+#include <chrono>
 #include <cstdarg>
 
 /**
@@ -38,6 +40,8 @@ static const OptionData _options[] = {
 	GETOPT_VALUE('c', "--code"),
 	GETOPT_VALUE('b', "--base"),
 	GETOPT_VALUE('p', "--prefix"),
+	GETOPT_NOVAL('s', "--stats"),
+	GETOPT_VALUE('j', "--jobs"),
 	GETOPT_END()
 };
 
@@ -52,7 +56,11 @@ static void PrintUsage()
 	printf("\n");
 	printf("2. Generate RCD data files from input files or stdin:\n");
 	printf("\n");
-	printf("\trcdgen [FILE ...]\n");
+	printf("\trcdgen [--stats] [--jobs N] [FILE ...]\n");
+	printf("\n");
+	printf("   --stats prints the time of each phase, and the number of (duplicate) blocks\n");
+	printf("           of each generated file.\n");
+	printf("   --jobs  loads and encodes up to N sprites at the same time. If omitted, it is \"1\".\n");
 	printf("\n");
 	printf("3. Generate .h and/or .cpp files for strings of the program:\n");
 	printf("\n");
@@ -66,6 +74,16 @@ static void PrintUsage()
 	printf("\n");
 }
 
+/**
+ * Get the time elapsed since a given moment.
+ * @param start Moment to measure from.
+ * @return Number of milliseconds since \a start.
+ */
+static double GetElapsedMilliseconds(const std::chrono::steady_clock::time_point &start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
 /**
  * The main program of rcdgen.
  * @param argc Number of argument given to the program.
@@ -79,6 +97,8 @@ int main(int argc, char *argv[])
 	const char *code = nullptr;
 	const char *prefix = nullptr;
 	const char *base = "0";
+	bool stats = false;
+	int jobs = 1;
 
 	int opt_id;
 	do {
@@ -104,6 +124,18 @@ int main(int argc, char *argv[])
 				prefix = opt_data.opt;
 				break;
 
+			case 's':
+				stats = true;
+				break;
+
+			case 'j':
+				jobs = atoi(opt_data.opt);
+				if (jobs < 1) {
+					fprintf(stderr, "ERROR: Number of jobs must be at least 1.\n");
+					exit(1);
+				}
+				break;
+
 			case -1:
 				break;
 
@@ -125,20 +157,38 @@ int main(int argc, char *argv[])
 	if (header != nullptr) printf("Warning: --header option is not used.\n");
 	if (code != nullptr) printf("Warning: --code option is not used.\n");
 
+	_job_pool.Initialize(jobs - 1);
+
 	int num_files = std::max(1, opt_data.numleft);
 	for (int i = 0; i < num_files; i++) {
+		const char *fname = (i < opt_data.numleft) ? opt_data.argv[i] : nullptr;
+
 		/* Phase 1: Parse the input file. */
-		std::shared_ptr<NamedValueList> nvs = LoadFile((i < opt_data.numleft) ? opt_data.argv[i] : nullptr);
+		auto start = std::chrono::steady_clock::now();
+		std::shared_ptr<NamedValueList> nvs = LoadFile(fname);
+		if (stats) printf("%s: parsing took %.1f ms\n", (fname != nullptr) ? fname : "<stdin>", GetElapsedMilliseconds(start));
 
 		/* Phase 2: Check and simplify the loaded input. */
+		start = std::chrono::steady_clock::now();
 		FileNodeList *file_nodes = CheckTree(nvs);
 		nvs = nullptr;
+		if (stats) printf("%s: checking took %.1f ms\n", (fname != nullptr) ? fname : "<stdin>", GetElapsedMilliseconds(start));
+
+		/* Phase 3: Load and encode the sprites. */
+		start = std::chrono::steady_clock::now();
+		MakeSprites();
+		if (stats) printf("%s: making sprites took %.1f ms\n", (fname != nullptr) ? fname : "<stdin>", GetElapsedMilliseconds(start));
 
-		/* Phase 3: Construct output files. */
+		/* Phase 4: Construct output files. */
 		for (auto iter : file_nodes->files) {
+			start = std::chrono::steady_clock::now();
 			FileWriter fw;
 			iter->Write(&fw);
 			fw.WriteFile(iter->file_name);
+			if (stats) {
+				printf("%s: writing took %.1f ms, %u blocks of which %u duplicates\n", iter->file_name.c_str(),
+						GetElapsedMilliseconds(start), fw.added_blocks, fw.duplicate_blocks);
+			}
 		}
 
 		delete file_nodes;
@@ -196,6 +196,28 @@ static const char *_gui_string_names[] = {
 	"SETTING_LANGUAGE_TOOLTIP",
 	"SETTING_RESOLUTION",
 	"SETTING_RESOLUTION_TOOLTIP",
+
+	/* Frame profiler window. */
+	"PROFILER_TITLE",
+	"PROFILER_PHASE_TEXT",
+	"PROFILER_LAST_TEXT",
+	"PROFILER_AVERAGE_TEXT",
+	"PROFILER_MAXIMUM_TEXT",
+	"PROFILER_WINDOWS_TEXT",
+	"PROFILER_COLLECT_TEXT",
+	"PROFILER_SORT_TEXT",
+	"PROFILER_BLIT_TEXT",
+	"PROFILER_FINISH_REPAINT_TEXT",
+	"PROFILER_GUEST_TICK_TEXT",
+	"PROFILER_DATE_TEXT",
+	"PROFILER_GUEST_ANIMATE_TEXT",
+	"PROFILER_RIDE_ANIMATE_TEXT",
+	"PROFILER_TOTAL_TEXT",
+	"PROFILER_SPRITE_CACHE_HITS_TEXT",
+	"PROFILER_SPRITE_CACHE_MISSES_TEXT",
+	"PROFILER_SPRITE_CACHE_EVICTIONS_TEXT",
+	"PROFILER_TEXT_CACHE_HITS_TEXT",
+	"PROFILER_TEXT_CACHE_MISSES_TEXT",
 };
 
 /** String names of the shops. */
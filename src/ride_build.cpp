@@ -13,6 +13,7 @@
 #include "shop_type.h"
 #include "mouse_mode.h"
 #include "language.h"
+#include "path_graph.h"
 
 #include "gui_sprites.h"
 
@@ -307,6 +308,7 @@ void RideBuildWindow::SelectorMouseButtonEvent(uint8 state)
 
 	_rides_manager.NewInstanceAdded(inst_number);
 	AddRemovePathEdges(si->vox_pos, PATH_EMPTY, entrances, PAS_QUEUE_PATH);
+	_path_graph.UpdateVoxel(si->vox_pos);
 
 	this->instance = nullptr; // Delete this window, and
 	si = nullptr; // (Also clean the copy of the pointer.)
@@ -27,10 +27,61 @@ ImageData::ImageData()
 	this->data = nullptr;
 }
 
+/**
+ * Move constructor, takes the image data of another image.
+ * @param other Image to take the data from, it is left without data.
+ */
+ImageData::ImageData(ImageData &&other) : ImageData()
+{
+	*this = std::move(other);
+}
+
 ImageData::~ImageData()
 {
 	delete[] this->table;
-	delete[] this->data;
+}
+
+/**
+ * Move assignment, takes the image data of another image.
+ * @param other Image to take the data from, it is left without data.
+ * @return The image.
+ */
+ImageData &ImageData::operator=(ImageData &&other)
+{
+	if (this == &other) return *this;
+
+	delete[] this->table;
+	this->flags = other.flags;
+	this->width = other.width;
+	this->height = other.height;
+	this->xoffset = other.xoffset;
+	this->yoffset = other.yoffset;
+	this->table = other.table;
+	this->data = other.data;
+	this->file = std::move(other.file);
+
+	other.width = 0;
+	other.height = 0;
+	other.table = nullptr;
+	other.data = nullptr;
+	return *this;
+}
+
+/**
+ * Load an 8bpp or 32bpp sprite block from the \a rcd_file.
+ * Only the image itself is changed, so images can be loaded in parallel, each with its own file reader.
+ * @param rcd_file File being loaded, at the first byte of the block.
+ * @return Load was successful.
+ */
+bool ImageData::Load(RcdFileReader *rcd_file)
+{
+	bool is_8bpp = strcmp(rcd_file->name, "8PXL") == 0;
+	if (rcd_file->version != (is_8bpp ? 2 : 1)) return false;
+
+	bool loaded = is_8bpp ? this->Load8bpp(rcd_file, rcd_file->size) : this->Load32bpp(rcd_file, rcd_file->size);
+	if (!loaded) return false;
+	this->flags = is_8bpp ? (1 << IFG_IS_8BPP) : 0;
+	return true;
 }
 
 /**
@@ -59,8 +110,6 @@ bool ImageData::Load8bpp(RcdFileReader *rcd_file, size_t length)
 	length -= jmp_table;
 
 	this->table = new uint32[jmp_table / 4];
-	this->data  = new uint8[length];
-	if (this->table == nullptr || this->data == nullptr) return false;
 
 	/* Load jump table, adjusting the entries while loading. */
 	for (uint i = 0; i < this->height; i++) {
@@ -74,7 +123,10 @@ bool ImageData::Load8bpp(RcdFileReader *rcd_file, size_t length)
 		this->table[i] = dest;
 	}
 
-	rcd_file->GetBlob(this->data, length); // Load the image data.
+	/* Use the image data in the file. */
+	this->data = rcd_file->GetData(length);
+	if (this->data == nullptr) return false;
+	this->file = rcd_file->contents;
 
 	/* Verify the image data. */
 	for (uint i = 0; i < this->height; i++) {
@@ -119,13 +171,13 @@ bool ImageData::Load32bpp(RcdFileReader *rcd_file, size_t length)
 	length -= 8;
 	if (length > 100 * 1024) return false; // Another arbitrary limit.
 
-	/* Allocate and load the image data. */
-	this->data = new uint8[length];
+	/* Use the image data in the file. */
+	this->data = rcd_file->GetData(length);
 	if (this->data == nullptr) return false;
-	rcd_file->GetBlob(this->data, length);
+	this->file = rcd_file->contents;
 
 	/* Verify the data. */
-	uint8 *abs_end = this->data + length;
+	const uint8 *abs_end = this->data + length;
 	int line_count = 0;
 	const uint8 *ptr = this->data;
 	bool finished = false;
@@ -256,24 +308,44 @@ uint32 ImageData::GetPixel(uint16 xoffset, uint16 yoffset, const Recolouring *re
 }
 
 /**
- * Load 8bpp or 32bpp sprite block from the \a rcd_file.
- * @param rcd_file File being loaded.
- * @return Loaded sprite, if loading was successful, else \c nullptr.
+ * Add an empty image to the image storage, its data is loaded with ImageData::Load.
+ * @return The new image, or \c nullptr if the storage is full. Its address does not change while the image storage exists.
  */
-ImageData *LoadImage(RcdFileReader *rcd_file)
+ImageData *AddImage()
 {
-	bool is_8bpp = strcmp(rcd_file->name, "8PXL") == 0;
-	if (rcd_file->version != (is_8bpp ? 2 : 1)) return nullptr;
-
+	if (_sprites.size() >= MAX_IMAGE_COUNT) return nullptr;
 	_sprites.emplace_back();
-	ImageData *imd = &_sprites.back();
-	bool loaded = is_8bpp ? imd->Load8bpp(rcd_file, rcd_file->size) : imd->Load32bpp(rcd_file, rcd_file->size);
-	if (!loaded) {
-		_sprites.pop_back();
-		return nullptr;
-	}
-	imd->flags = is_8bpp ? (1 << IFG_IS_8BPP) : 0;
-	return imd;
+	return &_sprites.back();
+}
+
+/**
+ * Remove the last images from the image storage, for example images that failed to load.
+ * @param first Index of the first image to remove, all images from it to the end of the storage are removed.
+ */
+void RemoveImages(uint first)
+{
+	assert(first <= _sprites.size());
+	_sprites.erase(_sprites.begin() + first, _sprites.end());
+}
+
+/**
+ * Get the number of loaded images.
+ * @return Number of images in the image storage.
+ */
+uint GetImageCount()
+{
+	return _sprites.size();
+}
+
+/**
+ * Get a loaded image.
+ * @param index Index of the image, must be less than #GetImageCount.
+ * @return The requested image.
+ */
+const ImageData *GetImage(uint index)
+{
+	assert(index < _sprites.size());
+	return &_sprites[index];
 }
 
 /** Initialize image storage. */
@@ -10,9 +10,12 @@
 #ifndef SPRITE_DATA_H
 #define SPRITE_DATA_H
 
+#include <memory>
+
 static const uint32 INVALID_JUMP = UINT32_MAX; ///< Invalid jump destination in image data.
 
 class RcdFileReader;
+class FileContents;
 
 /** Flags of an image in #ImageData. */
 enum ImageFlags {
@@ -26,8 +29,12 @@ enum ImageFlags {
 class ImageData {
 public:
 	ImageData();
+	ImageData(ImageData &&other);
 	~ImageData();
 
+	ImageData &operator=(ImageData &&other);
+
+	bool Load(RcdFileReader *rcd_file);
 	bool Load8bpp(RcdFileReader *rcd_file, size_t length);
 	bool Load32bpp(RcdFileReader *rcd_file, size_t length);
 
@@ -48,10 +55,14 @@ public:
 	int16 xoffset; ///< Horizontal offset of the image.
 	int16 yoffset; ///< Vertical offset of the image.
 	uint32 *table; ///< The jump table. For missing entries, #INVALID_JUMP is used.
-	uint8 *data;   ///< The image data itself.
+	const uint8 *data; ///< The image data itself, inside #file.
+	std::shared_ptr<const FileContents> file; ///< Contents of the RCD file with the image data.
 };
 
-ImageData *LoadImage(RcdFileReader *rcd_file);
+ImageData *AddImage();
+void RemoveImages(uint first);
+uint GetImageCount();
+const ImageData *GetImage(uint index);
 
 void InitImageStorage();
 void DestroyImageStorage();
@@ -26,6 +26,7 @@
 #include "coaster.h"
 #include "gui_sprites.h"
 #include "string_func.h"
+#include "jobs.h"
 
 SpriteManager _sprite_manager; ///< Sprite manager.
 GuiSprites _gui_sprites;       ///< GUI sprites.
@@ -1258,17 +1259,55 @@ SpriteManager::~SpriteManager()
 	/* Sprite stores will be deleted soon as well. */
 }
 
+/** RCD file being loaded, its image blocks are loaded before the other blocks. */
+struct RcdFileLoad {
+	/**
+	 * Open an RCD file for loading.
+	 * @param fname Name of the file.
+	 */
+	RcdFileLoad(const char *fname) : fname(fname), rcd_file(fname)
+	{
+	}
+
+	void FindImageBlocks();
+
+	std::string fname;                       ///< Name of the file.
+	RcdFileReader rcd_file;                  ///< Reader of the file.
+	std::vector<RcdFileReader> image_blocks; ///< Readers at the start of each image block of the file.
+	std::vector<ImageData *> images;         ///< Loaded image of each image block, \c nullptr if loading failed.
+};
+
+/** Collect the image blocks of the file. */
+void RcdFileLoad::FindImageBlocks()
+{
+	RcdFileReader scan = this->rcd_file;
+	if (!scan.CheckFileHeader("RCDF", 2)) return;
+
+	while (scan.ReadBlockHeader()) {
+		if (strcmp(scan.name, "8PXL") == 0 || strcmp(scan.name, "32PX") == 0) this->image_blocks.push_back(scan);
+		if (!scan.SkipBytes(scan.size)) return;
+	}
+}
+
+/** Image block to load. */
+struct RcdImageLoad {
+	const RcdFileReader *block; ///< Reader at the start of the image block.
+	ImageData *image;           ///< Image to load the block into, \c nullptr after it failed to load.
+	bool loaded;                ///< Whether the image loaded successfully.
+};
+
 /**
- * Load sprites from the disk.
- * @param filename Name of the RCD file to load.
+ * Load the blocks of an RCD file.
+ * @param rcd_file File to load.
+ * @param images Images of the image blocks of the file, in the order of the blocks, \c nullptr for images that failed to load.
  * @return Error message if load failed, else \c nullptr.
  * @todo Try to re-use already loaded blocks.
  * @todo Code will use last loaded surface as grass.
  */
-const char *SpriteManager::Load(const char *filename)
+const char *SpriteManager::Load(RcdFileReader &rcd_file, const std::vector<ImageData *> &images)
 {
-	RcdFileReader rcd_file(filename);
 	if (!rcd_file.CheckFileHeader("RCDF", 2)) return "Bad header";
+	uint image_index = 0; // Index of the next image block.
 
 	ImageMap sprites; // Sprites loaded from this file.
 	TextMap  texts;   // Texts loaded from this file.
@@ -1285,8 +1324,9 @@ const char *SpriteManager::Load(const char *filename)
 		}
 
 		if (strcmp(rcd_file.name, "8PXL") == 0 || strcmp(rcd_file.name, "32PX") == 0) {
-			ImageData *imd = LoadImage(&rcd_file);
-			if (imd == nullptr) {
+			ImageData *imd = (image_index < images.size()) ? images[image_index] : nullptr;
+			image_index++;
+			if (imd == nullptr || !rcd_file.SkipBytes(rcd_file.size)) {
 				return "Image data loading failed";
 			}
 			std::pair<uint, ImageData *> p(blk_num, imd);
@@ -1485,10 +1525,58 @@ SpriteStorage *SpriteManager::GetSpriteStore(uint16 width)
 /** Load all useful RCD files found by #_rcd_collection, into the program. */
 void SpriteManager::LoadRcdFiles()
 {
-	for (auto &entry : _rcd_collection.rcdfiles) {
-		const char *fname = entry.second.path.c_str();
-		const char *mesg = this->Load(fname);
-		if (mesg != nullptr) fprintf(stderr, "Error while reading \"%s\": %s\n", fname, mesg);
+	std::vector<RcdFileLoad> files;
+	files.reserve(_rcd_collection.rcdfiles.size());
+	for (auto &entry : _rcd_collection.rcdfiles) files.emplace_back(entry.second.path.c_str());
+
+	/* Find the image blocks of the files in parallel. */
+	_job_pool.Run(files.size(), [&files](uint f) { files[f].FindImageBlocks(); });
+
+	/* Reserve storage for the images in file order, so the result does not depend on the order of loading. */
+	std::vector<RcdImageLoad> images;
+	for (RcdFileLoad &file : files) {
+		for (const RcdFileReader &block : file.image_blocks) {
+			ImageData *imd = AddImage();
+			if (imd == nullptr) break; // Image storage is full.
+			images.push_back({&block, imd, false});
+		}
+	}
+
+	/* Decode the images in parallel. */
+	uint first_image = GetImageCount() - images.size();
+	ImageData *storage = images.empty() ? nullptr : images[0].image; // The added images are consecutive in the image storage.
+	_job_pool.Run(images.size(), [&images](uint i) {
+		RcdFileReader rcd_file = *images[i].block;
+		images[i].loaded = images[i].image->Load(&rcd_file);
+	});
+
+	/* Move the loaded images together, and drop the images that failed to load, so the image storage only has loaded images. */
+	uint loaded_count = 0;
+	for (RcdImageLoad &ril : images) {
+		if (!ril.loaded) {
+			ril.image = nullptr;
+			continue;
+		}
+		ImageData *imd = storage + loaded_count++;
+		if (imd != ril.image) {
+			*imd = std::move(*ril.image);
+			ril.image = imd;
+		}
+	}
+	RemoveImages(first_image + loaded_count);
+
+	uint next_image = 0;
+	for (RcdFileLoad &file : files) {
+		for (uint i = 0; i < file.image_blocks.size() && next_image < images.size(); i++) {
+			const RcdImageLoad &ril = images[next_image++];
+			file.images.push_back(ril.image);
+		}
+	}
+
+	/* Load the other blocks, which may refer to the images, in file order. */
+	for (RcdFileLoad &file : files) {
+		const char *mesg = this->Load(file.rcd_file, file.images);
+		if (mesg != nullptr) fprintf(stderr, "Error while reading \"%s\": %s\n", file.fname.c_str(), mesg);
 	}
 }
 
@@ -19,6 +19,7 @@
 #include "track_piece.h"
 #include "weather.h"
 #include <map>
+#include <vector>
 
 extern const uint8 _slope_rotation[NUM_SLOPE_SPRITES][4];
 
@@ -626,7 +627,7 @@ public:
 	PathStatus GetPathStatus(PathType path_type);
 
 protected:
-	const char *Load(const char *fname);
+	const char *Load(RcdFileReader &rcd_file, const std::vector<ImageData *> &images);
 	SpriteStorage *GetSpriteStore(uint16 width);
 
 	RcdBlock *blocks;         ///< List of loaded RCD data blocks.
@@ -7,6 +7,7 @@
 
 /** @file track_piece.cpp Functions of the track pieces. */
 
+#include <cmath>
 #include "stdafx.h"
 #include "sprite_store.h"
 #include "fileio.h"
@@ -219,7 +220,38 @@ bool TrackPiece::Load(RcdFileReader *rcd_file, const ImageMap &sprites)
 	ok = ok && LoadTrackCurve(rcd_file, &this->car_roll,  &length);
 	ok = ok && LoadTrackCurve(rcd_file, &this->car_yaw,   &length);
 	if (!ok || this->car_xpos == nullptr || this->car_ypos == nullptr || this->car_zpos == nullptr || this->car_roll == nullptr) return false;
-	return length == 0;
+	if (length != 0) return false;
+
+	this->MakeSamples();
+	return true;
+}
+
+/**
+ * Convert a value of a car curve to fixed point.
+ * @param value Value of the curve.
+ * @return The value with #TRACK_SAMPLE_PRECISION fraction bits.
+ */
+static inline int32 ToSampleValue(double value)
+{
+	return static_cast<int32>(std::lround(value * (1 << TRACK_SAMPLE_PRECISION)));
+}
+
+/**
+ * Sample the car curves of the track piece, so the position of a car does not need to evaluate the curves while the cars move.
+ * Samples are taken at every (1 << #TRACK_SAMPLE_SHIFT) distance, with an additional sample at the end of the piece.
+ */
+void TrackPiece::MakeSamples()
+{
+	uint32 count = (this->piece_length >> TRACK_SAMPLE_SHIFT) + 2;
+	this->samples.resize(count);
+	for (uint32 i = 0; i < count; i++) {
+		uint32 distance = std::min(i << TRACK_SAMPLE_SHIFT, this->piece_length);
+		TrackSample &sample = this->samples[i];
+		sample.xpos = ToSampleValue(this->car_xpos->GetValue(distance));
+		sample.ypos = ToSampleValue(this->car_ypos->GetValue(distance));
+		sample.zpos = ToSampleValue(this->car_zpos->GetValue(distance));
+		sample.roll = ToSampleValue(this->car_roll->GetValue(distance));
+	}
 }
 
 /**
@@ -156,6 +156,17 @@ public:
 	std::vector<CubicBezier> curve; ///< Curve describing the track piece.
 };
 
+static const int TRACK_SAMPLE_SHIFT = 8; ///< Distance between two samples of a track piece, as a shift of the distance.
+static const int TRACK_SAMPLE_PRECISION = 8; ///< Number of fraction bits in the values of a #TrackSample.
+
+/** Values of the car curves at a sampled distance of a track piece, in fixed point with #TRACK_SAMPLE_PRECISION fraction bits. */
+struct TrackSample {
+	int32 xpos; ///< X position of the car.
+	int32 ypos; ///< Y position of the car.
+	int32 zpos; ///< Z position of the car.
+	int32 roll; ///< Roll of the car.
+};
+
 /** One track piece (type) of a roller coaster track. */
 class TrackPiece {
 public:
@@ -180,6 +191,34 @@ public:
 	TrackCurve *car_pitch;    ///< Pitch of cars over this track piece, may be \c nullptr.
 	TrackCurve *car_roll;     ///< Roll of cars over this track piece.
 	TrackCurve *car_yaw;      ///< Yaw of cars over this track piece, may be \c null.
+	std::vector<TrackSample> samples; ///< Car curves sampled every (1 << #TRACK_SAMPLE_SHIFT) distance.
+
+	/**
+	 * Get the position and roll of a car at the track piece, interpolated between the samples of the car curves.
+	 * @param distance Distance of the car at the track piece, in 1/256 pixel.
+	 * @return Values of the car curves at the given distance.
+	 * @pre \a distance must be at or below #piece_length.
+	 */
+	inline TrackSample GetSample(uint32 distance) const
+	{
+		uint32 index = distance >> TRACK_SAMPLE_SHIFT;
+		int32 frac = distance & ((1 << TRACK_SAMPLE_SHIFT) - 1);
+		const int32 half = 1 << (TRACK_SAMPLE_SHIFT - 1);
+		assert(index + 1 < this->samples.size());
+		const TrackSample &low = this->samples[index];
+		const TrackSample &high = this->samples[index + 1];
+
+		/* The last interval ends at the end of the piece, scale its fraction to the full interval. */
+		uint32 length = this->piece_length - (index << TRACK_SAMPLE_SHIFT);
+		if (length < (1u << TRACK_SAMPLE_SHIFT) && length > 0) frac = (frac << TRACK_SAMPLE_SHIFT) / length;
+
+		TrackSample sample;
+		sample.xpos = low.xpos + (((high.xpos - low.xpos) * frac + half) >> TRACK_SAMPLE_SHIFT);
+		sample.ypos = low.ypos + (((high.ypos - low.ypos) * frac + half) >> TRACK_SAMPLE_SHIFT);
+		sample.zpos = low.zpos + (((high.zpos - low.zpos) * frac + half) >> TRACK_SAMPLE_SHIFT);
+		sample.roll = low.roll + (((high.roll - low.roll) * frac + half) >> TRACK_SAMPLE_SHIFT);
+		return sample;
+	}
 
 	/**
 	 * Check whether the track piece is powered.
@@ -259,6 +298,9 @@ public:
 		if ((bend & 4) != 0) bend |= ~7;
 		return (TrackBend)(bend + 3);
 	}
+
+private:
+	void MakeSamples();
 };
 
 /** Shared pointer to a const #TrackPiece. */
@@ -13,7 +13,9 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 UnixDirectoryReader::UnixDirectoryReader() : DirectoryReader('/')
@@ -96,3 +98,35 @@ bool PathIsDirectory(const char *path)
 	return S_ISDIR(st.st_mode);
 }
 
+/**
+ * Map the contents of a file into memory for reading.
+ * @param fname Name of the file to map.
+ * @param size [out] Size of the file.
+ * @return Address of the mapped file, or \c nullptr if the file could not be mapped.
+ */
+const uint8 *MapFile(const char *fname, size_t *size)
+{
+	int fd = open(fname, O_RDONLY);
+	if (fd < 0) return nullptr;
+
+	struct stat st;
+	void *data = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd); // The mapping stays valid after closing the file.
+	if (data == MAP_FAILED) return nullptr;
+
+	*size = st.st_size;
+	return static_cast<const uint8 *>(data);
+}
+
+/**
+ * Release a file mapped with #MapFile.
+ * @param data Address of the mapped file.
+ * @param size Size of the file.
+ */
+void UnmapFile(const uint8 *data, size_t size)
+{
+	munmap(const_cast<uint8 *>(data), size);
+}
@@ -19,13 +19,33 @@
 #include "window.h"
 #include "viewport.h"
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#	define WITH_SSE2_BLITTERS
+#	define SSE2_TARGET __attribute__((target("sse2"))) ///< Compile the function with SSE2 instructions.
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#	define WITH_SSE2_BLITTERS
+#	define SSE2_TARGET
+#	include <intrin.h>
+#endif
+
+#ifdef WITH_SSE2_BLITTERS
+#	include <emmintrin.h>
+#endif
+
 VideoSystem _video;  ///< Video sub-system.
 
+static const uint MAX_DIRTY_AREAS = 16; ///< Maximum number of separate dirty areas before they are combined into one area.
+static const uint MAX_CACHED_TEXTS = 256; ///< Maximum number of texts in the text cache.
+static const uint32 MAX_CACHED_SPRITE_PIXELS = 4 * 1024 * 1024; ///< Maximum number of pixels of the sprites in the sprite cache.
+static const uint32 MAX_CACHED_SPRITE_SIZE = MAX_CACHED_SPRITE_PIXELS / 64; ///< Maximum number of pixels of a sprite in the sprite cache, bigger sprites are not cached.
+
 /** Default constructor of a clipped rectangle. */
 ClippedRectangle::ClippedRectangle()
 {
 	this->absx = 0;
 	this->absy = 0;
+	this->xoffset = 0;
+	this->yoffset = 0;
 	this->width = 0;
 	this->height = 0;
 	this->address = nullptr; this->pitch = 0;
@@ -42,6 +62,8 @@ ClippedRectangle::ClippedRectangle(uint16 x, uint16 y, uint16 w, uint16 h)
 {
 	this->absx = x;
 	this->absy = y;
+	this->xoffset = 0;
+	this->yoffset = 0;
 	this->width = w;
 	this->height = h;
 	this->address = nullptr; this->pitch = 0;
@@ -50,30 +72,53 @@ ClippedRectangle::ClippedRectangle(uint16 x, uint16 y, uint16 w, uint16 h)
 /**
  * Construct a clipped rectangle inside an existing one.
  * @param cr Existing rectangle.
- * @param x Top-left x position.
- * @param y Top-left y position.
+ * @param x Top-left x position, relative to the drawing origin of \a cr.
+ * @param y Top-left y position, relative to the drawing origin of \a cr.
  * @param w Width.
  * @param h Height.
- * @note %Rectangle is clipped to the old one.
+ * @note %Rectangle is clipped to the old one. The drawing origin of the new rectangle stays at (\a x, \a y), even if that point is clipped away.
  */
 ClippedRectangle::ClippedRectangle(const ClippedRectangle &cr, uint16 x, uint16 y, uint16 w, uint16 h)
 {
-	if (x >= cr.width || y >= cr.height) {
+	int left   = std::max<int>(x, cr.xoffset);
+	int top    = std::max<int>(y, cr.yoffset);
+	int right  = std::min<int>(x + w, cr.xoffset + cr.width);
+	int bottom = std::min<int>(y + h, cr.yoffset + cr.height);
+	if (left >= right || top >= bottom) {
 		this->absx = 0;
 		this->absy = 0;
+		this->xoffset = 0;
+		this->yoffset = 0;
 		this->width = 0;
 		this->height = 0;
 		this->address = nullptr; this->pitch = 0;
 		return;
 	}
-	if (x + w > cr.width)  w = cr.width - x;
-	if (y + h > cr.height) h = cr.height - y;
 
-	this->absx = cr.absx + x;
-	this->absy = cr.absy + y;
+	this->absx = cr.absx + left - cr.xoffset;
+	this->absy = cr.absy + top - cr.yoffset;
+	this->xoffset = left - x;
+	this->yoffset = top - y;
+	this->width = right - left;
+	this->height = bottom - top;
+	this->address = nullptr; this->pitch = 0;
+}
+
+/**
+ * Construct a clipped rectangle covering an offscreen buffer, with the drawing origin at the top-left of the buffer.
+ * @param buffer Pixels of the buffer, row by row.
+ * @param w Width of the buffer, which is also the pitch of its rows.
+ * @param h Height of the buffer.
+ */
+ClippedRectangle::ClippedRectangle(uint32 *buffer, uint16 w, uint16 h)
+{
+	this->absx = 0;
+	this->absy = 0;
+	this->xoffset = 0;
+	this->yoffset = 0;
 	this->width = w;
 	this->height = h;
-	this->address = nullptr; this->pitch = 0;
+	this->address = buffer; this->pitch = w;
 }
 
 /**
@@ -84,6 +129,8 @@ ClippedRectangle::ClippedRectangle(const ClippedRectangle &cr)
 {
 	this->absx = cr.absx;
 	this->absy = cr.absy;
+	this->xoffset = cr.xoffset;
+	this->yoffset = cr.yoffset;
 	this->width = cr.width;
 	this->height = cr.height;
 	this->address = cr.address; this->pitch = cr.pitch;
@@ -99,6 +146,8 @@ ClippedRectangle &ClippedRectangle::operator=(const ClippedRectangle &cr)
 	if (this != &cr) {
 		this->absx = cr.absx;
 		this->absy = cr.absy;
+		this->xoffset = cr.xoffset;
+		this->yoffset = cr.yoffset;
 		this->width = cr.width;
 		this->height = cr.height;
 		this->address = cr.address; this->pitch = cr.pitch;
@@ -115,6 +164,236 @@ void ClippedRectangle::ValidateAddress()
 	}
 }
 
+/**
+ * Restrict the rectangle to the given area, without moving the drawing origin.
+ * @param area Area to restrict to, relative to the drawing origin.
+ */
+void ClippedRectangle::RestrictTo(const Rectangle32 &area)
+{
+	int left   = std::max<int>(area.base.x, this->xoffset);
+	int top    = std::max<int>(area.base.y, this->yoffset);
+	int right  = std::min<int>(area.base.x + area.width, this->xoffset + this->width);
+	int bottom = std::min<int>(area.base.y + area.height, this->yoffset + this->height);
+	if (left >= right || top >= bottom) {
+		this->width = 0;
+		this->height = 0;
+	} else {
+		if (this->address != nullptr) this->address += (left - this->xoffset) + (top - this->yoffset) * this->pitch;
+		this->absx += left - this->xoffset;
+		this->absy += top - this->yoffset;
+		this->xoffset = left;
+		this->yoffset = top;
+		this->width = right - left;
+		this->height = bottom - top;
+	}
+}
+
+/**
+ * Constructor of a rendered text, without any rendered data.
+ * @param text Text in UTF-8 encoding.
+ */
+RenderedText::RenderedText(const std::string &text) : text(text)
+{
+	this->has_size = false;
+	this->size_width = 0;
+	this->size_height = 0;
+	this->has_mask = false;
+	this->mask_width = 0;
+	this->mask_height = 0;
+}
+
+/** Constructor of the text cache. */
+TextCache::TextCache()
+{
+	this->hits = 0;
+	this->misses = 0;
+}
+
+/**
+ * Get the cache entry of a text. If the text is not in the cache, an entry without rendered data is added.
+ * @param text Text to look up.
+ * @return The cache entry of the text, valid until the next call.
+ */
+RenderedText *TextCache::Get(const uint8 *text)
+{
+	std::string key((const char *)text);
+	auto iter = this->lookup.find(key);
+	if (iter != this->lookup.end()) {
+		this->texts.splice(this->texts.begin(), this->texts, iter->second); // Move to the front.
+		return &this->texts.front();
+	}
+
+	if (this->texts.size() >= MAX_CACHED_TEXTS) {
+		this->lookup.erase(this->texts.back().text);
+		this->texts.pop_back();
+	}
+	this->texts.emplace_front(key);
+	this->lookup[key] = this->texts.begin();
+	return &this->texts.front();
+}
+
+/** Remove all texts from the cache. */
+void TextCache::Clear()
+{
+	this->texts.clear();
+	this->lookup.clear();
+}
+
+/**
+ * Decode an image into pixels, see #DecodedSprite::pixels.
+ * @param spr The image to decode.
+ * @param recolour Sprite recolouring definition.
+ * @param shift Gradient shift.
+ * @param pixels [out] Decoded pixels, row by row. Must be cleared by the caller.
+ * @return Whether the image could be decoded. Pixels of a 32bpp image that are blended at full opacity cannot be stored, as full opacity means copying.
+ */
+static bool DecodeImage(const ImageData *spr, const Recolouring &recolour, GradientShift shift, uint32 *pixels)
+{
+	if (GB(spr->flags, IFG_IS_8BPP, 1) != 0) {
+		const uint8 *recoloured = recolour.GetPalette(shift);
+		for (int yoff = 0; yoff < spr->height; yoff++) {
+			uint32 offset = spr->table[yoff];
+			if (offset == INVALID_JUMP) continue;
+
+			uint32 *dest = pixels + yoff * spr->width;
+			for (;;) {
+				uint8 rel_off = spr->data[offset];
+				uint8 count   = spr->data[offset + 1];
+				const uint8 *src = &spr->data[offset + 2];
+				offset += 2 + count;
+
+				dest += rel_off & 127;
+				for (; count > 0; count--) *dest++ = _palette[recoloured[*src++]];
+				if ((rel_off & 128) != 0) break;
+			}
+		}
+		return true;
+	}
+
+	ShiftFunc sf = GetGradientShiftFunc(shift);
+	const uint8 *src = spr->data;
+	for (int yoff = 0; yoff < spr->height; yoff++) {
+		uint16 length = src[0] | (src[1] << 8); // Length of the row data, including the length word.
+		const uint8 *row = src + 2;
+		uint32 *dest = pixels + yoff * spr->width;
+		for (;;) {
+			uint8 mode = *row++;
+			if (mode == 0) break;
+
+			int count = mode & 0x3F;
+			switch (mode >> 6) {
+				case 0: // Fully opaque pixels.
+					if (shift == GS_SEMI_TRANSPARENT) {
+						for (int i = 0; i < count; i++) dest[i] = MakeRGBA(255, 255, 255, OPACITY_SEMI_TRANSPARENT);
+					} else {
+						for (int i = 0; i < count; i++) {
+							const uint8 *rgb = row + 3 * i;
+							dest[i] = MakeRGBA(sf(rgb[0]), sf(rgb[1]), sf(rgb[2]), OPAQUE);
+						}
+					}
+					row += 3 * count;
+					break;
+
+				case 1: { // Partial opaque pixels.
+					uint8 opacity = *row++;
+					if (shift == GS_SEMI_TRANSPARENT && opacity > OPACITY_SEMI_TRANSPARENT) opacity = OPACITY_SEMI_TRANSPARENT;
+					if (opacity == OPAQUE) return false;
+					for (int i = 0; i < count; i++) {
+						const uint8 *rgb = row + 3 * i;
+						dest[i] = MakeRGBA(sf(rgb[0]), sf(rgb[1]), sf(rgb[2]), opacity);
+					}
+					row += 3 * count;
+					break;
+				}
+
+				case 2: // Fully transparent pixels.
+					break;
+
+				case 3: { // Recoloured pixels.
+					const uint32 *table = recolour.GetRecolourTable(*row++ - 1);
+					uint8 opacity = *row++;
+					if (shift == GS_SEMI_TRANSPARENT && opacity > OPACITY_SEMI_TRANSPARENT) opacity = OPACITY_SEMI_TRANSPARENT;
+					if (opacity == OPAQUE) return false;
+					for (int i = 0; i < count; i++) {
+						uint32 colour = table[*row++];
+						dest[i] = MakeRGBA(sf(GetR(colour)), sf(GetG(colour)), sf(GetB(colour)), opacity);
+					}
+					break;
+				}
+			}
+			dest += count;
+		}
+		src += length;
+	}
+	return true;
+}
+
+/**
+ * Constructor of a decoded sprite, without pixels.
+ * @param spr Sprite being decoded.
+ * @param recolour_hash Hash of the recolouring of the sprite.
+ * @param shift Gradient shift of the sprite.
+ */
+DecodedSprite::DecodedSprite(const ImageData *spr, uint64 recolour_hash, GradientShift shift) : spr(spr), recolour_hash(recolour_hash), shift(shift)
+{
+}
+
+/** Constructor of the sprite cache. */
+SpriteCache::SpriteCache()
+{
+	this->hits = 0;
+	this->misses = 0;
+	this->evictions = 0;
+	this->pixel_count = 0;
+}
+
+/**
+ * Get a sprite decoded with a recolouring and a gradient shift. If the sprite is not in the cache, it is decoded and added.
+ * @param spr Sprite to look up.
+ * @param recolour Sprite recolouring definition.
+ * @param shift Gradient shift.
+ * @return The decoded sprite, valid until the next call, or \c nullptr if the sprite is too big to cache or cannot be decoded.
+ */
+const DecodedSprite *SpriteCache::Get(const ImageData *spr, const Recolouring &recolour, GradientShift shift)
+{
+	uint32 size = spr->width * spr->height;
+	if (size > MAX_CACHED_SPRITE_SIZE) return nullptr;
+
+	SpriteKey key(spr, recolour.GetHash(), shift);
+	auto iter = this->lookup.find(key);
+	if (iter != this->lookup.end()) {
+		this->hits++;
+		this->sprites.splice(this->sprites.begin(), this->sprites, iter->second); // Move to the front.
+		const DecodedSprite &decoded = this->sprites.front();
+		return decoded.pixels.empty() ? nullptr : &decoded;
+	}
+
+	this->misses++;
+	while (this->pixel_count + size > MAX_CACHED_SPRITE_PIXELS) {
+		const DecodedSprite &oldest = this->sprites.back();
+		this->pixel_count -= oldest.pixels.size();
+		this->lookup.erase(SpriteKey(oldest.spr, oldest.recolour_hash, oldest.shift));
+		this->sprites.pop_back();
+		this->evictions++;
+	}
+
+	this->sprites.emplace_front(spr, std::get<1>(key), shift);
+	DecodedSprite &decoded = this->sprites.front();
+	decoded.pixels.resize(size, 0);
+	if (!DecodeImage(spr, recolour, shift, decoded.pixels.data())) decoded.pixels.clear(); // Remember that the sprite cannot be cached.
+	this->pixel_count += decoded.pixels.size();
+	this->lookup[key] = this->sprites.begin();
+	return decoded.pixels.empty() ? nullptr : &decoded;
+}
+
+/** Remove all sprites from the cache. */
+void SpriteCache::Clear()
+{
+	this->sprites.clear();
+	this->lookup.clear();
+	this->pixel_count = 0;
+}
+
 /**
  * Default constructor, does nothing, never goes wrong.
  * Call #Initialize to initialize the system.
@@ -122,6 +401,8 @@ void ClippedRectangle::ValidateAddress()
 VideoSystem::VideoSystem()
 {
 	this->initialized = false;
+	this->simd_blitting = true;
+	this->cache_sprites = false;
 }
 
 /** Destructor. */
@@ -212,7 +493,7 @@ std::string VideoSystem::Initialize(const char *font_name, int font_size)
 
 	this->font_height = TTF_FontLineSkip(this->font);
 	this->initialized = true;
-	this->dirty = true; // Ensure it gets painted.
+	this->MarkDisplayDirty(); // Ensure it gets painted.
 	this->missing_sprites = false;
 
 	this->digit_size.x = 0;
@@ -282,23 +563,65 @@ void VideoSystem::GetResolutions()
 /** Mark the entire display as being out of date (it needs the be repainted). */
 void VideoSystem::MarkDisplayDirty()
 {
-	this->dirty = true;
+	this->dirty_areas.clear();
+	this->dirty_areas.emplace_back(0, 0, this->vid_width, this->vid_height);
+}
+
+/**
+ * Compute the smallest rectangle containing both given rectangles.
+ * @param r1 First rectangle.
+ * @param r2 Second rectangle.
+ * @return Bounding box of both rectangles.
+ */
+static Rectangle32 GetBoundingBox(const Rectangle32 &r1, const Rectangle32 &r2)
+{
+	int32 left   = std::min(r1.base.x, r2.base.x);
+	int32 top    = std::min(r1.base.y, r2.base.y);
+	int32 right  = std::max<int32>(r1.base.x + r1.width,  r2.base.x + r2.width);
+	int32 bottom = std::max<int32>(r1.base.y + r1.height, r2.base.y + r2.height);
+	return Rectangle32(left, top, right - left, bottom - top);
 }
 
 /**
  * Mark the stated area of the screen as being out of date.
+ * Overlapping areas are merged, to ensure no part of the display is painted twice.
  * @param rect %Rectangle which is out of date.
- * @todo Keep an administration of the rectangle(s??) to update, and update just that part.
  */
 void VideoSystem::MarkDisplayDirty(const Rectangle32 &rect)
 {
-	this->dirty = true;
+	Rectangle32 area(rect);
+	area.RestrictTo(0, 0, this->vid_width, this->vid_height);
+	if (area.width == 0 || area.height == 0) return;
+
+	/* Absorb all dirty areas that overlap with the new area (merging may create new overlaps). */
+	uint i = 0;
+	while (i < this->dirty_areas.size()) {
+		if (area.Intersects(this->dirty_areas[i])) {
+			area = GetBoundingBox(area, this->dirty_areas[i]);
+			this->dirty_areas[i] = this->dirty_areas.back();
+			this->dirty_areas.pop_back();
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+
+	if (this->dirty_areas.size() >= MAX_DIRTY_AREAS) {
+		for (const Rectangle32 &r : this->dirty_areas) area = GetBoundingBox(area, r);
+		this->dirty_areas.clear();
+	}
+	this->dirty_areas.push_back(area);
 }
 
-/** Mark the display as being up-to-date. */
-void VideoSystem::MarkDisplayClean()
+/**
+ * Start repainting the display. From this point, new dirty areas are collected for the next repaint.
+ * @return Areas of the display to repaint.
+ */
+const std::vector<Rectangle32> &VideoSystem::StartRepaint()
 {
-	this->dirty = false;
+	this->repaint_areas.swap(this->dirty_areas);
+	this->dirty_areas.clear();
+	return this->repaint_areas;
 }
 
 /**
@@ -347,6 +670,8 @@ static bool HandleKeyInput(WmKeyCode key_code, const uint8 *symbol)
 	} else if (key_code == WMKC_SYMBOL) {
 		if (symbol[0] == '1') {
 			_window_manager.GetViewport()->ToggleUndergroundMode();
+		} else if (symbol[0] == 'p') {
+			ToggleProfilerGui();
 		} else if (symbol[0] == 'q') {
 			_game_control.QuitGame();
 			return true;
@@ -442,7 +767,6 @@ bool VideoSystem::HandleEvent()
 /** Main loop. Loops until told not to. */
 void VideoSystem::MainLoop()
 {
-	static const uint32 FRAME_DELAY = 30; // Number of milliseconds between two frames.
 	bool missing_sprites_check = false;
 
 	for (;;) {
@@ -476,27 +800,30 @@ void VideoSystem::MainLoop()
 void VideoSystem::Shutdown()
 {
 	if (this->initialized) {
+		this->text_cache.Clear();
+		this->sprite_cache.Clear();
 		TTF_CloseFont(this->font);
 		TTF_Quit();
 		SDL_Quit();
 		delete[] this->mem;
 		this->initialized = false;
-		this->dirty = false;
+		this->dirty_areas.clear();
 	}
 }
 
-/**
- * Finish repainting, perform the final steps.
- * @todo Implement partial window repainting.
- */
+/** Finish repainting, upload the repainted areas to the display. */
 void VideoSystem::FinishRepaint()
 {
-	SDL_UpdateTexture(this->texture, nullptr, this->mem, this->GetXSize() * sizeof(uint32)); // Upload memory to the GPU.
+	for (const Rectangle32 &area : this->repaint_areas) {
+		SDL_Rect r = {area.base.x, area.base.y, static_cast<int>(area.width), static_cast<int>(area.height)};
+		const uint32 *pixels = this->mem + area.base.x + area.base.y * this->vid_width;
+		SDL_UpdateTexture(this->texture, &r, pixels, this->vid_width * sizeof(uint32)); // Upload memory to the GPU.
+	}
+	this->repaint_areas.clear();
+
 	SDL_RenderClear(this->renderer);
 	SDL_RenderCopy(this->renderer, this->texture, nullptr, nullptr);
 	SDL_RenderPresent(this->renderer);
-
-	MarkDisplayClean();
 }
 
 /**
@@ -577,7 +904,7 @@ static void Blit8bppImages(const ClippedRectangle &cr, int32 x_base, int32 y_bas
 			for (;;) {
 				uint8 rel_off = spr->data[offset];
 				uint8 count   = spr->data[offset + 1];
-				uint8 *pixels = &spr->data[offset + 2];
+				const uint8 *pixels = &spr->data[offset + 2];
 				offset += 2 + count;
 
 				xpos += rel_off & 127;
@@ -687,6 +1014,402 @@ static void Blit32bppImages(const ClippedRectangle &cr, int32 x_base, int32 y_ba
 	}
 }
 
+/**
+ * Does the processor support SSE2 instructions?
+ * @return Whether the SSE2 blitters can be used.
+ */
+static bool CpuHasSse2()
+{
+#if defined(WITH_SSE2_BLITTERS) && defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2");
+#elif defined(WITH_SSE2_BLITTERS)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	return false;
+#endif
+}
+
+static const bool _cpu_has_sse2 = CpuHasSse2(); ///< Whether the processor supports SSE2 instructions.
+
+#ifdef WITH_SSE2_BLITTERS
+/**
+ * Read four bytes from unaligned memory.
+ * @param src Memory to read.
+ * @return The bytes, in little endian order.
+ */
+static inline int32 LoadUnaligned32(const uint8 *src)
+{
+	int32 value;
+	memcpy(&value, src, sizeof(value));
+	return value;
+}
+
+/**
+ * Convert a span of fully opaque 32bpp pixels to the display, with SSE2 instructions.
+ * @param dest Destination of the first pixel.
+ * @param rgb Red, green, and blue components of the first pixel. The byte after the last pixel is read (but not used).
+ * @param count Number of pixels to convert.
+ * @param shift Gradient shift, must not be #GS_SEMI_TRANSPARENT.
+ * @return Number of converted pixels, the remaining (less than 4) pixels are not converted.
+ */
+SSE2_TARGET static int CopyOpaqueSpanSse2(uint32 *dest, const uint8 *rgb, int count, GradientShift shift)
+{
+	/* The gradient shifts are saturated additions and subtractions of the colour components. */
+	int step = (shift - GS_NORMAL) * STEP_SIZE;
+	const __m128i lighter = _mm_set1_epi8(static_cast<char>(std::max(step, 0)));
+	const __m128i darker  = _mm_set1_epi8(static_cast<char>(std::max(-step, 0)));
+	const __m128i opaque  = _mm_set1_epi32(OPAQUE);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const uint8 *src = rgb + 3 * i;
+		/* Each lane holds red, green and blue of one pixel in its lowest three bytes. */
+		__m128i pixels = _mm_set_epi32(LoadUnaligned32(src + 9), LoadUnaligned32(src + 6), LoadUnaligned32(src + 3), LoadUnaligned32(src));
+		pixels = _mm_subs_epu8(_mm_adds_epu8(pixels, lighter), darker);
+		/* Reverse the bytes of each lane, so red ends in the top byte, and set the opacity in the lowest byte. */
+		pixels = _mm_or_si128(_mm_slli_epi16(pixels, 8), _mm_srli_epi16(pixels, 8));
+		pixels = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+		pixels = _mm_or_si128(pixels, opaque);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), pixels);
+	}
+	return i;
+}
+
+/**
+ * Draw a span of 8bpp pixels to the display, with SSE2 instructions.
+ * Groups of four fully opaque pixels are stored at once, other groups are left to the caller.
+ * @param dest Destination of the first pixel.
+ * @param pixels Palette indices of the pixels.
+ * @param count Number of pixels to draw.
+ * @param recoloured Shifted palette to use.
+ * @return Number of drawn pixels, the remaining pixels from that point are not drawn.
+ */
+SSE2_TARGET static int CopyPaletteSpanSse2(uint32 *dest, const uint8 *pixels, int count, const uint8 *recoloured)
+{
+	const __m128i alpha_mask = _mm_set1_epi32(0xFF);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i colours = _mm_set_epi32(_palette[recoloured[pixels[i + 3]]], _palette[recoloured[pixels[i + 2]]],
+				_palette[recoloured[pixels[i + 1]]], _palette[recoloured[pixels[i]]]);
+		__m128i opaque = _mm_cmpeq_epi32(_mm_and_si128(colours, alpha_mask), alpha_mask);
+		if (_mm_movemask_epi8(opaque) != 0xFFFF) break; // Some pixel needs blending.
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), colours);
+	}
+	return i;
+}
+
+/**
+ * Blend four pixels with the pixels at the display, like #BlendPixels does for a single pixel.
+ * @param colours Colours of the pixels to draw.
+ * @param old_pixels Pixels at the display.
+ * @param alpha_lo Opacity of the first two pixels, in each of their 16 bit components.
+ * @param alpha_hi Opacity of the last two pixels, in each of their 16 bit components.
+ * @return The blended opaque pixels.
+ */
+SSE2_TARGET static inline __m128i BlendPixelsSse2(__m128i colours, __m128i old_pixels, __m128i alpha_lo, __m128i alpha_hi)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi16(256);
+
+	/* (colour * opacity + old * (256 - opacity)) / 256 for each component, which fits in 16 bits. */
+	__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(colours, zero), alpha_lo),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(old_pixels, zero), _mm_sub_epi16(full, alpha_lo)));
+	__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(colours, zero), alpha_hi),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(old_pixels, zero), _mm_sub_epi16(full, alpha_hi)));
+	return _mm_or_si128(_mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)), _mm_set1_epi32(OPAQUE));
+}
+
+/**
+ * Blend a span of partially opaque 32bpp pixels with the display, with SSE2 instructions.
+ * @param dest Destination of the first pixel.
+ * @param rgb Red, green, and blue components of the first pixel. The byte after the last pixel is read (but not used).
+ * @param count Number of pixels to blend.
+ * @param shift Gradient shift.
+ * @param opacity Opacity of the pixels.
+ * @return Number of blended pixels, the remaining (less than 4) pixels are not blended.
+ */
+SSE2_TARGET static int BlendRgbSpanSse2(uint32 *dest, const uint8 *rgb, int count, GradientShift shift, uint8 opacity)
+{
+	/* The gradient shifts are saturated additions and subtractions, the semi-transparent shift makes every component white. */
+	int step = (shift == GS_SEMI_TRANSPARENT) ? 255 : (shift - GS_NORMAL) * STEP_SIZE;
+	const __m128i lighter = _mm_set1_epi8(static_cast<char>(std::max(step, 0)));
+	const __m128i darker  = _mm_set1_epi8(static_cast<char>(std::max(-step, 0)));
+	const __m128i alpha   = _mm_set1_epi16(opacity);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const uint8 *src = rgb + 3 * i;
+		__m128i pixels = _mm_set_epi32(LoadUnaligned32(src + 9), LoadUnaligned32(src + 6), LoadUnaligned32(src + 3), LoadUnaligned32(src));
+		pixels = _mm_subs_epu8(_mm_adds_epu8(pixels, lighter), darker);
+		pixels = _mm_or_si128(_mm_slli_epi16(pixels, 8), _mm_srli_epi16(pixels, 8));
+		pixels = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+		__m128i old_pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dest + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), BlendPixelsSse2(pixels, old_pixels, alpha, alpha));
+	}
+	return i;
+}
+
+/**
+ * Blend a span of recoloured 32bpp pixels with the display, with SSE2 instructions.
+ * @param dest Destination of the first pixel.
+ * @param pixels Indices of the pixels in the recolour table.
+ * @param count Number of pixels to blend.
+ * @param table Recolour table of the pixels.
+ * @param shift Gradient shift.
+ * @param opacity Opacity of the pixels.
+ * @return Number of blended pixels, the remaining (less than 4) pixels are not blended.
+ */
+SSE2_TARGET static int BlendRecolourSpanSse2(uint32 *dest, const uint8 *pixels, int count, const uint32 *table, GradientShift shift, uint8 opacity)
+{
+	int step = (shift == GS_SEMI_TRANSPARENT) ? 255 : (shift - GS_NORMAL) * STEP_SIZE;
+	const __m128i lighter = _mm_set1_epi8(static_cast<char>(std::max(step, 0)));
+	const __m128i darker  = _mm_set1_epi8(static_cast<char>(std::max(-step, 0)));
+	const __m128i alpha   = _mm_set1_epi16(opacity);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i colours = _mm_set_epi32(table[pixels[i + 3]], table[pixels[i + 2]], table[pixels[i + 1]], table[pixels[i]]);
+		colours = _mm_subs_epu8(_mm_adds_epu8(colours, lighter), darker); // The opacity byte is replaced by the blend.
+		__m128i old_pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dest + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), BlendPixelsSse2(colours, old_pixels, alpha, alpha));
+	}
+	return i;
+}
+
+/**
+ * Draw a span of decoded pixels to the display, with SSE2 instructions.
+ * @param dest Destination of the first pixel.
+ * @param src Decoded pixels, see #DecodedSprite::pixels.
+ * @param count Number of pixels to draw.
+ * @return Number of drawn pixels, the remaining (less than 4) pixels are not drawn.
+ */
+SSE2_TARGET static int BlendDecodedSpanSse2(uint32 *dest, const uint32 *src, int count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha_mask = _mm_set1_epi32(0xFF);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i colours = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+		__m128i alpha = _mm_and_si128(colours, alpha_mask);
+		__m128i opaque = _mm_cmpeq_epi32(alpha, alpha_mask);
+		if (_mm_movemask_epi8(opaque) == 0xFFFF) {
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), colours);
+			continue;
+		}
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF) continue; // Fully transparent.
+
+		/* Blend every pixel with its own opacity, opaque pixels are copied. */
+		__m128i old_pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dest + i));
+		__m128i alpha_lo = _mm_unpacklo_epi8(alpha, zero);
+		__m128i alpha_hi = _mm_unpackhi_epi8(alpha, zero);
+		alpha_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(alpha_lo, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+		alpha_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(alpha_hi, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+		__m128i blended = BlendPixelsSse2(colours, old_pixels, alpha_lo, alpha_hi);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_or_si128(_mm_and_si128(opaque, colours), _mm_andnot_si128(opaque, blended)));
+	}
+	return i;
+}
+#endif
+
+/**
+ * Compute the part of a horizontal span of pixels that is inside the clipped area.
+ * @param xpos Horizontal position of the first pixel of the span.
+ * @param count Number of pixels in the span.
+ * @param width Width of the clipped area.
+ * @param first [out] Index of the first pixel of the span to draw.
+ * @param last [out] Index of the first pixel of the span that is not drawn anymore.
+ * @return Whether some part of the span is inside the clipped area.
+ */
+static inline bool ClipSpan(int32 xpos, int count, int32 width, int *first, int *last)
+{
+	*first = std::max(0, -xpos);
+	*last = std::min(count, width - xpos);
+	return *first < *last;
+}
+
+/**
+ * Blit a single 8bpp image to the screen. Spans of pixels are clipped once, instead of clipping each pixel.
+ * @param cr Clipped rectangle to draw to.
+ * @param x_base Base X coordinate of the sprite data.
+ * @param y_base Base Y coordinate of the sprite data.
+ * @param spr The sprite to blit.
+ * @param recoloured Shifted palette to use.
+ */
+static void Blit8bppImage(const ClippedRectangle &cr, int32 x_base, int32 y_base, const ImageData *spr, const uint8 *recoloured, bool sse2)
+{
+	int yoff = std::max(0, -y_base);
+	int yend = std::min<int>(spr->height, cr.height - y_base);
+	uint32 *line_base = cr.address + x_base + cr.pitch * (y_base + yoff);
+	for (; yoff < yend; yoff++) {
+		uint32 offset = spr->table[yoff];
+		if (offset != INVALID_JUMP) {
+			int32 xpos = x_base;
+			for (;;) {
+				uint8 rel_off = spr->data[offset];
+				uint8 count   = spr->data[offset + 1];
+				const uint8 *pixels = &spr->data[offset + 2];
+				offset += 2 + count;
+
+				xpos += rel_off & 127;
+				int first, last;
+				if (ClipSpan(xpos, count, cr.width, &first, &last)) {
+					uint32 *dest = line_base + (xpos - x_base);
+#ifdef WITH_SSE2_BLITTERS
+					if (sse2) first += CopyPaletteSpanSse2(dest + first, pixels + first, last - first, recoloured);
+#endif
+					for (int i = first; i < last; i++) {
+						uint32 colour = _palette[recoloured[pixels[i]]];
+						if (GetA(colour) != OPAQUE) {
+							colour = BlendPixels(GetR(colour), GetG(colour), GetB(colour), dest[i], GetA(colour));
+						}
+						dest[i] = colour;
+					}
+				}
+				xpos += count;
+				if ((rel_off & 128) != 0) break;
+			}
+		}
+		line_base += cr.pitch;
+	}
+}
+
+/**
+ * Blit a single 32bpp image to the screen. Spans of pixels are clipped once, instead of clipping each pixel.
+ * @param cr Clipped rectangle to draw to.
+ * @param x_base Base X coordinate of the sprite data.
+ * @param y_base Base Y coordinate of the sprite data.
+ * @param spr The sprite to blit.
+ * @param recolour Sprite recolouring definition.
+ * @param shift Gradient shift.
+ */
+static void Blit32bppImage(const ClippedRectangle &cr, int32 x_base, int32 y_base, const ImageData *spr, const Recolouring &recolour, GradientShift shift, bool sse2)
+{
+	ShiftFunc sf = GetGradientShiftFunc(shift);
+	int yend = std::min<int>(spr->height, cr.height - y_base);
+	uint32 *line_base = cr.address + x_base + cr.pitch * y_base;
+	const uint8 *src = spr->data;
+	for (int yoff = 0; yoff < yend; yoff++) {
+		uint16 length = src[0] | (src[1] << 8); // Length of the row data, including the length word.
+		if (yoff + y_base < 0) { // Row is above the clipped area.
+			src += length;
+			line_base += cr.pitch;
+			continue;
+		}
+
+		const uint8 *row = src + 2;
+		uint32 *dest = line_base;
+		int32 xpos = x_base;
+		for (;;) {
+			uint8 mode = *row++;
+			if (mode == 0) break;
+
+			int count = mode & 0x3F;
+			int first, last;
+			bool visible = ClipSpan(xpos, count, cr.width, &first, &last);
+			switch (mode >> 6) {
+				case 0: // Fully opaque pixels.
+					if (visible) {
+						if (shift == GS_SEMI_TRANSPARENT) {
+							for (int i = first; i < last; i++) dest[i] = BlendPixels(255, 255, 255, dest[i], OPACITY_SEMI_TRANSPARENT);
+						} else {
+#ifdef WITH_SSE2_BLITTERS
+							if (sse2) first += CopyOpaqueSpanSse2(dest + first, row + 3 * first, last - first, shift);
+#endif
+							for (int i = first; i < last; i++) {
+								const uint8 *rgb = row + 3 * i;
+								dest[i] = MakeRGBA(sf(rgb[0]), sf(rgb[1]), sf(rgb[2]), OPAQUE);
+							}
+						}
+					}
+					row += 3 * count;
+					break;
+
+				case 1: { // Partial opaque pixels.
+					uint8 opacity = *row++;
+					if (shift == GS_SEMI_TRANSPARENT && opacity > OPACITY_SEMI_TRANSPARENT) opacity = OPACITY_SEMI_TRANSPARENT;
+					if (visible) {
+#ifdef WITH_SSE2_BLITTERS
+						if (sse2) first += BlendRgbSpanSse2(dest + first, row + 3 * first, last - first, shift, opacity);
+#endif
+						for (int i = first; i < last; i++) {
+							const uint8 *rgb = row + 3 * i;
+							dest[i] = BlendPixels(sf(rgb[0]), sf(rgb[1]), sf(rgb[2]), dest[i], opacity);
+						}
+					}
+					row += 3 * count;
+					break;
+				}
+
+				case 2: // Fully transparent pixels.
+					break;
+
+				case 3: { // Recoloured pixels.
+					uint8 layer = *row++;
+					uint8 opacity = *row++;
+					if (shift == GS_SEMI_TRANSPARENT && opacity > OPACITY_SEMI_TRANSPARENT) opacity = OPACITY_SEMI_TRANSPARENT;
+					if (visible) {
+						const uint32 *table = recolour.GetRecolourTable(layer - 1);
+#ifdef WITH_SSE2_BLITTERS
+						if (sse2) first += BlendRecolourSpanSse2(dest + first, row + first, last - first, table, shift, opacity);
+#endif
+						for (int i = first; i < last; i++) {
+							uint32 colour = table[row[i]];
+							dest[i] = BlendPixels(sf(GetR(colour)), sf(GetG(colour)), sf(GetB(colour)), dest[i], opacity);
+						}
+					}
+					row += count;
+					break;
+				}
+			}
+			xpos += count;
+			dest += count;
+		}
+		src += length;
+		line_base += cr.pitch;
+	}
+}
+
+/**
+ * Blit a decoded image to the screen.
+ * @param cr Clipped rectangle to draw to.
+ * @param x_base Base X coordinate of the sprite data.
+ * @param y_base Base Y coordinate of the sprite data.
+ * @param decoded The decoded sprite to blit.
+ */
+static void BlitDecodedImage(const ClippedRectangle &cr, int32 x_base, int32 y_base, const DecodedSprite *decoded, bool sse2)
+{
+	const int width = decoded->spr->width;
+	int xoff, xend;
+	if (!ClipSpan(x_base, width, cr.width, &xoff, &xend)) return;
+	int yoff = std::max(0, -y_base);
+	int yend = std::min<int>(decoded->spr->height, cr.height - y_base);
+
+	const uint32 *src = decoded->pixels.data() + yoff * width;
+	uint32 *dest = cr.address + x_base + cr.pitch * (y_base + yoff);
+	for (; yoff < yend; yoff++) {
+		int i = xoff;
+#ifdef WITH_SSE2_BLITTERS
+		if (sse2) i += BlendDecodedSpanSse2(dest + i, src + i, xend - i);
+#endif
+		for (; i < xend; i++) {
+			uint32 colour = src[i];
+			uint opacity = GetA(colour);
+			if (opacity == OPAQUE) {
+				dest[i] = colour;
+			} else if (opacity != TRANSPARENT) {
+				dest[i] = BlendPixels(GetR(colour), GetG(colour), GetB(colour), dest[i], opacity);
+			}
+		}
+		src += width;
+		dest += cr.pitch;
+	}
+}
+
 /**
  * Blit pixels from the \a spr relative to \a img_base into the area.
  * @param pt Base coordinates of the sprite data.
@@ -700,8 +1423,8 @@ void VideoSystem::BlitImages(const Point32 &pt, const ImageData *spr, uint16 num
 {
 	this->blit_rect.ValidateAddress();
 
-	int x_base = pt.x + spr->xoffset;
-	int y_base = pt.y + spr->yoffset;
+	int x_base = pt.x + spr->xoffset - this->blit_rect.xoffset;
+	int y_base = pt.y + spr->yoffset - this->blit_rect.yoffset;
 
 	/* Don't draw wildly outside the screen. */
 	while (numx > 0 && x_base + spr->width < 0) {
@@ -716,7 +1439,17 @@ void VideoSystem::BlitImages(const Point32 &pt, const ImageData *spr, uint16 num
 	while (numy > 0 && y_base + (numy - 1) * spr->height >= this->blit_rect.height) numy--;
 	if (numy == 0) return;
 
-	if (GB(spr->flags, IFG_IS_8BPP, 1) != 0) {
+	if (numx == 1 && numy == 1) {
+		bool sse2 = this->simd_blitting && _cpu_has_sse2;
+		const DecodedSprite *decoded = this->cache_sprites ? this->sprite_cache.Get(spr, recolour, shift) : nullptr;
+		if (decoded != nullptr) {
+			BlitDecodedImage(this->blit_rect, x_base, y_base, decoded, sse2);
+		} else if (GB(spr->flags, IFG_IS_8BPP, 1) != 0) {
+			Blit8bppImage(this->blit_rect, x_base, y_base, spr, recolour.GetPalette(shift), sse2);
+		} else {
+			Blit32bppImage(this->blit_rect, x_base, y_base, spr, recolour, shift, sse2);
+		}
+	} else if (GB(spr->flags, IFG_IS_8BPP, 1) != 0) {
 		Blit8bppImages(this->blit_rect, x_base, y_base, spr, numx, numy, recolour.GetPalette(shift));
 	} else {
 		Blit32bppImages(this->blit_rect, x_base, y_base, spr, numx, numy, recolour, shift);
@@ -731,10 +1464,19 @@ void VideoSystem::BlitImages(const Point32 &pt, const ImageData *spr, uint16 num
  */
 void VideoSystem::GetTextSize(const uint8 *text, int *width, int *height)
 {
-	if (TTF_SizeUTF8(this->font, (const char *)text, width, height) != 0) {
-		*width = 0;
-		*height = 0;
+	RenderedText *rt = this->text_cache.Get(text);
+	if (rt->has_size) {
+		this->text_cache.hits++;
+	} else {
+		this->text_cache.misses++;
+		if (TTF_SizeUTF8(this->font, (const char *)text, &rt->size_width, &rt->size_height) != 0) {
+			rt->size_width = 0;
+			rt->size_height = 0;
+		}
+		rt->has_size = true;
 	}
+	*width = rt->size_width;
+	*height = rt->size_height;
 }
 
 /**
@@ -786,19 +1528,38 @@ void VideoSystem::GetNumberRangeSize(int64 smallest, int64 biggest, int *width,
  */
 void VideoSystem::BlitText(const uint8 *text, uint32 colour, int xpos, int ypos, int width, Alignment align)
 {
-	SDL_Color col = {0, 0, 0}; // Font colour does not matter as only the bitmap is used.
-	SDL_Surface *surf = TTF_RenderUTF8_Solid(this->font, (const char *)text, col);
-	if (surf == nullptr) {
-		fprintf(stderr, "Rendering text failed (%s)\n", TTF_GetError());
-		return;
-	}
+	RenderedText *rt = this->text_cache.Get(text);
+	if (rt->has_mask) {
+		this->text_cache.hits++;
+	} else {
+		this->text_cache.misses++;
 
-	if (surf->format->BitsPerPixel != 8 || surf->format->BytesPerPixel != 1) {
-		fprintf(stderr, "Rendering text failed (Wrong surface format)\n");
-		return;
+		SDL_Color col = {0, 0, 0}; // Font colour does not matter as only the bitmap is used.
+		SDL_Surface *surf = TTF_RenderUTF8_Solid(this->font, (const char *)text, col);
+		if (surf == nullptr) {
+			fprintf(stderr, "Rendering text failed (%s)\n", TTF_GetError());
+			return;
+		}
+
+		if (surf->format->BitsPerPixel != 8 || surf->format->BytesPerPixel != 1) {
+			fprintf(stderr, "Rendering text failed (Wrong surface format)\n");
+			SDL_FreeSurface(surf);
+			return;
+		}
+
+		rt->mask_width = surf->w;
+		rt->mask_height = surf->h;
+		rt->mask.resize(surf->w * surf->h);
+		const uint8 *src = (const uint8 *)surf->pixels;
+		for (int y = 0; y < surf->h; y++) {
+			std::copy(src, src + surf->w, rt->mask.begin() + y * surf->w);
+			src += surf->pitch;
+		}
+		rt->has_mask = true;
+		SDL_FreeSurface(surf);
 	}
 
-	int real_w = std::min(surf->w, width);
+	int real_w = std::min(rt->mask_width, width);
 	switch (align) {
 		case ALG_LEFT:
 			break;
@@ -815,19 +1576,21 @@ void VideoSystem::BlitText(const uint8 *text, uint32 colour, int xpos, int ypos,
 	}
 
 	this->blit_rect.ValidateAddress();
+	xpos -= this->blit_rect.xoffset;
+	ypos -= this->blit_rect.yoffset;
 
-	uint8 *src = ((uint8 *)surf->pixels);
+	const uint8 *src = rt->mask.data();
 	uint32 *dest = this->blit_rect.address + xpos + ypos * this->blit_rect.pitch;
-	int h = surf->h;
+	int h = rt->mask_height;
 	if (ypos < 0) {
 		h += ypos;
-		src  -= ypos * surf->pitch;
+		src  -= ypos * rt->mask_width;
 		dest -= ypos * this->blit_rect.pitch;
 		ypos = 0;
 	}
 	while (h > 0) {
 		if (ypos >= this->blit_rect.height) break;
-		uint8 *src2 = src;
+		const uint8 *src2 = src;
 		uint32 *dest2 = dest;
 		int w = real_w;
 		int x = xpos;
@@ -847,12 +1610,10 @@ void VideoSystem::BlitText(const uint8 *text, uint32 colour, int xpos, int ypos,
 			w--;
 		}
 		ypos++;
-		src  += surf->pitch;
+		src  += rt->mask_width;
 		dest += this->blit_rect.pitch;
 		h--;
 	}
-
-	SDL_FreeSurface(surf);
 }
 
 /**
@@ -879,13 +1640,16 @@ void VideoSystem::DrawLine(const Point16 &start, const Point16 &end, uint32 colo
 		inc_y = 1;
 	}
 
+	this->blit_rect.ValidateAddress();
+
 	int16 step = std::min(dx, dy);
-	int16 pos_x = start.x;
-	int16 pos_y = start.y;
+	int16 pos_x = start.x - this->blit_rect.xoffset;
+	int16 pos_y = start.y - this->blit_rect.yoffset;
+	int16 end_x = end.x - this->blit_rect.xoffset;
+	int16 end_y = end.y - this->blit_rect.yoffset;
 	int16 sum_x = 0;
 	int16 sum_y = 0;
 
-	this->blit_rect.ValidateAddress();
 	uint32 *dest = this->blit_rect.address + pos_x + pos_y * this->blit_rect.pitch;
 
 	for (;;) {
@@ -893,7 +1657,7 @@ void VideoSystem::DrawLine(const Point16 &start, const Point16 &end, uint32 colo
 		if (pos_x >= 0 && pos_x < this->blit_rect.width && pos_y >= 0 && pos_y < this->blit_rect.height) {
 			*dest = colour;
 		}
-		if (pos_x == end.x && pos_y == end.y) break;
+		if (pos_x == end_x && pos_y == end_y) break;
 
 		sum_x += step;
 		sum_y += step;
@@ -936,10 +1700,10 @@ void VideoSystem::FillRectangle(const Rectangle32 &rect, uint32 colour)
 {
 	ClippedRectangle cr = this->GetClippedRectangle();
 
-	int x = Clamp((int)rect.base.x, 0, (int)cr.width);
-	int w = Clamp((int)(rect.base.x + rect.width), 0, (int)cr.width);
-	int y = Clamp((int)rect.base.y, 0, (int)cr.height);
-	int h = Clamp((int)(rect.base.y + rect.height), 0, (int)cr.height);
+	int x = Clamp((int)rect.base.x - cr.xoffset, 0, (int)cr.width);
+	int w = Clamp((int)(rect.base.x + rect.width) - cr.xoffset, 0, (int)cr.width);
+	int y = Clamp((int)rect.base.y - cr.yoffset, 0, (int)cr.height);
+	int h = Clamp((int)(rect.base.y + rect.height) - cr.yoffset, 0, (int)cr.height);
 
 	w -= x;
 	h -= y;
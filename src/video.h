@@ -11,6 +11,10 @@
 #define VIDEO_H
 
 #include <set>
+#include <map>
+#include <list>
+#include <tuple>
+#include <vector>
 #include <SDL.h>
 #include <SDL_ttf.h>
 #include "geometry.h"
@@ -24,14 +28,18 @@ public:
 	ClippedRectangle();
 	ClippedRectangle(uint16 x, uint16 y, uint16 w, uint16 h);
 	ClippedRectangle(const ClippedRectangle &cr, uint16 x, uint16 y, uint16 w, uint16 h);
+	ClippedRectangle(uint32 *buffer, uint16 w, uint16 h);
 
 	ClippedRectangle(const ClippedRectangle &cr);
 	ClippedRectangle &operator=(const ClippedRectangle &cr);
 
 	void ValidateAddress();
+	void RestrictTo(const Rectangle32 &area);
 
 	uint16 absx;     ///< Absolute X position in the screen of the top-left.
 	uint16 absy;     ///< Absolute Y position in the screen of the top-left.
+	uint16 xoffset;  ///< Horizontal distance of the top-left from the drawing origin.
+	uint16 yoffset;  ///< Vertical distance of the top-left from the drawing origin.
 	uint16 width;    ///< Number of columns.
 	uint16 height;   ///< Number of rows.
 
@@ -39,6 +47,76 @@ public:
 	int32 pitch;     ///< Pitch of a row in bytes. @note Call #ValidateAddress prior to use.
 };
 
+/** Text rendered with the font, kept for drawing it again. */
+struct RenderedText {
+	RenderedText(const std::string &text);
+
+	std::string text; ///< Text in UTF-8 encoding.
+
+	bool has_size;    ///< Whether #size_width and #size_height are valid.
+	int size_width;   ///< Width of the text according to the font.
+	int size_height;  ///< Height of the text according to the font.
+
+	bool has_mask;          ///< Whether #mask_width, #mask_height, and #mask are valid.
+	int mask_width;         ///< Number of columns of the mask.
+	int mask_height;        ///< Number of rows of the mask.
+	std::vector<uint8> mask; ///< Coverage mask of the rendered text, non-zero pixels are part of the text.
+};
+
+/** Cache of rendered texts, the least recently used text is dropped when the cache is full. */
+class TextCache {
+public:
+	TextCache();
+
+	RenderedText *Get(const uint8 *text);
+	void Clear();
+
+	uint64 hits;   ///< Number of times the requested data was found in the cache.
+	uint64 misses; ///< Number of times the requested data had to be computed.
+
+private:
+	typedef std::list<RenderedText> TextList; ///< List of rendered texts.
+
+	TextList texts; ///< Cached texts, most recently used text at the front.
+	std::map<std::string, TextList::iterator> lookup; ///< Cached texts by their UTF-8 text.
+};
+
+/** Sprite decoded with a recolouring and a gradient shift, kept for drawing it again. */
+struct DecodedSprite {
+	DecodedSprite(const ImageData *spr, uint64 recolour_hash, GradientShift shift);
+
+	const ImageData *spr; ///< Decoded sprite.
+	uint64 recolour_hash; ///< Hash of the recolouring of the sprite, see #Recolouring::GetHash.
+	GradientShift shift;  ///< Gradient shift of the sprite.
+
+	/**
+	 * Pixels of the sprite, row by row, with their opacity. Pixels are drawn exactly like drawing the sprite itself:
+	 * fully opaque pixels are copied, and other pixels are blended with the display. Empty if the sprite cannot be decoded.
+	 */
+	std::vector<uint32> pixels;
+};
+
+/** Cache of decoded sprites, the least recently used sprites are dropped when the cache is full. */
+class SpriteCache {
+public:
+	SpriteCache();
+
+	const DecodedSprite *Get(const ImageData *spr, const Recolouring &recolour, GradientShift shift);
+	void Clear();
+
+	uint64 hits;        ///< Number of times the requested sprite was found in the cache.
+	uint64 misses;      ///< Number of times the requested sprite had to be decoded.
+	uint64 evictions;   ///< Number of sprites dropped from the cache to make room for other sprites.
+	uint32 pixel_count; ///< Number of pixels of the sprites in the cache.
+
+private:
+	typedef std::list<DecodedSprite> SpriteList; ///< List of decoded sprites.
+	typedef std::tuple<const ImageData *, uint64, GradientShift> SpriteKey; ///< Sprite, recolouring hash, and gradient shift of a decoded sprite.
+
+	SpriteList sprites; ///< Cached sprites, most recently used sprite at the front.
+	std::map<SpriteKey, SpriteList::iterator> lookup; ///< Cached sprites by their key.
+};
+
 /** How to align text during drawing. */
 enum Alignment {
 	ALG_LEFT,   ///< Align to the left edge.
@@ -88,11 +166,12 @@ public:
 	 */
 	inline bool DisplayNeedsRepaint()
 	{
-		return this->dirty;
+		return !this->dirty_areas.empty();
 	}
 
 	void MarkDisplayDirty();
 	void MarkDisplayDirty(const Rectangle32 &rect);
+	const std::vector<Rectangle32> &StartRepaint();
 
 	void SetClippedRectangle(const ClippedRectangle &cr);
 	ClippedRectangle GetClippedRectangle();
@@ -149,6 +228,31 @@ public:
 	}
 
 	void GetTextSize(const uint8 *text, int *width, int *height);
+
+	/**
+	 * Get the cache of rendered texts, for inspecting its hit and miss counts.
+	 * @return The text cache.
+	 */
+	const TextCache &GetTextCache() const
+	{
+		return this->text_cache;
+	}
+
+	/**
+	 * Get the cache of decoded sprites, for inspecting its statistics.
+	 * @return The sprite cache.
+	 */
+	const SpriteCache &GetSpriteCache() const
+	{
+		return this->sprite_cache;
+	}
+
+	/** Drop all decoded sprites from the sprite cache. */
+	void ClearSpriteCache()
+	{
+		this->sprite_cache.Clear();
+	}
+
 	void GetNumberRangeSize(int64 smallest, int64 biggest, int *width, int *height);
 	void BlitText(const uint8 *text, uint32 colour, int xpos, int ypos, int width = 0x7FFF, Alignment align = ALG_LEFT);
 	void DrawLine(const Point16 &start, const Point16 &end, uint32 colour);
@@ -156,6 +260,8 @@ public:
 	void FillRectangle(const Rectangle32 &rect, uint32 colour);
 
 	bool missing_sprites; ///< Indicates that some sprites cannot be drawn.
+	bool simd_blitting;   ///< Draw single sprites with SIMD instructions if the processor supports them.
+	bool cache_sprites;   ///< Draw single sprites from the #sprite_cache (off by default, see the 'sprite-cache' setting).
 	std::set<Point32> resolutions; ///< Set (for automatic sorting) of available resolutions.
 
 private:
@@ -163,7 +269,9 @@ private:
 	int vid_height;   ///< Height of the application window.
 	int font_height;  ///< Height of a line of text in pixels.
 	bool initialized; ///< Video system is initialized.
-	bool dirty;       ///< Video display needs being repainted.
+
+	std::vector<Rectangle32> dirty_areas;   ///< Non-overlapping areas of the display that need to be repainted.
+	std::vector<Rectangle32> repaint_areas; ///< Areas of the display being repainted.
 
 	TTF_Font *font;             ///< Opened text font.
 	SDL_Window *window;         ///< %Window of the application.
@@ -172,9 +280,10 @@ private:
 	uint32 *mem;                ///< Memory used for blitting the application display.
 	ClippedRectangle blit_rect; ///< %Rectangle to blit in.
 	Point16 digit_size;         ///< Size of largest digit (initially a zero-size).
+	TextCache text_cache;       ///< Recently rendered texts.
+	SpriteCache sprite_cache;   ///< Recently drawn sprites.
 
 	bool HandleEvent();
-	void MarkDisplayClean();
 };
 
 extern VideoSystem _video;
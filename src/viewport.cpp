@@ -24,8 +24,10 @@
 #include "person.h"
 #include "weather.h"
 #include "fence.h"
+#include "profiler.h"
 
-#include <set>
+#include <vector>
+#include <algorithm>
 
 /**
  * \page the_world_page World
@@ -94,6 +96,70 @@ static inline int32 ComputeYFunction(int32 x, int32 y, int32 z, ViewOrientation
 	}
 }
 
+/**
+ * Divide two numbers, rounding towards negative infinity.
+ * @param num Numerator.
+ * @param denom Denominator, must be positive.
+ * @return Largest integer value not bigger than \a num / \a denom.
+ */
+static inline int32 FloorDivide(int32 num, int32 denom)
+{
+	assert(denom > 0);
+	return (num >= 0) ? num / denom : -((denom - 1 - num) / denom);
+}
+
+/**
+ * Direction of the screen axes in the world, for each orientation.
+ * A voxel stack at (\c x, \c y) is displayed with its northern (displayed) corner at the
+ * world position (\c x + #world_dx, \c y + #world_dy). The horizontal screen position of that corner is
+ * <tt>column * tile_width / 2</tt> with <tt>column = col_x * x + col_y * y</tt> (using the shifted position),
+ * and the vertical screen position (at height 0) is <tt>row * tile_width / 4</tt> with <tt>row = row_x * x + row_y * y</tt>.
+ * @ingroup viewport_group
+ */
+struct ScreenAxes {
+	int8 world_dx; ///< Horizontal offset of the displayed northern corner.
+	int8 world_dy; ///< Vertical offset of the displayed northern corner.
+	int8 col_x;    ///< Contribution of the X world coordinate to the screen column.
+	int8 col_y;    ///< Contribution of the Y world coordinate to the screen column.
+	int8 row_x;    ///< Contribution of the X world coordinate to the screen row.
+	int8 row_y;    ///< Contribution of the Y world coordinate to the screen row.
+};
+
+/**
+ * Screen axes for each view orientation, matching #ComputeXFunction and #ComputeYFunction.
+ * @ingroup viewport_group
+ */
+static const ScreenAxes _screen_axes[VOR_NUM_ORIENT] = {
+	{0, 0, -1,  1,  1,  1}, // VOR_NORTH
+	{0, 1,  1,  1,  1, -1}, // VOR_EAST
+	{1, 1,  1, -1, -1, -1}, // VOR_SOUTH
+	{1, 0, -1, -1, -1,  1}, // VOR_WEST
+};
+
+/**
+ * Intersect a range of stack Y coordinates with the stacks that satisfy <tt>lower <= fx * x + fy * y <= upper</tt>.
+ * @param fx Contribution of the X coordinate (\c -1 or \c 1).
+ * @param fy Contribution of the Y coordinate (\c -1 or \c 1).
+ * @param x X coordinate (shifted to the world position of the displayed northern corner).
+ * @param dy Offset of the Y coordinate of the displayed northern corner.
+ * @param lower Lowest allowed value.
+ * @param upper Highest allowed value.
+ * @param ymin [inout] Lowest Y coordinate of the stack range.
+ * @param ymax [inout] Highest Y coordinate of the stack range.
+ */
+static inline void IntersectStackRange(int fx, int fy, int32 x, int32 dy, int32 lower, int32 upper, int32 *ymin, int32 *ymax)
+{
+	lower -= fx * x;
+	upper -= fx * x;
+	if (fy < 0) {
+		int32 tmp = lower;
+		lower = -upper;
+		upper = -tmp;
+	}
+	*ymin = std::max(*ymin, lower - dy);
+	*ymax = std::min(*ymax, upper - dy);
+}
+
 /**
  * Search the world for voxels to render.
  * @ingroup viewport_group
@@ -101,6 +167,7 @@ static inline int32 ComputeYFunction(int32 x, int32 y, int32 z, ViewOrientation
 class VoxelCollector {
 public:
 	VoxelCollector(Viewport *vp);
+	VoxelCollector(const XYZPoint32 &view_pos, ViewOrientation orient, uint16 tile_width, uint16 tile_height);
 	virtual ~VoxelCollector();
 
 	void SetWindowSize(int16 xpos, int16 ypos, uint16 width, uint16 height);
@@ -143,6 +210,14 @@ public:
 	Rectangle32 rect; ///< Screen area of interest.
 
 protected:
+	bool GetVisibleStacks(uint xpos, uint *ymin, uint *ymax) const;
+	bool IsChunkVisible(uint xpos, uint ymin, uint ymax);
+
+	int32 column_min; ///< Lowest screen column (in half tile widths) of a voxel stack that may be visible in #rect.
+	int32 column_max; ///< Highest screen column (in half tile widths) of a voxel stack that may be visible in #rect.
+	int32 row_min;    ///< Lowest screen row (in quarter tile widths, at height 0) of a voxel stack that may be visible in #rect.
+	int32 row_max;    ///< Highest screen row (in quarter tile widths, at height 0) of a voxel stack that may be visible in #rect.
+
 	/**
 	 * Decide where supports should be raised.
 	 * @param stack %Voxel stack to examine.
@@ -215,9 +290,302 @@ inline bool operator<(const DrawData &dd1, const DrawData &dd2)
 
 /**
  * Collection of sprites to render to the screen.
+ * Sprites are appended in the order of collecting, and #Sort puts them in drawing order. The sprites are first
+ * distributed over buckets, one for each slice (#DrawData::level), and then each bucket is sorted on the remaining fields.
+ * Sprites that compare equal keep the order of adding them, as with a \c std::multiset.
+ * The memory of the collection is kept between frames, so in a steady state drawing does not allocate.
+ * @ingroup viewport_group
+ */
+class DrawImages {
+public:
+	/** Remove all sprites, but keep the memory for the next frame. */
+	inline void Clear()
+	{
+		this->images.clear();
+		this->order.clear();
+	}
+
+	/**
+	 * Add a sprite to draw.
+	 * @param dd Drawing data of the sprite.
+	 */
+	inline void Add(const DrawData &dd)
+	{
+		this->images.push_back(dd);
+	}
+
+	void Sort();
+
+	/**
+	 * Get the number of sprites to draw.
+	 * @return Number of sprites in the collection.
+	 */
+	inline uint Size() const
+	{
+		return this->images.size();
+	}
+
+	/**
+	 * Get a sprite to draw.
+	 * @param index Index in drawing order.
+	 * @return The drawing data of the sprite.
+	 * @pre The collection has been sorted.
+	 */
+	inline const DrawData &Get(uint index) const
+	{
+		assert(this->order.size() == this->images.size());
+		return this->images[this->order[index]];
+	}
+
+	/**
+	 * Get a sprite to draw, without sorting.
+	 * @param index Index in order of adding.
+	 * @return The drawing data of the sprite.
+	 */
+	inline const DrawData &GetAdded(uint index) const
+	{
+		return this->images[index];
+	}
+
+private:
+	std::vector<DrawData> images; ///< Sprites in order of adding them.
+	std::vector<uint32> order;    ///< Indices in #images, in drawing order (after sorting).
+	std::vector<uint32> buckets;  ///< Start of the bucket of each slice in #order.
+};
+
+/** Put the sprites in drawing order. */
+void DrawImages::Sort()
+{
+	this->order.resize(this->images.size());
+	if (this->images.empty()) return;
+
+	int32 min_level = this->images[0].level;
+	int32 max_level = min_level;
+	for (const DrawData &dd : this->images) {
+		min_level = std::min(min_level, dd.level);
+		max_level = std::max(max_level, dd.level);
+	}
+
+	/* Count the sprites of each slice, and compute the start of each bucket. */
+	this->buckets.assign(max_level - min_level + 2, 0);
+	for (const DrawData &dd : this->images) this->buckets[dd.level - min_level + 1]++;
+	for (uint i = 1; i < this->buckets.size(); i++) this->buckets[i] += this->buckets[i - 1];
+
+	/* Distribute the sprites over the buckets, keeping their relative order. */
+	for (uint32 i = 0; i < this->images.size(); i++) {
+		this->order[this->buckets[this->images[i].level - min_level]++] = i;
+	}
+
+	/* Sort each bucket. The distribution moved the start of each bucket to the start of the next bucket. */
+	const std::vector<DrawData> &images = this->images;
+	auto compare = [&images](uint32 i1, uint32 i2) {
+		const DrawData &dd1 = images[i1];
+		const DrawData &dd2 = images[i2];
+		if (dd1.z_height != dd2.z_height) return dd1.z_height < dd2.z_height;
+		if (dd1.order != dd2.order) return dd1.order < dd2.order;
+		if (dd1.base.y != dd2.base.y) return dd1.base.y < dd2.base.y;
+		return i1 < i2; // Keep the order of adding.
+	};
+	uint32 start = 0;
+	for (uint i = 0; i < this->buckets.size() - 1; i++) {
+		uint32 end = this->buckets[i];
+		if (end - start > 1) std::sort(this->order.begin() + start, this->order.begin() + end, compare);
+		start = end;
+	}
+}
+
+static const uint MAX_INVALID_AREAS = 16; ///< Maximum number of separate out-of-date areas of a #StaticLayer.
+static const uint MAX_OBJECT_AREAS = 16;  ///< Maximum number of separate areas covered by voxel objects drawn in a frame.
+
+/**
+ * Compute the smallest rectangle containing both given rectangles.
+ * @param r1 First rectangle.
+ * @param r2 Second rectangle.
+ * @return Bounding box of both rectangles.
+ */
+static Rectangle32 GetBoundingBox(const Rectangle32 &r1, const Rectangle32 &r2)
+{
+	int32 left   = std::min(r1.base.x, r2.base.x);
+	int32 top    = std::min(r1.base.y, r2.base.y);
+	int32 right  = std::max<int32>(r1.base.x + r1.width,  r2.base.x + r2.width);
+	int32 bottom = std::max<int32>(r1.base.y + r1.height, r2.base.y + r2.height);
+	return Rectangle32(left, top, right - left, bottom - top);
+}
+
+/**
+ * Add an area to a collection of non-overlapping areas. Overlapping areas are merged into their bounding box.
+ * @param areas [inout] Collection of areas.
+ * @param area Area to add.
+ * @param max_count Maximum number of areas in the collection. When full, the new area is merged with the area that grows the least by it.
+ */
+static void AddArea(std::vector<Rectangle32> *areas, Rectangle32 area, uint max_count)
+{
+	if (area.width == 0 || area.height == 0) return;
+
+	for (;;) {
+		uint i = 0;
+		while (i < areas->size()) {
+			if (area.Intersects((*areas)[i])) {
+				area = GetBoundingBox(area, (*areas)[i]);
+				(*areas)[i] = areas->back();
+				areas->pop_back();
+				i = 0; // Merging may create new overlaps.
+			} else {
+				i++;
+			}
+		}
+		if (areas->size() < max_count) break;
+
+		uint best = 0;
+		uint64 best_growth = UINT64_MAX;
+		for (i = 0; i < areas->size(); i++) {
+			const Rectangle32 &other = (*areas)[i];
+			Rectangle32 box = GetBoundingBox(area, other);
+			uint64 growth = (uint64)box.width * box.height - (uint64)other.width * other.height;
+			if (growth < best_growth) {
+				best = i;
+				best_growth = growth;
+			}
+		}
+		area = GetBoundingBox(area, (*areas)[best]);
+		(*areas)[best] = areas->back();
+		areas->pop_back(); // The bounding box may overlap other areas, check again.
+	}
+	areas->push_back(area);
+}
+
+/**
+ * Static sprites of a viewport (everything except the voxel objects), rendered into an offscreen buffer.
+ * Only the parts of the layer changed by editing the world (see #Viewport::MarkVoxelDirty) are rendered again.
+ * Moving the viewport shifts the rendered pixels, and only the newly exposed parts are rendered.
+ * Positions of the layer are in the coordinates of #Viewport::ComputeX and #Viewport::ComputeY, so they do not change when moving the viewport.
  * @ingroup viewport_group
  */
-typedef std::multiset<DrawData> DrawImages;
+class StaticLayer {
+public:
+	StaticLayer();
+
+	/** Render the entire layer again. */
+	inline void Invalidate()
+	{
+		this->all_invalid = true;
+		this->invalid_areas.clear();
+	}
+
+	/**
+	 * Render a part of the layer again.
+	 * @param area Part of the layer to render.
+	 */
+	inline void Invalidate(const Rectangle32 &area)
+	{
+		if (!this->all_invalid) AddArea(&this->invalid_areas, area, MAX_INVALID_AREAS);
+	}
+
+	void SetView(const Point32 &origin, uint16 width, uint16 height, ViewOrientation orientation, uint16 tile_width, bool underground_mode, GradientShift shift);
+	void GetInvalidAreas(std::vector<Rectangle32> *areas);
+
+	std::vector<uint32> pixels; ///< Rendered pixels of the layer, row by row.
+	uint16 width;               ///< Number of columns of the layer.
+	uint16 height;              ///< Number of rows of the layer.
+
+private:
+	Point32 origin;              ///< Position of the top-left pixel of the layer.
+	ViewOrientation orientation; ///< Direction of view of the rendered layer.
+	uint16 tile_width;           ///< Tile width of the rendered layer.
+	bool underground_mode;       ///< Whether the layer is rendered in underground mode.
+	GradientShift shift;         ///< Weather shading of the rendered layer.
+
+	bool all_invalid;                       ///< Whether the entire layer must be rendered again.
+	std::vector<Rectangle32> invalid_areas; ///< Parts of the layer to render again.
+};
+
+StaticLayer::StaticLayer()
+{
+	this->width = 0;
+	this->height = 0;
+	this->orientation = VOR_NORTH;
+	this->tile_width = 0;
+	this->underground_mode = false;
+	this->shift = GS_NORMAL;
+	this->all_invalid = true;
+}
+
+/**
+ * Set the view displayed by the layer. Changing the view invalidates the layer, except for a move where the rendered pixels are shifted.
+ * @param origin Position of the top-left pixel of the viewport.
+ * @param width Width of the viewport.
+ * @param height Height of the viewport.
+ * @param orientation Direction of view.
+ * @param tile_width Width of a tile.
+ * @param underground_mode Whether underground mode is displayed.
+ * @param shift Weather shading.
+ */
+void StaticLayer::SetView(const Point32 &origin, uint16 width, uint16 height, ViewOrientation orientation, uint16 tile_width, bool underground_mode, GradientShift shift)
+{
+	if (width != this->width || height != this->height || orientation != this->orientation || tile_width != this->tile_width ||
+			underground_mode != this->underground_mode || shift != this->shift) {
+		this->pixels.resize(width * height);
+		this->width = width;
+		this->height = height;
+		this->origin = origin;
+		this->orientation = orientation;
+		this->tile_width = tile_width;
+		this->underground_mode = underground_mode;
+		this->shift = shift;
+		this->Invalidate();
+		return;
+	}
+
+	int32 dx = this->origin.x - origin.x;
+	int32 dy = this->origin.y - origin.y;
+	this->origin = origin;
+	if (dx == 0 && dy == 0) return;
+	if (abs(dx) >= width || abs(dy) >= height) {
+		this->Invalidate();
+		return;
+	}
+
+	/* Move the pixels that stay visible, rows are copied in the order that does not overwrite rows still to be copied. */
+	int32 count = width - abs(dx);
+	int32 src_x = std::max(-dx, 0);
+	int32 dst_x = std::max(dx, 0);
+	if (dy > 0) {
+		for (int32 y = height - 1; y >= dy; y--) {
+			memmove(&this->pixels[y * width + dst_x], &this->pixels[(y - dy) * width + src_x], count * sizeof(uint32));
+		}
+	} else {
+		for (int32 y = 0; y < height + dy; y++) {
+			memmove(&this->pixels[y * width + dst_x], &this->pixels[(y - dy) * width + src_x], count * sizeof(uint32));
+		}
+	}
+
+	/* Render the newly exposed columns and rows. */
+	if (dx > 0) this->Invalidate(Rectangle32(origin.x, origin.y, dx, height));
+	if (dx < 0) this->Invalidate(Rectangle32(origin.x + width + dx, origin.y, -dx, height));
+	if (dy > 0) this->Invalidate(Rectangle32(origin.x, origin.y, width, dy));
+	if (dy < 0) this->Invalidate(Rectangle32(origin.x, origin.y + height + dy, width, -dy));
+}
+
+/**
+ * Get the parts of the layer to render again, and consider them rendered.
+ * @param areas [out] Parts of the layer to render, relative to the top-left of the layer.
+ */
+void StaticLayer::GetInvalidAreas(std::vector<Rectangle32> *areas)
+{
+	areas->clear();
+	if (this->all_invalid) {
+		areas->emplace_back(0, 0, this->width, this->height);
+	} else {
+		for (Rectangle32 area : this->invalid_areas) {
+			area.base.x -= this->origin.x;
+			area.base.y -= this->origin.y;
+			area.RestrictTo(0, 0, this->width, this->height);
+			if (area.width != 0 && area.height != 0) areas->push_back(area);
+		}
+	}
+	this->all_invalid = false;
+	this->invalid_areas.clear();
+}
 
 /**
  * Collect sprites to draw in a viewport.
@@ -225,17 +593,21 @@ typedef std::multiset<DrawData> DrawImages;
  */
 class SpriteCollector : public VoxelCollector {
 public:
-	SpriteCollector(Viewport *vp);
+	SpriteCollector(Viewport *vp, DrawImages *draw_images);
+	SpriteCollector(const XYZPoint32 &view_pos, ViewOrientation orient, uint16 tile_width, uint16 tile_height, DrawImages *draw_images);
 	~SpriteCollector();
 
 	void SetXYOffset(int16 xoffset, int16 yoffset);
 
-	DrawImages draw_images; ///< Sprites to draw ordered by viewing distance.
+	DrawImages *draw_images; ///< Sprites to draw, ordered by viewing distance after sorting.
 	int16 xoffset; ///< Horizontal offset of the top-left coordinate to the top-left of the display.
 	int16 yoffset; ///< Vertical offset of the top-left coordinate to the top-left of the display.
+	SpriteSelection selection; ///< Sprites to collect.
 
 protected:
+	void Initialize(DrawImages *draw_images);
 	void CollectVoxel(const Voxel *vx, const XYZPoint16 &voxel_pos, int32 xnorth, int32 ynorth) override;
+	void CollectVoxelObjects(const Voxel *vx, const XYZPoint16 &voxel_pos, int32 slice, const Point32 &north_point);
 	void SetupSupports(const VoxelStack *stack, uint xpos, uint ypos) override;
 	const ImageData *GetCursorSpriteAtPos(CursorType ctype, const XYZPoint16 &voxel_pos, uint8 tslope);
 
@@ -284,6 +656,27 @@ VoxelCollector::VoxelCollector(Viewport *vp)
 	assert(this->sprites != nullptr);
 }
 
+/**
+ * Constructor of a collector without a viewport. It does not show the cursors, and not the underground mode.
+ * @param view_pos Position of the centre point of the display.
+ * @param orient Direction of view.
+ * @param tile_width Width of a tile.
+ * @param tile_height Height of a tile.
+ */
+VoxelCollector::VoxelCollector(const XYZPoint32 &view_pos, ViewOrientation orient, uint16 tile_width, uint16 tile_height)
+{
+	this->vp = nullptr;
+	this->selector = nullptr;
+	this->view_pos = view_pos;
+	this->tile_width = tile_width;
+	this->tile_height = tile_height;
+	this->orient = orient;
+	this->underground_mode = false;
+
+	this->sprites = _sprite_manager.GetSprites(this->tile_width);
+	assert(this->sprites != nullptr);
+}
+
 /* Destructor. */
 VoxelCollector::~VoxelCollector()
 {
@@ -302,6 +695,63 @@ void VoxelCollector::SetWindowSize(int16 xpos, int16 ypos, uint16 width, uint16
 	this->rect.base.y = this->ComputeY(this->view_pos.x, this->view_pos.y, this->view_pos.z) + ypos;
 	this->rect.width = width;
 	this->rect.height = height;
+
+	/* Compute the columns and rows of the voxel stacks that may have a voxel in the area.
+	 * The bounds are slightly conservative, #Collect performs the exact checks. */
+	int32 right = this->rect.base.x + this->rect.width;
+	int32 bottom = this->rect.base.y + this->rect.height;
+	this->column_min = FloorDivide(2 * this->rect.base.x, this->tile_width) - 1;
+	this->column_max = FloorDivide(2 * right, this->tile_width) + 2;
+	this->row_min = FloorDivide(4 * (this->rect.base.y - this->tile_width / 2 - this->tile_height), this->tile_width) - 1;
+	this->row_max = FloorDivide(4 * (bottom + (WORLD_Z_SIZE + 1) * this->tile_height), this->tile_width) + 2;
+}
+
+/**
+ * Get the range of voxel stacks in a row of the world that may be visible in the screen area of interest.
+ * @param xpos X coordinate of the row of voxel stacks.
+ * @param ymin [out] Lowest Y coordinate of a voxel stack that may be visible.
+ * @param ymax [out] Highest Y coordinate of a voxel stack that may be visible.
+ * @return Whether any voxel stack in the row may be visible.
+ * @pre #SetWindowSize has been called.
+ */
+bool VoxelCollector::GetVisibleStacks(uint xpos, uint *ymin, uint *ymax) const
+{
+	const ScreenAxes &axes = _screen_axes[this->orient];
+	int32 x = xpos + axes.world_dx;
+	int32 low = 0;
+	int32 high = _world.GetYSize() - 1;
+	IntersectStackRange(axes.col_x, axes.col_y, x, axes.world_dy, this->column_min, this->column_max, &low, &high);
+	IntersectStackRange(axes.row_x, axes.row_y, x, axes.world_dy, this->row_min, this->row_max, &low, &high);
+	if (low > high) return false;
+
+	*ymin = low;
+	*ymax = high;
+	return true;
+}
+
+/**
+ * Can a part of a row of voxel stacks inside one chunk of the world be visible in the screen area of interest?
+ * Only the range of heights of the chunk is used, the voxel stacks themselves are not examined.
+ * @param xpos X coordinate of the row of voxel stacks.
+ * @param ymin Lowest Y coordinate of the voxel stacks.
+ * @param ymax Highest Y coordinate of the voxel stacks, in the same chunk as \a ymin.
+ * @return Whether a voxel of the stacks may be visible.
+ */
+bool VoxelCollector::IsChunkVisible(uint xpos, uint ymin, uint ymax)
+{
+	const VoxelChunk *chunk = _world.GetChunk(xpos, ymin);
+	if (chunk == nullptr || !chunk->HasVoxels()) return false;
+
+	/* The screen position changes linearly along the row, so the voxels at the ends of the row are the extremes. */
+	int32 world_x = (xpos + ((this->orient == VOR_SOUTH || this->orient == VOR_WEST) ? 1 : 0)) * 256;
+	int32 dy = (this->orient == VOR_SOUTH || this->orient == VOR_EAST) ? 1 : 0;
+	int32 first_y = (ymin + dy) * 256;
+	int32 last_y = (ymax + dy) * 256;
+	int32 top = std::min(this->ComputeY(world_x, first_y, chunk->max_z * 256), this->ComputeY(world_x, last_y, chunk->max_z * 256));
+	int32 bottom = std::max(this->ComputeY(world_x, first_y, chunk->min_z * 256), this->ComputeY(world_x, last_y, chunk->min_z * 256));
+	if (top - this->tile_height >= (int32)(this->rect.base.y + this->rect.height)) return false; // All voxels are below the window.
+	if (bottom + this->tile_width / 2 + this->tile_height <= (int32)this->rect.base.y) return false; // All voxels are above the window.
+	return true;
 }
 
 /**
@@ -317,13 +767,26 @@ void VoxelCollector::SetSelector(MouseModeSelector *selector)
  * Perform the collecting cycle.
  * This part walks over the voxels, and call #CollectVoxel for each useful voxel.
  * A derived class may then inspect the voxel in more detail.
- * @todo Do this less stupid. Walking the whole world is not going to work in general.
+ * Only the voxel stacks that may be visible in #rect are examined, so the cost depends on the size of the area rather than the size of the world.
+ * Without a selector, parts of the world without voxels or outside the range of heights of their chunk are skipped.
  */
 void VoxelCollector::Collect()
 {
 	for (uint xpos = 0; xpos < _world.GetXSize(); xpos++) {
+		uint ymin, ymax;
+		if (!this->GetVisibleStacks(xpos, &ymin, &ymax)) continue;
+
 		int32 world_x = (xpos + ((this->orient == VOR_SOUTH || this->orient == VOR_WEST) ? 1 : 0)) * 256;
-		for (uint ypos = 0; ypos < _world.GetYSize(); ypos++) {
+		for (uint ypos = ymin; ypos <= ymax; ypos++) {
+			/* Without a selector, only voxels of the world are drawn, skip the chunks that cannot have a visible voxel. */
+			if (this->selector == nullptr && (ypos == ymin || (ypos & WORLD_CHUNK_MASK) == 0)) {
+				uint chunk_ymax = std::min<uint>(ypos | WORLD_CHUNK_MASK, ymax);
+				if (!this->IsChunkVisible(xpos, ypos, chunk_ymax)) {
+					ypos = chunk_ymax;
+					continue;
+				}
+			}
+
 			int32 world_y = (ypos + ((this->orient == VOR_SOUTH || this->orient == VOR_EAST) ? 1 : 0)) * 256;
 			int32 north_x = ComputeX(world_x, world_y);
 			if (north_x + this->tile_width / 2 <= (int32)this->rect.base.x) continue; // Right of voxel column is at left of window.
@@ -344,10 +807,15 @@ void VoxelCollector::Collect()
 			}
 			this->SetupSupports(stack, xpos, ypos);
 
+			/* Supports of a path or platform are drawn down to the ground of the stack, which is at or above the base of the stack.
+			 * While the base is not above the window, voxels above the window may still have supports inside it. */
+			int32 base_y = this->ComputeY(world_x, world_y, stack->base * 256);
+			bool supports_visible = base_y + this->tile_width / 2 + this->tile_height > (int32)this->rect.base.y;
+
 			for (; zpos <= top; zpos++) {
 				int32 north_y = this->ComputeY(world_x, world_y, zpos * 256);
 				if (north_y - this->tile_height >= (int32)(this->rect.base.y + this->rect.height)) continue; // Voxel is below the window.
-				if (north_y + this->tile_width / 2 + this->tile_height <= (int32)this->rect.base.y) break; // Above the window and rising!
+				if (north_y + this->tile_width / 2 + this->tile_height <= (int32)this->rect.base.y && !supports_visible) break; // Above the window and rising!
 
 				int count = zpos - stack->base;
 				const Voxel *voxel = (count >= 0 && count < stack->height) ? &stack->voxels[count] : nullptr;
@@ -360,12 +828,38 @@ void VoxelCollector::Collect()
 /**
  * Constructor of sprites collector.
  * @param vp %Viewport that needs the sprites.
+ * @param draw_images Storage of the collected sprites.
+ */
+SpriteCollector::SpriteCollector(Viewport *vp, DrawImages *draw_images) : VoxelCollector(vp)
+{
+	this->Initialize(draw_images);
+}
+
+/**
+ * Constructor of a sprite collector without a viewport.
+ * @param view_pos Position of the centre point of the display.
+ * @param orient Direction of view.
+ * @param tile_width Width of a tile.
+ * @param tile_height Height of a tile.
+ * @param draw_images [out] Storage of the collected sprites.
+ */
+SpriteCollector::SpriteCollector(const XYZPoint32 &view_pos, ViewOrientation orient, uint16 tile_width, uint16 tile_height, DrawImages *draw_images)
+		: VoxelCollector(view_pos, orient, tile_width, tile_height)
+{
+	this->Initialize(draw_images);
+}
+
+/**
+ * Initialize the sprite collector, after setting up the view.
+ * @param draw_images [out] Storage of the collected sprites.
  */
-SpriteCollector::SpriteCollector(Viewport *vp) : VoxelCollector(vp)
+void SpriteCollector::Initialize(DrawImages *draw_images)
 {
-	this->draw_images.clear();
+	this->draw_images = draw_images;
+	this->draw_images->Clear();
 	this->xoffset = 0;
 	this->yoffset = 0;
+	this->selection = SPS_ALL;
 
 	this->north_offsets[VOR_NORTH].x = 0;                     this->north_offsets[VOR_NORTH].y = 0;
 	this->north_offsets[VOR_EAST].x  = -this->tile_width / 2; this->north_offsets[VOR_EAST].y  = this->tile_width / 4;
@@ -489,6 +983,10 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 	}
 
 	Point32 north_point(this->xoffset + xnorth - this->rect.base.x, this->yoffset + ynorth - this->rect.base.y);
+	if ((this->selection & SPS_STATIC) == 0) {
+		this->CollectVoxelObjects(voxel, voxel_pos, slice, north_point);
+		return;
+	}
 
 	uint8 platform_shape = PATH_INVALID;
 	SmallRideInstance sri = (voxel == nullptr) ? SRI_FREE : voxel->GetInstance();
@@ -500,13 +998,13 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 		DrawData dd;
 		dd.Set(slice, voxel_pos.z, SO_PATH, this->sprites->GetPathSprite(GetPathType(instance_data), GetImplodedPathSlope(instance_data), this->orient),
 				north_point, nullptr, highlight);
-		this->draw_images.insert(dd);
+		this->draw_images->Add(dd);
 	} else if (sri >= SRI_FULL_RIDES) { // A normal ride.
 		DrawData dd[4];
 		int count = DrawRide(slice, voxel_pos.z, north_point, this->orient, sri, instance_data, dd, &platform_shape);
 		for (int i = 0; i < count; i++) {
 			dd[i].highlight = highlight;
-			this->draw_images.insert(dd[i]);
+			this->draw_images->Add(dd[i]);
 		}
 	}
 
@@ -527,7 +1025,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 			if (img != nullptr) {
 				DrawData dd;
 				dd.Set(slice, voxel_pos.z, SO_FOUNDATION, img, north_point);
-				this->draw_images.insert(dd);
+				this->draw_images->Add(dd);
 			}
 		}
 		if (se != 0) {
@@ -535,7 +1033,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 			if (img != nullptr) {
 				DrawData dd;
 				dd.Set(slice, voxel_pos.z, SO_FOUNDATION, img, north_point);
-				this->draw_images.insert(dd);
+				this->draw_images->Add(dd);
 			}
 		}
 	}
@@ -547,7 +1045,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 		uint8 type = (this->underground_mode) ? GTP_UNDERGROUND : voxel->GetGroundType();
 		DrawData dd;
 		dd.Set(slice, voxel_pos.z, SO_GROUND, this->sprites->GetSurfaceSprite(type, slope, this->orient), north_point);
-		this->draw_images.insert(dd);
+		this->draw_images->Add(dd);
 		switch (slope) {
 			// XXX There are no sprites for partial support of a platform.
 			case SL_FLAT:
@@ -590,7 +1088,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 						this->sprites->GetFenceSprite(fence_type, edge, gslope, this->orient), north_point);
 				if (IsImplodedSteepSlope(gslope) && !IsImplodedSteepSlopeTop(gslope)) dd.z_height++;
 				if (GB(fences, 16 + edge, 1) != 0) dd.highlight = true;
-				this->draw_images.insert(dd);
+				this->draw_images->Add(dd);
 			}
 		}
 	}
@@ -604,7 +1102,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 				DrawData dd;
 				dd.Set(slice, voxel_pos.z, SO_CURSOR, mspr, north_point);
 				if (ctype >= CUR_TYPE_EDGE_NE && ctype <= CUR_TYPE_EDGE_NW && IsImplodedSteepSlope(gslope) && !IsImplodedSteepSlopeTop(gslope)) dd.z_height++;
-				this->draw_images.insert(dd);
+				this->draw_images->Add(dd);
 			}
 		}
 	}
@@ -623,7 +1121,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 		if (pl_spr != nullptr) {
 			DrawData dd;
 			dd.Set(slice, voxel_pos.z, SO_PLATFORM, pl_spr, north_point);
-			this->draw_images.insert(dd);
+			this->draw_images->Add(dd);
 		}
 
 		/* XXX Use the shape to draw handle bars. */
@@ -633,7 +1131,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 		this->ground_height = -1;
 		uint8 slope = this->ground_slope;
 		while (height < voxel_pos.z) {
-			int yoffset = (voxel_pos.z - height) * this->vp->tile_height; // Compensate y position of support.
+			int yoffset = (voxel_pos.z - height) * this->tile_height; // Compensate y position of support.
 			uint sprnum;
 			if (slope == SL_FLAT) {
 				if (height + 1 < voxel_pos.z) {
@@ -657,13 +1155,24 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 			if (img != nullptr) {
 				DrawData dd;
 				dd.Set(slice, height, SO_SUPPORT, img, Point32(north_point.x, north_point.y + yoffset));
-				this->draw_images.insert(dd);
+				this->draw_images->Add(dd);
 			}
 		}
 	}
 
-	/* Add voxel objects (persons, ride cars, etc). */
-	const VoxelObject *vo = (voxel == nullptr) ? nullptr : voxel->voxel_objects;
+	if ((this->selection & SPS_OBJECTS) != 0) this->CollectVoxelObjects(voxel, voxel_pos, slice, north_point);
+}
+
+/**
+ * Add the voxel objects (persons, ride cars, etc) of a voxel to the set of sprites to draw.
+ * @param voxel %Voxel to add, \c nullptr means 'cursor above stack'.
+ * @param voxel_pos World position.
+ * @param slice Depth of the voxel.
+ * @param north_point Position of the north corner of the voxel at the display.
+ */
+void SpriteCollector::CollectVoxelObjects(const Voxel *voxel, const XYZPoint16 &voxel_pos, int32 slice, const Point32 &north_point)
+{
+	const VoxelObject *vo = (voxel == nullptr) ? nullptr : _world.GetVoxelObjects(voxel_pos);
 	while (vo != nullptr) {
 		const Recolouring *recolour;
 		const ImageData *anim_spr = vo->GetSprite(this->sprites, this->orient, &recolour);
@@ -674,7 +1183,7 @@ void SpriteCollector::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_p
 			            north_point.y + this->north_offsets[this->orient].y + y_off);
 			DrawData dd;
 			dd.Set(slice, voxel_pos.z, SO_PERSON, anim_spr, pos, recolour);
-			this->draw_images.insert(dd);
+			this->draw_images->Add(dd);
 		}
 		vo = vo->next_object;
 	}
@@ -806,7 +1315,7 @@ void PixelFinder::CollectVoxel(const Voxel *voxel, const XYZPoint16 &voxel_pos,
 		}
 	} else if ((this->allowed & CS_PERSON) != 0) {
 		/* Looking for persons? */
-		const VoxelObject *vo = voxel->voxel_objects;
+		const VoxelObject *vo = _world.GetVoxelObjects(voxel_pos);
 		while (vo != nullptr) {
 			const Person *pers = static_cast<const Person *>(vo);
 			assert(pers != nullptr && pers->walk != nullptr);
@@ -845,6 +1354,10 @@ Viewport::Viewport(const XYZPoint32 &view_pos) : Window(WC_MAINDISPLAY, ALL_WIND
 	this->mouse_pos.x = 0;
 	this->mouse_pos.y = 0;
 	this->underground_mode = false;
+	this->draw_images = new DrawImages;
+	this->object_images = new DrawImages;
+	this->weather_shift = GS_NORMAL;
+	this->static_layer = new StaticLayer;
 
 	uint16 width  = _video.GetXSize();
 	uint16 height = _video.GetYSize();
@@ -856,6 +1369,9 @@ Viewport::Viewport(const XYZPoint32 &view_pos) : Window(WC_MAINDISPLAY, ALL_WIND
 
 Viewport::~Viewport()
 {
+	delete this->draw_images;
+	delete this->object_images;
+	delete this->static_layer;
 }
 
 /**
@@ -910,37 +1426,254 @@ int32 Viewport::ComputeY(int32 xpos, int32 ypos, int32 zpos)
 	return ComputeYFunction(xpos, ypos, zpos, this->orientation, this->tile_width, this->tile_height);
 }
 
-void Viewport::OnDraw(MouseModeSelector *selector)
+/**
+ * Collect the sprites to draw in a part of the viewport.
+ * @param area Part of the viewport, with its drawing origin at the top-left of the viewport.
+ * @param selector Mouse mode selector to render with, or \c nullptr.
+ * @param selection Sprites to collect.
+ * @param images [out] Storage of the collected sprites, not sorted yet.
+ */
+void Viewport::CollectSprites(const ClippedRectangle &area, MouseModeSelector *selector, SpriteSelection selection, DrawImages *images)
 {
-	SpriteCollector collector(this);
-	collector.SetWindowSize(-(int16)this->rect.width / 2, -(int16)this->rect.height / 2, this->rect.width, this->rect.height);
+	/* Only collect sprites for the part of the viewport being drawn, with a margin for sprites sticking out of their voxel.
+	 * Supports reaching down from elevated voxels into the area are found by #VoxelCollector::Collect itself. */
+	int16 xpos = area.xoffset - this->tile_width;
+	int16 ypos = area.yoffset - this->tile_width;
+	SpriteCollector collector(this, images);
+	collector.SetWindowSize(-(int16)this->rect.width / 2 + xpos, -(int16)this->rect.height / 2 + ypos,
+			area.width + 2 * this->tile_width, area.height + 2 * this->tile_width);
+	collector.SetXYOffset(xpos, ypos);
 	collector.SetSelector(selector);
+	collector.selection = selection;
+
+	ProfileTimer timer(PFP_COLLECT);
 	collector.Collect();
-	static const Recolouring recolour;
+}
+
+/** Put the collected sprites in drawing order. */
+void Viewport::SortSprites()
+{
+	ProfileTimer timer(PFP_SORT);
+	this->draw_images->Sort();
+}
 
-	_video.FillRectangle(this->rect, MakeRGBA(0, 0, 0, OPAQUE)); // Black background.
+/**
+ * Get the area of the viewport covered by a sprite.
+ * @param dd Sprite to examine.
+ * @return The area covered by the sprite, relative to the top-left of the viewport.
+ */
+static inline Rectangle32 GetSpriteArea(const DrawData &dd)
+{
+	return Rectangle32(dd.base.x + dd.sprite->xoffset, dd.base.y + dd.sprite->yoffset, dd.sprite->width, dd.sprite->height);
+}
+
+/**
+ * Add the collected voxel objects that cover a part of the viewport to the sprites to draw.
+ * @param area Part of the viewport, relative to the top-left of the viewport.
+ */
+void Viewport::AddObjectSprites(const Rectangle32 &area)
+{
+	ProfileTimer timer(PFP_COLLECT);
+	for (uint i = 0; i < this->object_images->Size(); i++) {
+		const DrawData &dd = this->object_images->GetAdded(i);
+		if (area.Intersects(GetSpriteArea(dd))) this->draw_images->Add(dd);
+	}
+}
+
+/**
+ * Render the parts of the static layer that are out of date.
+ * @param gs Weather shading of the viewport.
+ */
+void Viewport::UpdateStaticLayer(GradientShift gs)
+{
+	int32 left = this->ComputeX(this->view_pos.x, this->view_pos.y) - this->rect.width / 2;
+	int32 top = this->ComputeY(this->view_pos.x, this->view_pos.y, this->view_pos.z) - this->rect.height / 2;
+	this->static_layer->SetView(Point32(left, top), this->rect.width, this->rect.height, this->orientation, this->tile_width, this->underground_mode, gs);
+	this->static_layer->GetInvalidAreas(&this->static_areas);
 
+	static const Recolouring recolour;
+	for (const Rectangle32 &area : this->static_areas) {
+		ClippedRectangle layer_rect(this->static_layer->pixels.data(), this->static_layer->width, this->static_layer->height);
+		layer_rect.RestrictTo(area);
+		this->CollectSprites(layer_rect, nullptr, SPS_STATIC, this->draw_images);
+		this->SortSprites();
+
+		ProfileTimer timer(PFP_BLIT);
+		_video.SetClippedRectangle(layer_rect);
+		_video.FillRectangle(area, MakeRGBA(0, 0, 0, OPAQUE)); // Black background.
+		for (uint i = 0; i < this->draw_images->Size(); i++) {
+			const DrawData &dd = this->draw_images->Get(i);
+			const Recolouring &rec = (dd.recolour == nullptr) ? recolour : *dd.recolour;
+			_video.BlitImage(dd.base, dd.sprite, rec, gs);
+		}
+	}
+}
+
+void Viewport::OnDraw(MouseModeSelector *selector)
+{
 	ClippedRectangle cr = _video.GetClippedRectangle();
 	assert(this->rect.base.x >= 0 && this->rect.base.y >= 0);
 	ClippedRectangle draw_rect(cr, this->rect.base.x, this->rect.base.y, this->rect.width, this->rect.height);
-	_video.SetClippedRectangle(draw_rect);
+	if (draw_rect.width == 0 || draw_rect.height == 0) return;
 
+	/* A change in weather changes the shading of the entire viewport. */
 	GradientShift gs = static_cast<GradientShift>(GS_LIGHT - _weather.GetWeatherType());
-	for (const auto &iter : collector.draw_images) {
-		const DrawData &dd = iter;
-		const Recolouring &rec = (dd.recolour == nullptr) ? recolour : *dd.recolour;
-		_video.BlitImage(dd.base, dd.sprite, rec, dd.highlight ? GS_SEMI_TRANSPARENT : gs);
+	if (gs != this->weather_shift) {
+		this->weather_shift = gs;
+		if (draw_rect.width != this->rect.width || draw_rect.height != this->rect.height) this->MarkDirty();
+	}
+
+	static const Recolouring recolour;
+	if (selector != nullptr) {
+		/* The selector changes the displayed world, draw all sprites without using the static layer. */
+		_video.FillRectangle(this->rect, MakeRGBA(0, 0, 0, OPAQUE)); // Black background.
+		this->CollectSprites(draw_rect, selector, SPS_ALL, this->draw_images);
+		this->SortSprites();
+
+		ProfileTimer timer(PFP_BLIT);
+		_video.SetClippedRectangle(draw_rect);
+		for (uint i = 0; i < this->draw_images->Size(); i++) {
+			const DrawData &dd = this->draw_images->Get(i);
+			const Recolouring &rec = (dd.recolour == nullptr) ? recolour : *dd.recolour;
+			_video.BlitImage(dd.base, dd.sprite, rec, dd.highlight ? GS_SEMI_TRANSPARENT : gs);
+		}
+		_video.SetClippedRectangle(cr);
+		return;
+	}
+
+	this->UpdateStaticLayer(gs);
+	this->CollectSprites(draw_rect, nullptr, SPS_OBJECTS, this->object_images);
+
+	{
+		ProfileTimer timer(PFP_BLIT);
+		_video.SetClippedRectangle(draw_rect);
+		draw_rect = _video.GetClippedRectangle();
+
+		/* Copy the static layer to the display. */
+		const uint32 *src = this->static_layer->pixels.data() + draw_rect.xoffset + draw_rect.yoffset * this->static_layer->width;
+		uint32 *dest = draw_rect.address;
+		for (uint16 y = 0; y < draw_rect.height; y++) {
+			memcpy(dest, src, draw_rect.width * sizeof(uint32));
+			src += this->static_layer->width;
+			dest += draw_rect.pitch;
+		}
+	}
+
+	/* Draw the areas covered by voxel objects again, with all sprites, so static sprites in front of the objects stay in front. */
+	this->object_areas.clear();
+	Rectangle32 visible(draw_rect.xoffset, draw_rect.yoffset, draw_rect.width, draw_rect.height);
+	for (uint i = 0; i < this->object_images->Size(); i++) {
+		Rectangle32 area = GetSpriteArea(this->object_images->GetAdded(i));
+		area.RestrictTo(visible);
+		AddArea(&this->object_areas, area, MAX_OBJECT_AREAS);
+	}
+
+	/* Collect the static sprites of each area separately, unless the areas (with the collect margin) cover more than the viewport. */
+	uint64 collect_size = 0;
+	for (const Rectangle32 &area : this->object_areas) {
+		collect_size += (uint64)(area.width + 2 * this->tile_width) * (area.height + 2 * this->tile_width);
+	}
+	bool collect_once = collect_size >= (uint64)draw_rect.width * draw_rect.height;
+	if (collect_once && !this->object_areas.empty()) {
+		this->CollectSprites(draw_rect, nullptr, SPS_STATIC, this->draw_images);
+		this->AddObjectSprites(visible);
+		this->SortSprites();
+	}
+
+	for (const Rectangle32 &area : this->object_areas) {
+		ClippedRectangle object_rect(draw_rect);
+		object_rect.RestrictTo(area);
+		if (!collect_once) {
+			this->CollectSprites(object_rect, nullptr, SPS_STATIC, this->draw_images);
+			this->AddObjectSprites(area);
+			this->SortSprites();
+		}
+
+		ProfileTimer timer(PFP_BLIT);
+		_video.SetClippedRectangle(object_rect);
+		_video.FillRectangle(area, MakeRGBA(0, 0, 0, OPAQUE)); // Black background.
+		for (uint i = 0; i < this->draw_images->Size(); i++) {
+			const DrawData &dd = this->draw_images->Get(i);
+			if (collect_once && !area.Intersects(GetSpriteArea(dd))) continue;
+			const Recolouring &rec = (dd.recolour == nullptr) ? recolour : *dd.recolour;
+			_video.BlitImage(dd.base, dd.sprite, rec, gs);
+		}
 	}
 
 	_video.SetClippedRectangle(cr);
 }
 
+ViewSprites::ViewSprites()
+{
+	this->images = new DrawImages;
+}
+
+ViewSprites::~ViewSprites()
+{
+	delete this->images;
+}
+
 /**
- * Mark a voxel as in need of getting painted.
+ * Collect the sprites of a view of the world, the same way as a viewport collects them for drawing all its sprites.
+ * @param view_pos Position of the centre point of the view.
+ * @param orient Direction of view.
+ * @param width Width of the view.
+ * @param height Height of the view.
+ * @param selection Sprites to collect.
+ */
+void ViewSprites::Collect(const XYZPoint32 &view_pos, ViewOrientation orient, uint16 width, uint16 height, SpriteSelection selection)
+{
+	const uint16 tile_width = 64;
+	const uint16 tile_height = 16;
+	int16 xpos = -tile_width;
+	int16 ypos = -tile_width;
+	SpriteCollector collector(view_pos, orient, tile_width, tile_height, this->images);
+	collector.SetWindowSize(-(int16)width / 2 + xpos, -(int16)height / 2 + ypos, width + 2 * tile_width, height + 2 * tile_width);
+	collector.SetXYOffset(xpos, ypos);
+	collector.selection = selection;
+	collector.Collect();
+}
+
+/** Put the collected sprites in drawing order. */
+void ViewSprites::Sort()
+{
+	this->images->Sort();
+}
+
+/**
+ * Get the number of collected sprites.
+ * @return Number of sprites of the view.
+ */
+uint ViewSprites::Size() const
+{
+	return this->images->Size();
+}
+
+/**
+ * Compute a hash of the sorted sprites, to compare drawing orders.
+ * @return Hash of the positions and sorting fields of the sprites, in drawing order.
+ * @pre The sprites have been sorted.
+ */
+uint32 ViewSprites::GetOrderHash() const
+{
+	uint32 hash = 2166136261u; // FNV-1a.
+	for (uint i = 0; i < this->images->Size(); i++) {
+		const DrawData &dd = this->images->Get(i);
+		const int32 values[] = {dd.level, dd.z_height, dd.order, dd.base.x, dd.base.y, dd.sprite->width, dd.sprite->height};
+		for (int32 value : values) {
+			hash = (hash ^ (uint32)value) * 16777619u;
+		}
+	}
+	return hash;
+}
+
+/**
+ * Compute the area of the display covered by a voxel.
  * @param voxel_pos Position of the voxel.
- * @param height Number of voxels to mark above the specified coordinate (\c 0 means inspect the voxel itself).
+ * @param height Number of voxels to include above the specified coordinate (\c 0 means inspect the voxel itself).
+ * @return The area covered by the voxel, in the coordinates of #ComputeX and #ComputeY.
  */
-void Viewport::MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height)
+Rectangle32 Viewport::GetVoxelArea(const XYZPoint16 &voxel_pos, int16 height)
 {
 	if (height <= 0) {
 		const Voxel *v = _world.GetVoxel(voxel_pos);
@@ -973,26 +1706,61 @@ void Viewport::MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height)
 	Rectangle32 rect;
 	const Point16 *pt;
 
-	int32 center_x = this->ComputeX(this->view_pos.x, this->view_pos.y) - this->rect.base.x - this->rect.width / 2;
-	int32 center_y = this->ComputeY(this->view_pos.x, this->view_pos.y, this->view_pos.z) - this->rect.base.y - this->rect.height / 2;
-
 	pt = &_corner_dxy[this->orientation];
-	rect.base.y = this->ComputeY((voxel_pos.x + pt->x) * 256, (voxel_pos.y + pt->y) * 256, (voxel_pos.z + height) * 256) - center_y;
+	rect.base.y = this->ComputeY((voxel_pos.x + pt->x) * 256, (voxel_pos.y + pt->y) * 256, (voxel_pos.z + height) * 256);
 
 	pt = &_corner_dxy[RotateCounterClockwise(this->orientation)];
-	rect.base.x = this->ComputeX((voxel_pos.x + pt->x) * 256, (voxel_pos.y + pt->y) * 256) - center_x;
+	rect.base.x = this->ComputeX((voxel_pos.x + pt->x) * 256, (voxel_pos.y + pt->y) * 256);
 
 	pt = &_corner_dxy[RotateClockwise(this->orientation)];
-	int32 d = this->ComputeX((voxel_pos.x + pt->x) * 256, (voxel_pos.y + pt->y) * 256) - center_x;
+	int32 d = this->ComputeX((voxel_pos.x + pt->x) * 256, (voxel_pos.y + pt->y) * 256);
 	assert(d >= rect.base.x);
 	rect.width = d - rect.base.x + 1;
 
 	pt = &_corner_dxy[RotateClockwise(RotateClockwise(this->orientation))];
-	d = this->ComputeY((voxel_pos.x + pt->x) * 256, (voxel_pos.y + pt->y) * 256, voxel_pos.z * 256) - center_y;
+	d = this->ComputeY((voxel_pos.x + pt->x) * 256, (voxel_pos.y + pt->y) * 256, voxel_pos.z * 256);
 	assert(d >= rect.base.y);
 	rect.height = d - rect.base.y + 1;
+	return rect;
+}
+
+/**
+ * Mark an area of the viewport as in need of getting painted.
+ * @param area Area to paint, in the coordinates of #ComputeX and #ComputeY.
+ */
+void Viewport::MarkAreaDirty(Rectangle32 area)
+{
+	area.base.x -= this->ComputeX(this->view_pos.x, this->view_pos.y) - this->rect.base.x - this->rect.width / 2;
+	area.base.y -= this->ComputeY(this->view_pos.x, this->view_pos.y, this->view_pos.z) - this->rect.base.y - this->rect.height / 2;
+	_video.MarkDisplayDirty(area);
+}
+
+/**
+ * Mark a voxel as in need of getting painted, after a change of the world in the voxel.
+ * @param voxel_pos Position of the voxel.
+ * @param height Number of voxels to mark above the specified coordinate (\c 0 means inspect the voxel itself).
+ */
+void Viewport::MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height)
+{
+	Rectangle32 rect = this->GetVoxelArea(voxel_pos, height);
+	this->static_layer->Invalidate(rect);
+	this->MarkAreaDirty(rect);
+}
+
+/**
+ * Mark the voxel of a voxel object as in need of getting painted. Unlike #MarkVoxelDirty, the world itself is not changed.
+ * @param voxel_pos Position of the voxel.
+ */
+void Viewport::MarkVoxelObjectDirty(const XYZPoint16 &voxel_pos)
+{
+	this->MarkAreaDirty(this->GetVoxelArea(voxel_pos, 0));
+}
 
-	_video.MarkDisplayDirty(rect);
+/** Mark the entire world as in need of getting painted, after a change in its appearance (for example the colours of a ride). */
+void Viewport::MarkWorldDirty()
+{
+	this->static_layer->Invalidate();
+	this->MarkDirty();
 }
 
 /**
@@ -1173,6 +1941,23 @@ void MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height)
 	if (vp != nullptr) vp->MarkVoxelDirty(voxel_pos, height);
 }
 
+/**
+ * Mark the voxel of a voxel object as in need of getting painted.
+ * @param voxel_pos Position of the voxel.
+ */
+void MarkVoxelObjectDirty(const XYZPoint16 &voxel_pos)
+{
+	Viewport *vp = _window_manager.GetViewport();
+	if (vp != nullptr) vp->MarkVoxelObjectDirty(voxel_pos);
+}
+
+/** Mark the entire world as in need of getting painted. */
+void MarkWorldDirty()
+{
+	Viewport *vp = _window_manager.GetViewport();
+	if (vp != nullptr) vp->MarkWorldDirty();
+}
+
 /**
  * Open the main isometric display window.
  * @param view_pos Pixel position of the center viewpoint of the main display.
@@ -14,6 +14,8 @@
 #include "mouse_mode.h"
 
 class Viewport;
+class DrawImages;
+class StaticLayer;
 class Person;
 class RideInstance;
 
@@ -74,6 +76,14 @@ enum GroundTilePart {
 	FW_EDGE,   ///< Find tile edge.
 };
 
+/** Sprites to collect for drawing a part of the viewport. */
+enum SpriteSelection {
+	SPS_STATIC  = 1 << 0, ///< Everything except the voxel objects.
+	SPS_OBJECTS = 1 << 1, ///< Voxel objects (persons, ride cars, etc).
+	SPS_ALL     = SPS_STATIC | SPS_OBJECTS, ///< All sprites.
+};
+DECLARE_ENUM_AS_BIT_SET(SpriteSelection)
+
 /** Data found by Viewport::ComputeCursorPosition. */
 class FinderData {
 public:
@@ -98,6 +108,8 @@ public:
 	~Viewport();
 
 	void MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height = 0);
+	void MarkVoxelObjectDirty(const XYZPoint16 &voxel_pos);
+	void MarkWorldDirty();
 	void OnDraw(MouseModeSelector *selector) override;
 
 	void Rotate(int direction);
@@ -122,11 +134,45 @@ public:
 	bool underground_mode;       ///< Whether underground mode is displayed in this viewport.
 
 private:
+	DrawImages *draw_images;     ///< Sprites collected for drawing, kept between frames to reuse the memory.
+	DrawImages *object_images;   ///< Voxel objects collected for drawing, kept between frames to reuse the memory.
+	GradientShift weather_shift; ///< Weather shading of the last drawn viewport.
+	StaticLayer *static_layer;   ///< Rendered static sprites of the viewport, voxel objects are drawn on top of it.
+	std::vector<Rectangle32> static_areas; ///< Out-of-date areas of the #static_layer being rendered.
+	std::vector<Rectangle32> object_areas; ///< Areas covered by voxel objects being drawn.
+
+	Rectangle32 GetVoxelArea(const XYZPoint16 &voxel_pos, int16 height);
+	void MarkAreaDirty(Rectangle32 area);
+	void CollectSprites(const ClippedRectangle &area, MouseModeSelector *selector, SpriteSelection selection, DrawImages *images);
+	void AddObjectSprites(const Rectangle32 &area);
+	void SortSprites();
+	void UpdateStaticLayer(GradientShift gs);
+
 	void OnMouseMoveEvent(const Point16 &pos) override;
 	WmMouseEvent OnMouseButtonEvent(uint8 state) override;
 	void OnMouseWheelEvent(int direction) override;
 };
 
+/**
+ * Sprites of a view of the world, collected and sorted like a viewport does, without drawing them.
+ * @ingroup viewport_group
+ */
+class ViewSprites {
+public:
+	ViewSprites();
+	~ViewSprites();
+
+	void Collect(const XYZPoint32 &view_pos, ViewOrientation orient, uint16 width, uint16 height, SpriteSelection selection);
+	void Sort();
+	uint Size() const;
+	uint32 GetOrderHash() const;
+
+private:
+	DrawImages *images; ///< Collected sprites, kept between collections to reuse the memory.
+};
+
 void MarkVoxelDirty(const XYZPoint16 &voxel_pos, int16 height = 0);
+void MarkVoxelObjectDirty(const XYZPoint16 &voxel_pos);
+void MarkWorldDirty();
 
 #endif
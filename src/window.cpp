@@ -28,6 +28,7 @@
 #include "ride_type.h"
 #include "viewport.h"
 #include "mouse_mode.h"
+#include "profiler.h"
 
 /**
  * %Window manager.
@@ -1073,24 +1074,33 @@ bool WindowManager::KeyEvent(WmKeyCode key_code, const uint8 *symbol)
 }
 
 /**
- * Redraw (parts of) the windows.
- * @todo [medium/difficult] Do this much less stupid.
+ * Redraw the out-of-date parts of the windows.
  * @ingroup window_group
  */
 void WindowManager::UpdateWindows()
 {
 	if (!_video.DisplayNeedsRepaint()) return;
 
-	/* Until the entire background is covered by the main display, clean the entire display to ensure deleted
-	 * windows truly disappear (even if there is no other window behind it).
-	 */
-	Rectangle32 rect(0, 0, _video.GetXSize(), _video.GetYSize());
-	_video.FillRectangle(rect, MakeRGBA(0, 0, 0, OPAQUE));
-
 	GuiWindow *sel_window = this->GetSelector();
 	MouseModeSelector *selector = (sel_window == nullptr) ? nullptr : sel_window->selector;
-	for (Window *w = this->bottom; w != nullptr; w = w->higher) w->OnDraw(selector);
 
+	ClippedRectangle cr = _video.GetClippedRectangle();
+	for (const Rectangle32 &area : _video.StartRepaint()) {
+		ClippedRectangle area_cr(cr);
+		area_cr.RestrictTo(area);
+		_video.SetClippedRectangle(area_cr);
+
+		/* Until the entire background is covered by the main display, clean the area to ensure deleted
+		 * windows truly disappear (even if there is no other window behind it).
+		 */
+		_video.FillRectangle(area, MakeRGBA(0, 0, 0, OPAQUE));
+		for (Window *w = this->bottom; w != nullptr; w = w->higher) {
+			if (w->rect.Intersects(area)) w->OnDraw(selector);
+		}
+	}
+	_video.SetClippedRectangle(cr);
+
+	ProfileTimer timer(PFP_FINISH_REPAINT);
 	_video.FinishRepaint();
 }
 
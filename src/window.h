@@ -54,6 +54,7 @@ enum WindowTypes {
 	WC_FINANCES,        ///< Finance management window.
 	WC_SETTING,         ///< Setting window.
 	WC_DROPDOWN,        ///< Dropdown window.
+	WC_PROFILER,        ///< Frame profiler window.
 
 	WC_NONE,            ///< Invalid window type.
 };
@@ -478,5 +479,6 @@ void ShowCoasterBuildGui(CoasterInstance *coaster);
 void ShowRideBuildGui(RideInstance *instance);
 void ShowErrorMessage(StringID strid);
 void ShowSettingGui();
+void ToggleProfilerGui();
 
 #endif
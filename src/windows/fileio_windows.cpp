@@ -92,3 +92,39 @@ bool PathIsDirectory(const char *path)
 	return (attr & FILE_ATTRIBUTE_DIRECTORY) != 0;
 }
 
+/**
+ * Map the contents of a file into memory for reading.
+ * @param fname Name of the file to map.
+ * @param size [out] Size of the file.
+ * @return Address of the mapped file, or \c nullptr if the file could not be mapped.
+ */
+const uint8 *MapFile(const char *fname, size_t *size)
+{
+	HANDLE file = CreateFile(fname, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+	LARGE_INTEGER file_size;
+	void *data = nullptr;
+	if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+		HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr) {
+			data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping); // The view stays valid after closing the handles.
+		}
+	}
+	CloseHandle(file);
+	if (data == nullptr) return nullptr;
+
+	*size = file_size.QuadPart;
+	return static_cast<const uint8 *>(data);
+}
+
+/**
+ * Release a file mapped with #MapFile.
+ * @param data Address of the mapped file.
+ * @param size Size of the file.
+ */
+void UnmapFile(const uint8 *data, size_t size)
+{
+	UnmapViewOfFile(data);
+}